@@ -19,19 +19,18 @@
  ***************************************************************************/
 
 #include "erroraggregator.h"
-#include "simulator.h"
-#include <QList>
+#include "simulatorcore.h"
 
 
 using namespace camun::simulator;
 
-void ErrorAggregator::aggregate(SSLSimError error, ErrorSource source) {
-    m_data[source].push_back(std::move(error));
+void ErrorAggregator::aggregate(const sslsim::SimulatorError &error, ErrorSource source) {
+    m_data[source].push_back(error);
 }
 
-QList<SSLSimError> ErrorAggregator::getAggregates(ErrorSource source) {
-    QList<SSLSimError>& ref = m_data[source];
-    QList<SSLSimError> out = ref;
-    ref.clear();
-    return out;
+void ErrorAggregator::takeAggregates(ErrorSource source, std::vector<sslsim::SimulatorError> &out) {
+    std::vector<sslsim::SimulatorError>& ref = m_data[source];
+    out.clear();
+    // keep the capacity of both lists for the next round
+    out.swap(ref);
 }
@@ -27,59 +27,45 @@
  * 
  */
 
-/// Includes (optional)
-// #include <QObject>
-// #include <QMap>    
-// #include "protobuf/sslsim.h"  
-
 /**
  * @class ErrorAggregator
  * @brief Aggregates the error based on the source they are from.
  * 
  * The goal of this class (.h file and .cpp file both together) is the following:
  * We define a class named ErrorAggregator which holds objects of the type map, where the key is the source from which the errors come and the value for a certain key is the list of all those errors.
- * Note: The only types of errors it does this for is of the type SSLSimError.
+ * Note: The only types of errors it does this for is of the type sslsim::SimulatorError.
  * This class also enables us to return and clear those errors whenever needed.
+ * It is a plain object without signals, the simulation objects report to it directly.
  */
 
 
-#include <QObject>
-#include <QMap>    
-#include "protobuf/sslsim.h"    
+#include <map>
+#include <vector>
+#include "protobuf/ssl_simulation_error.pb.h"
 
 namespace camun {
     namespace simulator {
 
         enum class ErrorSource;
-        class ErrorAggregator : public QObject {
-            Q_OBJECT
+        class ErrorAggregator {
         public:
-            /**
-            * @brief The constructor function.
-            */
-            ErrorAggregator(QObject* parent) : QObject(parent) {}
-        
-        // for slotting and signalling.
-        public slots:
          /**
          * @brief aggregates the errors
          * @param e stores the source of the error in this variable
-         * @param eror stores the list of errors in this variable
+         * @param eror stores the error in this variable
          */
-            void aggregate(SSLSimError eror, ErrorSource e);
+            void aggregate(const sslsim::SimulatorError &eror, ErrorSource e);
 
-        public:
             /**
-             * @brief Returns the errors of a particular source
+             * @brief Moves the errors of a particular source into a list
              * @param e stores the source of the error in this variable
-             * @return returns a list of all the errors from the source e
+             * @param out receives all the errors from the source e, replacing its content
              */
-            QList<SSLSimError> getAggregates(ErrorSource e);
+            void takeAggregates(ErrorSource e, std::vector<sslsim::SimulatorError> &out);
         private:
             /// @brief  a map to store the key as the error source and the list of errors as the value.
-            QMap<ErrorSource, QList<SSLSimError>> m_data;
+            std::map<ErrorSource, std::vector<sslsim::SimulatorError>> m_data;
         };
     }
 }
 #endif
-
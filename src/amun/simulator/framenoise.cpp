@@ -0,0 +1,47 @@
+/***************************************************************************
+ *   Copyright 2026 Kuruk contributors                                     *
+ *                                                                         *
+ *   This program is free software: you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation, either version 3 of the License, or     *
+ *   any later version.                                                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#include "framenoise.h"
+#include "core/counterrng.h"
+#include <algorithm>
+
+using namespace camun::simulator;
+
+FrameNoise::FrameNoise(CounterRNG *rng) :
+    m_rng(rng)
+{ }
+
+void FrameNoise::generate(std::size_t normals, std::size_t uniforms)
+{
+    generateNormals(normals);
+    generateUniforms(uniforms);
+}
+
+void FrameNoise::generateNormals(std::size_t count)
+{
+    // never refill with less than a few values, the buffer might have been empty
+    m_normals.resize(std::max<std::size_t>(count, 16));
+    m_rng->fillNormal(m_normals.data(), m_normals.size());
+    m_normalPos = 0;
+}
+
+void FrameNoise::generateUniforms(std::size_t count)
+{
+    m_uniforms.resize(std::max<std::size_t>(count, 16));
+    m_rng->fillUniform(m_uniforms.data(), m_uniforms.size());
+    m_uniformPos = 0;
+}
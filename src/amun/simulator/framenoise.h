@@ -0,0 +1,118 @@
+/***************************************************************************
+ *   Copyright 2026 Kuruk contributors                                     *
+ *                                                                         *
+ *   This program is free software: you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation, either version 3 of the License, or     *
+ *   any later version.                                                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#ifndef FRAMENOISE_H
+#define FRAMENOISE_H
+
+/**
+* @file framenoise.h
+* @brief Random numbers for one vision frame, generated in bulk.
+*/
+
+#include "core/vector.h"
+#include <cstddef>
+#include <vector>
+
+class CounterRNG;
+
+namespace camun {
+    namespace simulator {
+        class FrameNoise;
+    }
+}
+
+/**
+* @class camun::simulator::FrameNoise
+* @brief Buffer of the random numbers used while creating a vision frame
+* All standard normal and uniform values a frame may need are generated by a single
+* bulk call on the vision random stream. The detection code then only reads from the
+* buffers. Should a frame need more values than reserved, the buffer is refilled.
+*/
+class camun::simulator::FrameNoise
+{
+public:
+    /**
+    * @fn FrameNoise::FrameNoise(CounterRNG *rng)
+    * @brief Constructs an empty buffer
+    * @param rng Random stream the values are drawn from
+    */
+    explicit FrameNoise(CounterRNG *rng);
+
+    /**
+    * @fn void FrameNoise::generate(std::size_t normals, std::size_t uniforms)
+    * @brief Drops unused values and draws new ones for the next frame
+    * @param normals Number of standard normal values to generate
+    * @param uniforms Number of uniform values in [0, 1) to generate
+    */
+    void generate(std::size_t normals, std::size_t uniforms);
+
+    /**
+    * @fn float FrameNoise::normal(float sigma)
+    * @brief Takes the next value from a zero mean normal distribution
+    * @param sigma Standard deviation
+    * @return Normally distributed value
+    */
+    float normal(float sigma)
+    {
+        if (m_normalPos == m_normals.size()) {
+            generateNormals(m_normals.size());
+        }
+        return m_normals[m_normalPos++] * sigma;
+    }
+
+    /**
+    * @fn Vector FrameNoise::normalVector(float sigma)
+    * @brief Takes a vector with both components from a zero mean normal distribution
+    * @param sigma Standard deviation
+    * @return Normally distributed vector
+    */
+    Vector normalVector(float sigma)
+    {
+        const float x = normal(sigma);
+        return Vector(x, normal(sigma));
+    }
+
+    /**
+    * @fn float FrameNoise::uniform()
+    * @brief Takes the next value from a uniform distribution
+    * @return Uniformly distributed value in [0, 1)
+    */
+    float uniform()
+    {
+        if (m_uniformPos == m_uniforms.size()) {
+            generateUniforms(m_uniforms.size());
+        }
+        return m_uniforms[m_uniformPos++];
+    }
+
+private:
+    void generateNormals(std::size_t count);
+    void generateUniforms(std::size_t count);
+
+    /// @brief Stream all values are drawn from
+    CounterRNG *m_rng;
+
+    /// @brief standard normal values and the index of the next unused one
+    std::vector<float> m_normals;
+    std::size_t m_normalPos = 0;
+
+    /// @brief uniform values and the index of the next unused one
+    std::vector<float> m_uniforms;
+    std::size_t m_uniformPos = 0;
+};
+
+#endif // FRAMENOISE_H
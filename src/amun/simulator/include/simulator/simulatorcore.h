@@ -0,0 +1,491 @@
+/***************************************************************************
+ *   Copyright 2015 Michael Eischer, Philipp Nordhus                       *
+ *   Robotics Erlangen e.V.                                                *
+ *   http://www.robotics-erlangen.de/                                      *
+ *   info@robotics-erlangen.de                                             *
+ *                                                                         *
+ *   This program is free software: you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation, either version 3 of the License, or     *
+ *   any later version.                                                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+ #ifndef SIMULATORCORE_H
+ #define SIMULATORCORE_H
+
+ /**
+ * @file simulatorcore.h
+ * @brief Event loop free core of the SSL simulation environment.
+ */
+
+ #include "protobuf/command.pb.h"
+ #include "protobuf/robot.pb.h"
+ #include "protobuf/ssl_simulation_error.pb.h"
+ #include "protobuf/ssl_simulation_robot_control.pb.h"
+ #include <cstdint>
+ #include <deque>
+ #include <map>
+ #include <memory>
+ #include <string>
+ #include <tuple>
+ #include <unordered_map>
+ #include <utility>
+ #include <vector>
+
+ /**
+ * @def SIMULATOR_SCALE
+ * @brief Scaling factor for the physics simulation
+ * Higher values break the rolling friction of the ball
+ */
+ const float SIMULATOR_SCALE = 10.0f;
+
+ /**
+ * @def SUB_TIMESTEP
+ * @brief Time step size for physics simulation (in seconds)
+ * Defines the granularity of the physics simulation (200 Hz)
+ */
+ const float SUB_TIMESTEP = 1/200.f;
+
+ /**
+ * @def COLLISION_MARGIN
+ * @brief Safety margin used for collision detection (in meters)
+ */
+ const float COLLISION_MARGIN = 0.04f;
+
+ /**
+ * @def FOCAL_LENGTH
+ * @brief Focal length for the simulated cameras (in pixels)
+ */
+ const unsigned FOCAL_LENGTH = 390;
+
+ class SSL_DetectionFrame;
+
+ namespace camun {
+     namespace simulator {
+         class SimBall;
+         class SimRobot;
+         class SimulatorCore;
+         class ErrorAggregator;
+         class RobotShapes;
+         class WorldTemplate;
+         struct FieldLayout;
+         struct SimulatorData;
+
+         /// @brief Robot collision shapes by RobotShapes::key
+         typedef std::unordered_map<std::string, std::shared_ptr<const RobotShapes>> RobotShapeMap;
+
+         /**
+         * @enum CollisionGroup
+         * @brief Bullet collision filter groups of the simulated objects
+         * Uses bits above the bullet default filters, thus queries with the
+         * default filter group only hit objects that explicitly accept it.
+         */
+         enum CollisionGroup : short {
+             COLLISION_FIELD = 1 << 6,     /**< Static field planes, walls and goals */
+             COLLISION_BALL = 1 << 7,      /**< The ball */
+             COLLISION_ROBOT = 1 << 8,     /**< Robot bodies */
+             COLLISION_DRIBBLER = 1 << 9   /**< Dribbler bars */
+         };
+
+         /// @brief Groups the static field objects pair with, never with each other
+         const short COLLISION_FIELD_MASK = COLLISION_BALL | COLLISION_ROBOT;
+         /// @brief Groups the ball pairs with
+         const short COLLISION_BALL_MASK = COLLISION_FIELD | COLLISION_ROBOT | COLLISION_DRIBBLER;
+         /// @brief Groups a robot body pairs with
+         const short COLLISION_ROBOT_MASK = COLLISION_FIELD | COLLISION_BALL | COLLISION_ROBOT;
+         /// @brief Groups a dribbler pairs with, it only has to touch the ball
+         const short COLLISION_DRIBBLER_MASK = COLLISION_BALL;
+
+         /**
+         * @struct CollisionStats
+         * @brief Accumulated cost of the collision detection of the physics steps
+         */
+         struct CollisionStats {
+             int64_t steps = 0;            /**< Number of physics sub steps */
+             int64_t broadphaseTime = 0;   /**< AABB update and pair search (in nanoseconds) */
+             int64_t narrowphaseTime = 0;  /**< Contact generation for the pairs (in nanoseconds) */
+             int64_t pairs = 0;            /**< Sum of the overlapping pairs over all steps */
+             int64_t manifolds = 0;        /**< Sum of the contact manifolds over all steps */
+         };
+
+         /**
+         * @enum ErrorSource
+         * @brief Identifies the source of simulation errors
+         */
+         enum class ErrorSource {
+             BLUE,    /**< Error from blue team */
+             YELLOW,  /**< Error from yellow team */
+             CONFIG   /**< Error in simulator configuration */
+         };
+
+         /**
+         * @struct VisionOutput
+         * @brief One simulated vision frame, due at time
+         */
+         struct VisionOutput {
+             std::vector<std::string> packets;  /**< Serialized SSL_WrapperPacket per camera, empty if serializing failed */
+             std::string trueState;             /**< Serialized world::SimulatorState of the frame */
+             int64_t time = 0;                  /**< Simulator time at which the packets leave the vision system */
+         };
+
+         /**
+         * @struct SimulatorOutput
+         * @brief Everything the core produced since the last SimulatorCore::collectOutputs
+         * Reuse one instance for every collect, the containers keep their capacity.
+         */
+         struct SimulatorOutput {
+             std::vector<robot::RadioResponse> radioResponses;                    /**< Responses of the robots that got a command */
+             std::vector<VisionOutput> vision;                                    /**< Vision frames in creation order */
+             std::map<ErrorSource, std::vector<sslsim::SimulatorError>> errors;   /**< Errors by source, sources without errors have an empty list */
+         };
+     }
+ }
+
+ /**
+ * @class camun::simulator::SimulatorCore
+ * @brief Physics, robots, ball and vision of the SSL simulation without event loop
+ * The core only advances when step is called and never emits anything. Commands are
+ * pushed into it and all results are pulled by collectOutputs, thus it neither needs
+ * an application object nor a particular thread. One step of a core must not run
+ * concurrently with other calls on the same core.
+ */
+ class camun::simulator::SimulatorCore
+ {
+ public:
+     /**
+     * @typedef RobotMap
+     * @brief Map of robot IDs to robot instances and generation counters
+     * First int: Robot ID, Second int: Generation
+     */
+     typedef std::map<unsigned int, std::pair<SimRobot*, unsigned int>> RobotMap;
+
+     /**
+     * @fn SimulatorCore::SimulatorCore(const amun::SimulatorSetup &setup)
+     * @brief Constructs the simulation with the specified configuration, at time 0
+     * @param setup Initial simulator configuration
+     */
+     explicit SimulatorCore(const amun::SimulatorSetup &setup);
+
+     /**
+     * @fn SimulatorCore::SimulatorCore(const WorldTemplate &world)
+     * @brief Instantiates a world template, at time 0
+     * The field and robot shapes are shared with the template, only the bodies are created.
+     * Realism and noise start at their defaults like for a simulation built from a setup.
+     * @param world Template providing setup, teams and initial state
+     */
+     explicit SimulatorCore(const WorldTemplate &world);
+
+     /**
+     * @fn SimulatorCore::~SimulatorCore()
+     * @brief Destroys the simulation and cleans up all resources
+     */
+     ~SimulatorCore();
+     SimulatorCore(const SimulatorCore&) = delete;
+     SimulatorCore& operator=(const SimulatorCore&) = delete;
+
+     /**
+     * @fn void SimulatorCore::handleCommand(const amun::Command &command)
+     * @brief Applies setup, realism, teleport and team changes immediately
+     * Enabling the simulation is left to the caller, which owns the clock.
+     * @param command Command to process
+     */
+     void handleCommand(const amun::Command &command);
+
+     /**
+     * @fn void SimulatorCore::queueRadioCommands(const sslsim::RobotControl &control, bool isBlue, int64_t processingStart)
+     * @brief Queues robot control commands until the robots receive them
+     * @param control Robot control commands
+     * @param isBlue Whether the commands are for the blue team
+     * @param processingStart Time when command processing started, the commands are applied once the simulation passed it
+     */
+     void queueRadioCommands(const sslsim::RobotControl &control, bool isBlue, int64_t processingStart);
+
+     /**
+     * @fn void SimulatorCore::applyCommands()
+     * @brief Passes the queued radio commands received before the current time to the robots
+     * The radio responses of the robots are buffered for collectOutputs.
+     */
+     void applyCommands();
+
+     /**
+     * @fn void SimulatorCore::applyRobotCommand(bool isBlue, const sslsim::RobotCommand &command)
+     * @brief Passes a command to the robot with its id right away
+     * Skips the radio delay and the packet loss, no response is created.
+     * @param isBlue Whether the robot is in the blue team
+     * @param command Command for the robot, ignored if the robot does not exist
+     */
+     void applyRobotCommand(bool isBlue, const sslsim::RobotCommand &command);
+
+     /**
+     * @fn void SimulatorCore::step(int64_t dt)
+     * @brief Advances the simulation
+     * Creates a vision frame if the last one is at least 12.5 ms old.
+     * @param dt Time to simulate in nanoseconds
+     */
+     void step(int64_t dt);
+
+     /**
+     * @fn void SimulatorCore::collectOutputs(SimulatorOutput &output)
+     * @brief Moves all buffered responses, vision frames and errors into output
+     * The previous content of output is dropped, its memory is reused by the core.
+     * @param output Receives the outputs
+     */
+     void collectOutputs(SimulatorOutput &output);
+
+     /**
+     * @fn void SimulatorCore::clearVision()
+     * @brief Drops the vision frames that were not collected yet
+     */
+     void clearVision();
+
+     /**
+     * @fn void SimulatorCore::setVisionEnabled(bool enabled)
+     * @brief Enables the creation of vision frames in step, on by default
+     * Users reading the state directly from the bodies save the detection and serialization.
+     * @param enabled true to create vision frames
+     */
+     void setVisionEnabled(bool enabled) { m_visionEnabled = enabled; }
+
+     /**
+     * @fn SimRobot *SimulatorCore::robot(bool isBlue, unsigned int id) const
+     * @brief Returns the robot with the id, nullptr if there is none
+     * The robot is only valid until the next command removing robots or changing the teams.
+     */
+     SimRobot *robot(bool isBlue, unsigned int id) const;
+
+     /**
+     * @fn SimBall *SimulatorCore::ball() const
+     * @brief Returns the ball, it may be replaced during a step
+     */
+     SimBall *ball() const;
+
+     /**
+     * @fn int64_t SimulatorCore::time() const
+     * @brief Returns the current simulation time in nanoseconds
+     */
+     int64_t time() const { return m_time; }
+
+     /**
+     * @fn void SimulatorCore::setTime(int64_t time)
+     * @brief Jumps to a time without simulating the difference
+     * @param time New simulation time in nanoseconds
+     */
+     void setTime(int64_t time) { m_time = time; }
+
+     /**
+     * @fn void SimulatorCore::handleSimulatorTick(double timeStep)
+     * @brief Processes a single simulation tick
+     * Called by bullet before every sub step to apply commands and forces.
+     * @param timeStep Time in seconds to simulate
+     */
+     void handleSimulatorTick(double timeStep);
+
+     /**
+     * @fn void SimulatorCore::seedPRGN(uint32_t seed, uint32_t world)
+     * @brief Seeds the pseudo-random number generator
+     * Used to make simulation results reproducible with the same seed.
+     * Simulators sharing a seed get independent random streams by using different world indices.
+     * @param seed Seed value for the random number generator
+     * @param world Index of this simulator among simulators using the same seed
+     */
+     void seedPRGN(uint32_t seed, uint32_t world = 0);
+
+     /**
+     * @fn void SimulatorCore::applySetup(const amun::SimulatorSetup &setup)
+     * @brief Reconfigures field geometry, cameras and physics options in place
+     * Only the static field, the broadphase and the camera tables are rebuilt, robots, ball and the
+     * buffered vision frames are kept. Also applied for a simulator_setup in handleCommand.
+     * @param setup New simulator configuration
+     */
+     void applySetup(const amun::SimulatorSetup &setup);
+
+     /**
+     * @fn CollisionStats SimulatorCore::collisionStats() const
+     * @brief Returns the collision detection cost since the last reset
+     */
+     CollisionStats collisionStats() const;
+
+     /**
+     * @fn void SimulatorCore::resetCollisionStats()
+     * @brief Restarts the accumulation of collisionStats
+     */
+     void resetCollisionStats();
+
+     /**
+     * @fn void SimulatorCore::setFlipped(bool flipped)
+     * @brief Sets whether the field orientation is flipped
+     * @param flipped true if the field is flipped, false otherwise
+     */
+     void setFlipped(bool flipped);
+
+     /**
+     * @fn void SimulatorCore::safelyTeleportBall(const float x, const float y)
+     * @brief Teleports the ball while avoiding robot collisions
+     * Checks for possible collisions with robots at the target position
+     * and moves robots out of the way using teleportRobotToFreePosition.
+     * @param x Target x-coordinate for the ball
+     * @param y Target y-coordinate for the ball
+     */
+     void safelyTeleportBall(const float x, const float y);
+
+     /**
+     * @fn void SimulatorCore::restoreState(const world::SimulatorState &state)
+     * @brief Moves the ball and the listed robots to the given state immediately
+     * @param state State in simulator coordinates, robots which do not exist are ignored
+     */
+     void restoreState(const world::SimulatorState &state);
+
+ private:
+     /**
+     * @fn SimulatorCore::SimulatorCore(const amun::SimulatorSetup &setup, std::shared_ptr<const FieldLayout> field, const RobotShapeMap &robotShapes)
+     * @brief Constructs the simulation from prebuilt static shapes
+     * @param setup Initial simulator configuration
+     * @param field Obstacles of the field for the geometry of the setup
+     * @param robotShapes Robot shapes to reuse
+     */
+     SimulatorCore(const amun::SimulatorSetup &setup, std::shared_ptr<const FieldLayout> field, const RobotShapeMap &robotShapes);
+
+     /**
+     * @fn void SimulatorCore::resetFlipped(RobotMap &robots, float side)
+     * @brief Resets robot positions when the field is flipped
+     * @param robots Map of robots to reset
+     * @param side Side of the field the robots are on
+     */
+     void resetFlipped(RobotMap &robots, float side);
+
+     /**
+     * @fn VisionOutput SimulatorCore::createVisionPacket()
+     * @brief Creates vision detection and geometry packets for the current time
+     * @return Serialized packets and true state, due after the vision delay
+     */
+     VisionOutput createVisionPacket();
+
+     /**
+     * @fn void SimulatorCore::setTeam(RobotMap &list, float side, const robot::Team &team, std::map<uint32_t, robot::Specs>& specs)
+     * @brief Sets up a team of robots
+     * @param list Map to store the robots
+     * @param side Side of the field the team is on
+     * @param team Team configuration
+     * @param specs Map of robot specifications
+     */
+     void setTeam(RobotMap &list, float side, const robot::Team &team, std::map<uint32_t, robot::Specs>& specs);
+
+     /**
+     * @fn void SimulatorCore::moveBall(const sslsim::TeleportBall &ball)
+     * @brief Teleports the ball to a specified position
+     * @param ball Teleport command with target position and velocity
+     */
+     void moveBall(const sslsim::TeleportBall &ball);
+
+     /**
+     * @fn void SimulatorCore::moveRobot(const sslsim::TeleportRobot &robot)
+     * @brief Teleports a robot to a specified position
+     * @param robot Teleport command with target position and orientation
+     */
+     void moveRobot(const sslsim::TeleportRobot &robot);
+
+     /**
+     * @fn void SimulatorCore::teleportRobotToFreePosition(SimRobot *robot)
+     * @brief Teleports a robot to a position free of collisions
+     * @param robot Robot to teleport
+     */
+     void teleportRobotToFreePosition(SimRobot *robot);
+
+     /**
+     * @fn void SimulatorCore::initializeDetection(SSL_DetectionFrame *detection, std::size_t cameraId)
+     * @brief Initializes a detection frame with camera information
+     * @param detection Detection frame to initialize
+     * @param cameraId ID of the camera for this frame
+     */
+     void initializeDetection(SSL_DetectionFrame *detection, std::size_t cameraId);
+
+     /**
+     * @fn void SimulatorCore::setupCameras(const amun::SimulatorSetup &setup)
+     * @brief Replaces the reported camera calibrations and the camera positions
+     * @param setup Simulator configuration containing the camera setup
+     */
+     void setupCameras(const amun::SimulatorSetup &setup);
+
+     /**
+     * @fn void SimulatorCore::seedStreams(uint32_t seed, uint32_t world)
+     * @brief Derives the counter based random streams of this world
+     * @param seed Seed shared by all streams
+     * @param world Index of this simulator
+     */
+     void seedStreams(uint32_t seed, uint32_t world);
+
+     /**
+     * @fn void SimulatorCore::updateAnalyticBall()
+     * @brief Switches the ball between closed form rolling and physics simulation
+     * The analytic mode is only used while no robot is close to the remaining path of the ball.
+     */
+     void updateAnalyticBall();
+
+     /**
+     * @fn void SimulatorCore::replaceBroadphase(amun::SimulatorSetup::Broadphase type)
+     * @brief Moves all collision objects into a newly created broadphase
+     * Objects keep their filter groups, only cached contacts are dropped.
+     * @param type Broadphase to use from now on, sized for the current geometry and
+     * filtering pairs as the last setup asked for
+     */
+     void replaceBroadphase(amun::SimulatorSetup::Broadphase type);
+
+ private:
+     /// @brief Type definition for radio command queue entries
+     typedef std::tuple<sslsim::RobotControl, int64_t, bool> RadioCommand;
+
+     /// @brief Internal simulator data containing physics world and objects
+     SimulatorData *m_data;
+
+     /// @brief Queue of pending radio commands
+     std::deque<RadioCommand> m_radioCommands;
+
+     /// @brief Radio responses not collected yet
+     std::vector<robot::RadioResponse> m_radioResponses;
+
+     /// @brief Vision frames not collected yet
+     std::vector<VisionOutput> m_vision;
+
+     /// @brief Current simulation time
+     int64_t m_time;
+
+     /// @brief Time when the last vision frame was created
+     int64_t m_lastSentStatusTime;
+
+     /// @brief Whether step creates vision frames
+     bool m_visionEnabled = true;
+
+     /// @brief Whether robot kickers are allowed to charge
+     bool m_charge;
+
+     /// @brief Total vision delay (systemDelay + visionProcessingTime)
+     int64_t m_visionDelay;
+
+     /// @brief Vision processing time component of vision delay
+     int64_t m_visionProcessingTime;
+
+     /// @brief Minimum time between robot detections
+     int64_t m_minRobotDetectionTime = 0;
+
+     /// @brief Minimum time between ball detections
+     int64_t m_minBallDetectionTime = 0;
+
+     /// @brief Time when the ball was last sent in a vision packet
+     int64_t m_lastBallSendTime = 0;
+
+     /// @brief Map of frame numbers by camera ID
+     std::map<int64_t, unsigned> m_lastFrameNumber;
+
+     /// @brief Error aggregator for collecting and reporting errors
+     ErrorAggregator *m_aggregator;
+ };
+
+ #endif // SIMULATORCORE_H
@@ -0,0 +1,171 @@
+/***************************************************************************
+ *   Copyright 2026 Kuruk contributors                                     *
+ *                                                                         *
+ *   This program is free software: you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation, either version 3 of the License, or     *
+ *   any later version.                                                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+ #ifndef VECTORENV_H
+ #define VECTORENV_H
+
+ /**
+ * @file vectorenv.h
+ * @brief Batched stepping of independent simulations through flat float buffers.
+ */
+
+ #include "simulatorcore.h"
+ #include <cstdint>
+ #include <vector>
+
+ namespace camun {
+     namespace simulator {
+         class VectorEnv;
+     }
+ }
+
+ /**
+ * @class camun::simulator::VectorEnv
+ * @brief Runs several independent simulations in lock step for learning workloads
+ * Every environment is a SimulatorCore with two teams of robotsPerTeam robots and vision
+ * disabled. Robots are ordered blue 0 .. n-1, then yellow 0 .. n-1 in all buffers.
+ * Observations are read from the physics bodies in the coordinates of world::SimulatorState
+ * (meters, x along the field width, blue defends positive y):
+ * per environment the ball (x, y, z, v_x, v_y, v_z), then per robot (x, y, orientation, v_x, v_y, omega).
+ * The orientation is the forward direction of the robot, so an observation can be passed back to setState.
+ * Actions per robot are (v_forward, v_left, omega, kick speed, dribbler speed) in robot local
+ * coordinates, a kick speed of 0 does not kick, the dribbler speed is in rpm.
+ * An environment ends when the ball leaves the field or after episodeSteps steps and is reset
+ * within the same step call.
+ */
+ class camun::simulator::VectorEnv
+ {
+ public:
+     /// @brief Action values per robot
+     static const int ACTION_SIZE = 5;
+
+     /**
+     * @enum Done
+     * @brief Why an environment was reset at the end of a step
+     */
+     enum Done : uint8_t {
+         RUNNING = 0,      /**< Episode continues */
+         BALL_OUT = 1,     /**< The ball left the field */
+         TIME_LIMIT = 2    /**< The episode reached episodeSteps */
+     };
+
+     /**
+     * @struct Config
+     * @brief Setup shared by all environments
+     */
+     struct Config {
+         amun::SimulatorSetup setup;        /**< Field and physics options */
+         int robotsPerTeam = 6;             /**< Robots in each team */
+         int64_t stepTime = 10000000;       /**< Simulated time per step (in nanoseconds) */
+         int episodeSteps = 1000;           /**< Steps until an episode is truncated */
+         uint32_t seed = 1;                 /**< Seed of the simulator noise and the reset placements */
+     };
+
+     /**
+     * @fn VectorEnv::VectorEnv(int envs, const Config &config)
+     * @brief Creates and resets the environments
+     * @param envs Number of environments
+     * @param config Setup of every environment, environment i uses world index i of the seed
+     */
+     VectorEnv(int envs, const Config &config);
+
+     /**
+     * @fn VectorEnv::~VectorEnv()
+     * @brief Destroys all environments
+     */
+     ~VectorEnv();
+     VectorEnv(const VectorEnv&) = delete;
+     VectorEnv& operator=(const VectorEnv&) = delete;
+
+     /// @brief Number of environments
+     int envs() const { return int(m_cores.size()); }
+     /// @brief Robots per environment
+     int robots() const { return 2 * m_config.robotsPerTeam; }
+     /// @brief Action values per environment
+     int actionSize() const { return robots() * ACTION_SIZE; }
+     /// @brief Observation values per environment
+     int observationSize() const;
+
+     /**
+     * @fn void VectorEnv::reset(float *observations)
+     * @brief Starts a new episode in every environment
+     * @param observations Buffer for envs() * observationSize() values
+     */
+     void reset(float *observations);
+
+     /**
+     * @fn void VectorEnv::step(const float *actions, float *observations, uint8_t *dones, float *finalObservations)
+     * @brief Applies the actions and advances every environment by stepTime
+     * @param actions envs() * actionSize() values
+     * @param observations Receives envs() * observationSize() values, the first observation of the new episode for ended environments
+     * @param dones Receives envs() Done values
+     * @param finalObservations Optional, receives the last observation of the ended environments, other entries are left alone
+     */
+     void step(const float *actions, float *observations, uint8_t *dones, float *finalObservations = nullptr);
+
+     /**
+     * @fn void VectorEnv::observe(float *observations) const
+     * @brief Writes the current observation of every environment
+     * @param observations Buffer for envs() * observationSize() values
+     */
+     void observe(float *observations) const;
+
+     /**
+     * @fn void VectorEnv::setState(int env, const float *observation)
+     * @brief Places ball and robots of an environment as given by an observation, the episode continues
+     * @param env Index of the environment
+     * @param observation observationSize() values, in the layout written by observe
+     */
+     void setState(int env, const float *observation);
+
+ private:
+     /**
+     * @fn void VectorEnv::resetEnv(int env)
+     * @brief Places robots and ball at random start positions of the next episode
+     * @param env Index of the environment
+     */
+     void resetEnv(int env);
+
+     /**
+     * @fn void VectorEnv::observe(int env, float *observation) const
+     * @brief Writes the observation of an environment
+     * @param env Index of the environment
+     * @param observation Buffer for observationSize() values
+     */
+     void observe(int env, float *observation) const;
+
+ private:
+     /// @brief Setup of all environments
+     Config m_config;
+
+     /// @brief One simulation per environment
+     std::vector<SimulatorCore*> m_cores;
+
+     /// @brief Steps of the running episode per environment
+     std::vector<int> m_steps;
+
+     /// @brief Started episodes per environment, selects the random reset placement
+     std::vector<uint32_t> m_episodes;
+
+     /// @brief Reused for the commands of all robots
+     sslsim::RobotCommand m_command;
+
+     /// @brief Reused to drain the errors of the simulations
+     SimulatorOutput m_output;
+ };
+
+ #endif // VECTORENV_H
@@ -0,0 +1,82 @@
+/***************************************************************************
+ *   Copyright 2026 Kuruk contributors                                     *
+ *                                                                         *
+ *   This program is free software: you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation, either version 3 of the License, or     *
+ *   any later version.                                                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+ #ifndef WORLDTEMPLATE_H
+ #define WORLDTEMPLATE_H
+
+ /**
+ * @file worldtemplate.h
+ * @brief Prebuilt static part of a simulation, instantiated cheaply for many scenarios.
+ */
+
+ #include "simulatorcore.h"
+ #include <memory>
+
+ namespace camun {
+     namespace simulator {
+         class WorldTemplate;
+     }
+ }
+
+ /**
+ * @class camun::simulator::WorldTemplate
+ * @brief Setup, teams and collision shapes shared by the simulations of a batch of scenarios
+ * Building the field obstacles and the robot meshes happens once in the constructor.
+ * SimulatorCore(const WorldTemplate&) then only creates the rigid bodies and copies the
+ * initial state. The template is immutable, thus it may be instantiated from several
+ * threads at once, and it may be destroyed while its instances are still running.
+ */
+ class camun::simulator::WorldTemplate
+ {
+ public:
+     /**
+     * @fn WorldTemplate::WorldTemplate(const amun::SimulatorSetup &setup, const robot::Team &blue, const robot::Team &yellow, const world::SimulatorState *initialState = nullptr)
+     * @brief Builds the static shapes for a setup and the robots of both teams
+     * @param setup Simulator configuration, e.g. loaded with loadConfiguration
+     * @param blue Robots of the blue team
+     * @param yellow Robots of the yellow team
+     * @param initialState Optional state every instance starts from, otherwise the robots line up like after a team change
+     */
+     WorldTemplate(const amun::SimulatorSetup &setup, const robot::Team &blue, const robot::Team &yellow,
+                   const world::SimulatorState *initialState = nullptr);
+     WorldTemplate(const WorldTemplate&) = delete;
+     WorldTemplate& operator=(const WorldTemplate&) = delete;
+
+     /// @brief Simulator configuration of the instances
+     const amun::SimulatorSetup &setup() const { return m_setup; }
+     /// @brief Robots of a team
+     const robot::Team &team(bool isBlue) const { return isBlue ? m_blue : m_yellow; }
+     /// @brief Whether the instances start from initialState
+     bool hasInitialState() const { return m_hasInitialState; }
+     /// @brief State of ball and robots after instantiation
+     const world::SimulatorState &initialState() const { return m_initialState; }
+     /// @brief Field obstacles shared by all instances
+     std::shared_ptr<const FieldLayout> field() const { return m_field; }
+     /// @brief Robot shapes shared by all instances
+     const RobotShapeMap &robotShapes() const { return m_robotShapes; }
+
+ private:
+     amun::SimulatorSetup m_setup;
+     robot::Team m_blue;
+     robot::Team m_yellow;
+     bool m_hasInitialState;
+     world::SimulatorState m_initialState;
+     std::shared_ptr<const FieldLayout> m_field;
+     RobotShapeMap m_robotShapes;
+ };
+
+ #endif // WORLDTEMPLATE_H
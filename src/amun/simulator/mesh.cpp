@@ -44,25 +44,25 @@ Mesh::Mesh(float radius, float height, float angle, float holeSize, float boxHei
 
     //right pillar
     addRobotCover(5, outerAngleStart - angleDiff, outerAngleStart);
-    m_hull.back().append(QVector3D(-frontPlateLength, holePlatePos,  m_height / 2.0f));
-    m_hull.back().append(QVector3D(-frontPlateLength, holePlatePos, -m_height / 2.0f));
+    m_hull.back().push_back(btVector3(-frontPlateLength, holePlatePos,  m_height / 2.0f));
+    m_hull.back().push_back(btVector3(-frontPlateLength, holePlatePos, -m_height / 2.0f));
 
     //left pillar
     addRobotCover(5, outerAngleStop, outerAngleStop + angleDiff);
-    m_hull.back().append(QVector3D(frontPlateLength, holePlatePos,  m_height / 2.0f));
-    m_hull.back().append(QVector3D(frontPlateLength, holePlatePos, -m_height / 2.0f));
+    m_hull.back().push_back(btVector3(frontPlateLength, holePlatePos,  m_height / 2.0f));
+    m_hull.back().push_back(btVector3(frontPlateLength, holePlatePos, -m_height / 2.0f));
 
     //the remaining box
-    QList<QVector3D> boxPart;
-    boxPart.append(QVector3D(frontPlateLength, holePlatePos,  m_height / 2.0f));
-    boxPart.append(QVector3D(-frontPlateLength, holePlatePos,  m_height / 2.0f));
-    boxPart.append(QVector3D(frontPlateLength, holePlatePos,  -m_height / 2.0f + boxHeight));
-    boxPart.append(QVector3D(-frontPlateLength, holePlatePos,  -m_height / 2.0f + boxHeight));
-    boxPart.append(QVector3D(frontPlateLength, frontPlatePos,  m_height / 2.0f));
-    boxPart.append(QVector3D(-frontPlateLength, frontPlatePos,  m_height / 2.0f));
-    boxPart.append(QVector3D(frontPlateLength, frontPlatePos,  -m_height / 2.0f + boxHeight));
-    boxPart.append(QVector3D(-frontPlateLength, frontPlatePos,  -m_height / 2.0f + boxHeight));
-    m_hull.append(boxPart);
+    std::vector<btVector3> boxPart;
+    boxPart.push_back(btVector3(frontPlateLength, holePlatePos,  m_height / 2.0f));
+    boxPart.push_back(btVector3(-frontPlateLength, holePlatePos,  m_height / 2.0f));
+    boxPart.push_back(btVector3(frontPlateLength, holePlatePos,  -m_height / 2.0f + boxHeight));
+    boxPart.push_back(btVector3(-frontPlateLength, holePlatePos,  -m_height / 2.0f + boxHeight));
+    boxPart.push_back(btVector3(frontPlateLength, frontPlatePos,  m_height / 2.0f));
+    boxPart.push_back(btVector3(-frontPlateLength, frontPlatePos,  m_height / 2.0f));
+    boxPart.push_back(btVector3(frontPlateLength, frontPlatePos,  -m_height / 2.0f + boxHeight));
+    boxPart.push_back(btVector3(-frontPlateLength, frontPlatePos,  -m_height / 2.0f + boxHeight));
+    m_hull.push_back(boxPart);
 }
 
 
@@ -74,16 +74,16 @@ Mesh::Mesh(float radius, float height, float angle, float holeSize, float boxHei
  * \param angle Angle of the hull start
  * \param angleStep Step size in rad
  */
-void Mesh::addRobotCover(uint num, float startAngle, float endAngle)
+void Mesh::addRobotCover(unsigned int num, float startAngle, float endAngle)
 {
-    QList<QVector3D> covers;
+    std::vector<btVector3> covers;
     float angle = startAngle;
     float angleStep = (endAngle - startAngle) / num;
-    for (uint i = 0; i <= num; i++) {
-        covers.append(QVector3D(m_radius * cos(angle), m_radius * sin(angle),  m_height / 2.0f));
-        covers.append(QVector3D(m_radius * cos(angle), m_radius * sin(angle), -m_height / 2.0f));
+    for (unsigned int i = 0; i <= num; i++) {
+        covers.push_back(btVector3(m_radius * cos(angle), m_radius * sin(angle),  m_height / 2.0f));
+        covers.push_back(btVector3(m_radius * cos(angle), m_radius * sin(angle), -m_height / 2.0f));
 
         angle += angleStep;
     }
-    m_hull.append(covers);
+    m_hull.push_back(covers);
 }
@@ -27,10 +27,8 @@
  */
 
 /// Includes (optional)
-// #include <QMap>
-// #include <QVector>
-// #include <QVector3D>
-// #include <QString>
+// #include <btBulletDynamicsCommon.h>
+// #include <vector>
 
 /**
  * @class Mesh
@@ -39,10 +37,8 @@
  * This class creates a 3D-Model(meshes) that are used for the bots.
  */
 
-#include <QMap>
-#include <QVector>
-#include <QVector3D>
-#include <QString>
+#include <btBulletDynamicsCommon.h>
+#include <vector>
 
 namespace camun {
     namespace simulator {
@@ -74,7 +70,7 @@ public:
     /**
      * @brief Has a List of all parts or components of the robot body which have in them a collection of points(another list).
      */
-    const QList<QList<QVector3D>> &hull() const { return m_hull; }
+    const std::vector<std::vector<btVector3>> &hull() const { return m_hull; }
 
 private:
     /**
@@ -83,18 +79,18 @@ private:
      * @param startAngle As the name suggests it is the start angle from which the mesh is defined.
      * @param endAngle It is the endangle of the mesh definition.
      */
-    void addRobotCover(uint num, float startAngle, float endAngle);
+    void addRobotCover(unsigned int num, float startAngle, float endAngle);
     /**
      * @brief Defines the sides of the bot. In the same procedure as above function(addRobotCover)
      * @param right It is the boolean that stores whether it is the left or the right side.
      */
-    void addSidePart(uint num, float angleStart, float angleStop, bool right);
+    void addSidePart(unsigned int num, float angleStart, float angleStop, bool right);
 
 private:
 
 
     /// @brief A list to store the components which are defined by a list of points.
-    QList<QList<QVector3D>> m_hull;
+    std::vector<std::vector<btVector3>> m_hull;
     /// @brief The radius of the robot body
     const float m_radius;
     /// @brief The height of the robot body
@@ -0,0 +1,70 @@
+/***************************************************************************
+ *   Copyright 2026 Kuruk contributors                                     *
+ *                                                                         *
+ *   This program is free software: you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation, either version 3 of the License, or     *
+ *   any later version.                                                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#include "robotpool.h"
+#include "erroraggregator.h"
+#include "simrobot.h"
+
+using namespace camun::simulator;
+
+RobotPool::RobotPool(btDiscreteDynamicsWorld *world, ErrorAggregator *aggregator, const RobotShapeMap &shapes) :
+    m_world(world),
+    m_aggregator(aggregator),
+    m_shapes(shapes)
+{ }
+
+RobotPool::~RobotPool()
+{
+    for (const auto &entry : m_free) {
+        for (SimRobot *robot : entry.second) {
+            delete robot;
+        }
+    }
+}
+
+SimRobot *RobotPool::acquire(const robot::Specs &specs, const btVector3 &pos, float dir)
+{
+    auto it = m_free.find(specs.SerializeAsString());
+    if (it == m_free.end() || it->second.empty()) {
+        std::shared_ptr<const RobotShapes> &shapes = m_shapes[RobotShapes::key(specs)];
+        if (!shapes) {
+            shapes = std::make_shared<const RobotShapes>(specs);
+        }
+        return new SimRobot(specs, shapes, m_world, m_aggregator, pos, dir);
+    }
+
+    SimRobot *robot = it->second.back();
+    it->second.pop_back();
+    robot->reset(pos, dir);
+    robot->addToWorld();
+    return robot;
+}
+
+void RobotPool::release(SimRobot *robot)
+{
+    robot->removeFromWorld();
+    m_free[robot->specs().SerializeAsString()].push_back(robot);
+}
+
+std::size_t RobotPool::size() const
+{
+    std::size_t count = 0;
+    for (const auto &entry : m_free) {
+        count += entry.second.size();
+    }
+    return count;
+}
@@ -0,0 +1,113 @@
+/***************************************************************************
+ *   Copyright 2026 Kuruk contributors                                     *
+ *                                                                         *
+ *   This program is free software: you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation, either version 3 of the License, or     *
+ *   any later version.                                                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#ifndef ROBOTPOOL_H
+#define ROBOTPOOL_H
+
+/**
+* @file robotpool.h
+* @brief Keeps simulated robots alive for reuse after they leave the field.
+*/
+
+#include "simulatorcore.h"
+#include <btBulletDynamicsCommon.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace robot {
+    class Specs;
+}
+
+namespace camun {
+    namespace simulator {
+        class ErrorAggregator;
+        class RobotPool;
+        class SimRobot;
+    }
+}
+
+/**
+* @class camun::simulator::RobotPool
+* @brief Pool of pre-built robot bodies, grouped by robot specs
+* Building a SimRobot allocates its collision shapes, rigid bodies
+* and constraints. Released robots are only removed from the physics world
+* and handed out again for the same specs, so team changes and readding robots
+* just reset the state of an existing robot. The collision shapes are built once
+* per robot dimensions and shared by all robots using them.
+*/
+class camun::simulator::RobotPool
+{
+public:
+    /**
+    * @fn RobotPool::RobotPool(btDiscreteDynamicsWorld *world, ErrorAggregator *aggregator, const RobotShapeMap &shapes)
+    * @brief Constructs an empty pool
+    * @param world Bullet physics world the robots are added to
+    * @param aggregator Receives the errors of all created robots
+    * @param shapes Prebuilt shapes to use instead of building them again
+    */
+    RobotPool(btDiscreteDynamicsWorld *world, ErrorAggregator *aggregator, const RobotShapeMap &shapes = RobotShapeMap());
+
+    /**
+    * @fn RobotPool::~RobotPool()
+    * @brief Deletes all robots which are currently in the pool
+    * Robots handed out by acquire have to be released or deleted by their owner.
+    */
+    ~RobotPool();
+
+    RobotPool(const RobotPool&) = delete;
+    RobotPool& operator=(const RobotPool&) = delete;
+
+    /**
+    * @fn SimRobot *RobotPool::acquire(const robot::Specs &specs, const btVector3 &pos, float dir)
+    * @brief Returns a robot with the given specs placed in the physics world
+    * @param specs Robot specifications
+    * @param pos Initial position of the robot
+    * @param dir Initial orientation of the robot (radians)
+    * @return Robot owned by the caller until it is released
+    */
+    SimRobot *acquire(const robot::Specs &specs, const btVector3 &pos, float dir);
+
+    /**
+    * @fn void RobotPool::release(SimRobot *robot)
+    * @brief Removes the robot from the physics world and keeps it for reuse
+    * @param robot Robot previously returned by acquire
+    */
+    void release(SimRobot *robot);
+
+    /**
+    * @fn std::size_t RobotPool::size() const
+    * @brief Gets the number of robots waiting for reuse
+    * @return Number of pooled robots
+    */
+    std::size_t size() const;
+
+private:
+    /// @brief Bullet physics world in which the robots exist
+    btDiscreteDynamicsWorld *m_world;
+
+    /// @brief Receives the errors of all created robots
+    ErrorAggregator *m_aggregator;
+
+    /// @brief Shapes of all robot dimensions seen so far
+    RobotShapeMap m_shapes;
+
+    /// @brief Released robots, keyed by their serialized specs
+    std::unordered_map<std::string, std::vector<SimRobot*>> m_free;
+};
+
+#endif // ROBOTPOOL_H
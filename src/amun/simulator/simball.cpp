@@ -19,19 +19,21 @@
  ***************************************************************************/
 
 #include "simball.h"
-#include "simulator.h"
-#include "core/rng.h"
+#include "erroraggregator.h"
+#include "simulatorcore.h"
 #include "core/coordinates.h"
 #include "core/vector.h"
+#include "framenoise.h"
 #include "protobuf/ssl_detection.pb.h"
+#include <algorithm>
 #include <cmath>
 #include <QDebug>
 
 using namespace camun::simulator;
 
-SimBall::SimBall(RNG *rng, btDiscreteDynamicsWorld *world) :
-    m_rng(rng),
-    m_world(world)
+SimBall::SimBall(btDiscreteDynamicsWorld *world, ErrorAggregator *aggregator) :
+    m_world(world),
+    m_aggregator(aggregator)
 {
     // see http://robocup.mi.fu-berlin.de/buch/rolling.pdf for correct modelling
     m_sphere = new btSphereShape(BALL_RADIUS * SIMULATOR_SCALE);
@@ -56,7 +58,7 @@ SimBall::SimBall(RNG *rng, btDiscreteDynamicsWorld *world) :
     // \mu_r = -a / g = 0.0357 (while rolling)
     // rollingFriction in bullet is too unstable to be useful
     // use custom implementation in begin()
-    m_world->addRigidBody(m_body);
+    m_world->addRigidBody(m_body, COLLISION_BALL, COLLISION_BALL_MASK);
 }
 
 SimBall::~SimBall()
@@ -67,8 +69,22 @@ SimBall::~SimBall()
     delete m_motionState;
 }
 
+static bool hasMoveCommand(const sslsim::TeleportBall &move)
+{
+    return move.has_x() || move.has_y() || move.has_z() || move.has_vx() || move.has_vy() || move.has_vz();
+}
+
 void SimBall::begin()
 {
+    if (m_analytic.active) {
+        if (!hasMoveCommand(m_move)) {
+            advanceAnalytic(SUB_TIMESTEP);
+            return;
+        }
+        // teleporting is handled by bullet
+        stopAnalytic();
+    }
+
     // custom implementation of rolling friction
     const btVector3 p = m_body->getWorldTransform().getOrigin();
     if (p.z() < BALL_RADIUS * 1.1 * SIMULATOR_SCALE) { // ball is on the ground
@@ -92,11 +108,11 @@ void SimBall::begin()
 
     bool moveCommand = false;
     auto sendPartialCoordError = [this](const char* msg){
-        SSLSimError error{new sslsim::SimulatorError};
-        error->set_code("PARTIAL_COORD");
+        sslsim::SimulatorError error;
+        error.set_code("PARTIAL_COORD");
         std::string message = "Partial coordinates are not implemented yet";
-        error->set_message(message + msg);
-        emit this->sendSSLSimError(error, ErrorSource::CONFIG);
+        error.set_message(message + msg);
+        m_aggregator->aggregate(error, ErrorSource::CONFIG);
     };
     if (m_move.has_x()) {
         if (!m_move.has_y()) {
@@ -115,10 +131,10 @@ void SimBall::begin()
             return;
         }
         if (m_move.by_force() && (m_move.vx() != 0 || m_move.vy() != 0 || (m_move.has_vz() && m_move.vz() != 0))) {
-            SSLSimError error{new sslsim::SimulatorError};
-            error->set_code("VELOCITY_FORCE");
-            error->set_message("Velocities != 0 and by_force are incompatible");
-            emit sendSSLSimError(error, ErrorSource::CONFIG);
+            sslsim::SimulatorError error;
+            error.set_code("VELOCITY_FORCE");
+            error.set_message("Velocities != 0 and by_force are incompatible");
+            m_aggregator->aggregate(error, ErrorSource::CONFIG);
             return;
         }
         moveCommand = true;
@@ -209,6 +225,9 @@ static float positionOfVisiblePixels(btVector3& p, const btVector3& simulatorBal
             btVector3 samplePoint = simulatorBallPosition + offset;
 
             btCollisionWorld::ClosestRayResultCallback sampleResult(samplePoint, simulatorCameraPosition);
+            // the ray starts inside the ball, only other objects can occlude it
+            sampleResult.m_collisionFilterGroup = COLLISION_BALL;
+            sampleResult.m_collisionFilterMask = COLLISION_BALL_MASK;
             m_world->rayTest(samplePoint, simulatorCameraPosition, sampleResult);
 
             if (!sampleResult.hasHit()) {
@@ -233,17 +252,17 @@ static float positionOfVisiblePixels(btVector3& p, const btVector3& simulatorBal
     return static_cast<float>(cameraHitCounter) / static_cast<float>(maxHits);
 }
 
-bool SimBall::update(SSL_DetectionBall *ball, float stddev, float stddevArea, const btVector3& cameraPosition,
+bool SimBall::update(SSL_DetectionBall *ball, FrameNoise &noise, float stddev, float stddevArea, const btVector3& cameraPosition,
                      bool enableInvisibleBall, float visibilityThreshold, btVector3 positionOffset)
 {
     btTransform transform;
     m_motionState->getWorldTransform(transform);
     btVector3 pos = transform.getOrigin() / SIMULATOR_SCALE;
 
-    return addDetection(ball, pos, stddev, stddevArea, cameraPosition, enableInvisibleBall, visibilityThreshold, positionOffset);
+    return addDetection(ball, noise, pos, stddev, stddevArea, cameraPosition, enableInvisibleBall, visibilityThreshold, positionOffset);
 }
 
-bool SimBall::addDetection(SSL_DetectionBall *ball, btVector3 pos, float stddev, float stddevArea, const btVector3& cameraPosition,
+bool SimBall::addDetection(SSL_DetectionBall *ball, FrameNoise &noise, btVector3 pos, float stddev, float stddevArea, const btVector3& cameraPosition,
                             bool enableInvisibleBall, float visibilityThreshold, btVector3 positionOffset)
 {
     // setup ssl-vision ball detection
@@ -279,7 +298,7 @@ bool SimBall::addDetection(SSL_DetectionBall *ball, btVector3 pos, float stddev,
         (cameraPosition.x()-pos.x())*(cameraPosition.x()-pos.x())+(cameraPosition.y()-pos.y())*(cameraPosition.y()-pos.y()));
     float denomSqrt = (distBallCam*1000)/FOCAL_LENGTH - 1;
     float basePixelArea = (BALL_RADIUS*BALL_RADIUS*1000000*M_PI) / (denomSqrt*denomSqrt);
-    float area = visibility * std::max(0.0f, (basePixelArea + static_cast<float>(m_rng->normal(stddevArea)) / PIXEL_PER_AREA));
+    float area = visibility * std::max(0.0f, (basePixelArea + noise.normal(stddevArea) / PIXEL_PER_AREA));
     ball->set_area(area * PIXEL_PER_AREA);
 
     // if (height > 0.1f) {
@@ -288,8 +307,8 @@ bool SimBall::addDetection(SSL_DetectionBall *ball, btVector3 pos, float stddev,
 
     // add noise to coordinates
     // to convert from bullet coordinate system to ssl-vision rotate by 90 degree ccw
-    const Vector noise = m_rng->normalVector(stddev);
-    const Vector totalPosition = Vector(modX, modY) + noise + Vector(positionOffset.x(), positionOffset.y());
+    const Vector positionNoise = noise.normalVector(stddev);
+    const Vector totalPosition = Vector(modX, modY) + positionNoise + Vector(positionOffset.x(), positionOffset.y());
     coordinates::toVision(totalPosition, *ball);
     return true;
 }
@@ -327,8 +346,21 @@ void SimBall::writeBallState(world::SimBall *ball) const
     ball->set_angular_z(angularVelocity.z());
 }
 
+void SimBall::writeState(float *state) const
+{
+    const btVector3 position = m_body->getWorldTransform().getOrigin() / SIMULATOR_SCALE;
+    const btVector3 velocity = m_body->getLinearVelocity() / SIMULATOR_SCALE;
+    state[0] = position.x();
+    state[1] = position.y();
+    state[2] = position.z();
+    state[3] = velocity.x();
+    state[4] = velocity.y();
+    state[5] = velocity.z();
+}
+
 void SimBall::restoreState(const world::SimBall &ball)
 {
+    stopAnalytic();
     btVector3 position(ball.p_x(), ball.p_y(), ball.p_z());
     m_body->getWorldTransform().setOrigin(position * SIMULATOR_SCALE);
     btVector3 velocity(ball.v_x(), ball.v_y(), ball.v_z());
@@ -352,6 +384,7 @@ bool SimBall::isInvalid() const
 
 void SimBall::kick(const btVector3 &power)
 {
+    stopAnalytic();
     m_body->activate();
     m_body->applyCentralForce(power);
 
@@ -360,3 +393,182 @@ void SimBall::kick(const btVector3 &power)
     // const btVector3 p = transform.getOrigin() / SIMULATOR_SCALE;
     // qDebug() << "kick at" << p.x() << p.y();
 }
+
+// only hits static field objects, robots move and are checked by the simulator
+struct StaticSweepCallback : public btCollisionWorld::ClosestConvexResultCallback
+{
+    StaticSweepCallback(const btCollisionObject *self, const btVector3 &from, const btVector3 &to) :
+        btCollisionWorld::ClosestConvexResultCallback(from, to),
+        m_self(self)
+    {
+        m_collisionFilterGroup = COLLISION_BALL;
+        m_collisionFilterMask = COLLISION_FIELD;
+    }
+
+    bool needsCollision(btBroadphaseProxy *proxy) const override
+    {
+        const btCollisionObject *object = static_cast<const btCollisionObject *>(proxy->m_clientObject);
+        return object != m_self && object->isStaticObject() && !object->isKinematicObject()
+                && btCollisionWorld::ClosestConvexResultCallback::needsCollision(proxy);
+    }
+
+    const btCollisionObject *m_self;
+};
+
+// remaining distance until the ball stops, following the straight two phase model
+static float stopDistance(float speed, float switchSpeed, bool sliding)
+{
+    float distance = 0;
+    if (sliding) {
+        distance += (speed * speed - switchSpeed * switchSpeed) / (2 * BALL_ACC_SLIDE);
+        speed = switchSpeed;
+    }
+    return distance + speed * speed / (2 * BALL_ACC_ROLL);
+}
+
+// a sliding ball spins up linearly until its contact point stops moving and it starts rolling
+static btVector3 analyticAngularVelocity(const btVector3 &direction, float speed, float switchSpeed, bool sliding)
+{
+    const float rollingSpeed = sliding ? (switchSpeed - BALL_K_SWITCH * speed) / (1 - BALL_K_SWITCH) : speed;
+    return btVector3(0, 0, 1).cross(direction) * (rollingSpeed / BALL_RADIUS);
+}
+
+bool SimBall::isFreeRolling() const
+{
+    if (m_analytic.active || hasMoveCommand(m_move) || m_body->getNumConstraintRefs() > 0) {
+        return false;
+    }
+    const btVector3 p = m_body->getWorldTransform().getOrigin() / SIMULATOR_SCALE;
+    const btVector3 velocity = m_body->getLinearVelocity() / SIMULATOR_SCALE;
+    const bool onGround = p.z() < BALL_RADIUS * 1.1f && std::abs(velocity.z()) < 0.01f;
+    return onGround && btVector3(velocity.x(), velocity.y(), 0).length() > 0.05f;
+}
+
+bool SimBall::isSliding() const
+{
+    const btVector3 velocity = m_body->getLinearVelocity() / SIMULATOR_SCALE;
+    const btVector3 contactVelocity = velocity + m_body->getAngularVelocity().cross(btVector3(0, 0, -BALL_RADIUS));
+    return contactVelocity.length() > 0.1f * velocity.length();
+}
+
+SimBall::AnalyticState SimBall::initialAnalyticState() const
+{
+    AnalyticState state;
+    const btVector3 p = m_body->getWorldTransform().getOrigin() / SIMULATOR_SCALE;
+    const btVector3 velocity = m_body->getLinearVelocity() / SIMULATOR_SCALE;
+    const btVector3 groundVelocity(velocity.x(), velocity.y(), 0);
+    state.start = btVector3(p.x(), p.y(), BALL_RADIUS);
+    state.speed = groundVelocity.length();
+    state.direction = state.speed > 0 ? groundVelocity / state.speed : btVector3(1, 0, 0);
+    state.sliding = isSliding();
+    state.switchSpeed = state.sliding ? BALL_K_SWITCH * state.speed : 0;
+    return state;
+}
+
+btVector3 SimBall::rollingStopPosition() const
+{
+    const AnalyticState state = m_analytic.active ? m_analytic : initialAnalyticState();
+    float distance = state.travelled + stopDistance(state.speed, state.switchSpeed, state.sliding);
+    if (state.active) {
+        distance = std::min(distance, state.freeDistance);
+    }
+    const btVector3 stop = state.start + state.direction * distance;
+    return btVector3(stop.x(), stop.y(), 0) * SIMULATOR_SCALE;
+}
+
+bool SimBall::startAnalytic()
+{
+    if (!isFreeRolling()) {
+        return false;
+    }
+    AnalyticState state = initialAnalyticState();
+    const float distance = stopDistance(state.speed, state.switchSpeed, state.sliding);
+
+    // sweep the ball along its path, lifted a bit to stay clear of the ground
+    const btVector3 lift(0, 0, 0.005f);
+    btTransform from, to;
+    from.setIdentity();
+    to.setIdentity();
+    from.setOrigin((state.start + lift) * SIMULATOR_SCALE);
+    to.setOrigin((state.start + state.direction * distance + lift) * SIMULATOR_SCALE);
+    StaticSweepCallback callback(m_body, from.getOrigin(), to.getOrigin());
+    m_world->convexSweepTest(static_cast<btConvexShape *>(m_sphere), from, to, callback);
+
+    // leave bullet some room to resolve the contact itself
+    const float contactMargin = 0.02f;
+    state.freeDistance = callback.hasHit() ? callback.m_closestHitFraction * distance - contactMargin : distance;
+    if (state.freeDistance < 0.1f) {
+        // not worth switching for a few steps
+        return false;
+    }
+
+    state.active = true;
+    m_analytic = state;
+    setKinematic(true);
+    return true;
+}
+
+void SimBall::advanceAnalytic(float time)
+{
+    AnalyticState &s = m_analytic;
+    if (s.sliding) {
+        const float switchTime = (s.speed - s.switchSpeed) / BALL_ACC_SLIDE;
+        const float t = std::min(time, switchTime);
+        s.travelled += s.speed * t - 0.5f * BALL_ACC_SLIDE * t * t;
+        s.speed -= BALL_ACC_SLIDE * t;
+        time -= t;
+        if (switchTime <= t) {
+            s.sliding = false;
+            s.speed = s.switchSpeed;
+        }
+    }
+    if (!s.sliding && time > 0) {
+        const float t = std::min(time, s.speed / BALL_ACC_ROLL);
+        s.travelled += s.speed * t - 0.5f * BALL_ACC_ROLL * t * t;
+        s.speed = std::max(0.0f, s.speed - BALL_ACC_ROLL * t);
+    }
+
+    btTransform transform = m_body->getWorldTransform();
+    transform.setOrigin((s.start + s.direction * std::min(s.travelled, s.freeDistance)) * SIMULATOR_SCALE);
+    m_body->setWorldTransform(transform);
+    m_motionState->setWorldTransform(transform);
+    m_body->setLinearVelocity(s.direction * s.speed * SIMULATOR_SCALE);
+    m_body->setAngularVelocity(analyticAngularVelocity(s.direction, s.speed, s.switchSpeed, s.sliding));
+
+    if (s.travelled >= s.freeDistance || s.speed <= 0) {
+        stopAnalytic();
+    }
+}
+
+void SimBall::stopAnalytic()
+{
+    if (!m_analytic.active) {
+        return;
+    }
+    m_analytic.active = false;
+    setKinematic(false);
+    const AnalyticState &s = m_analytic;
+    m_body->setLinearVelocity(s.direction * s.speed * SIMULATOR_SCALE);
+    m_body->setAngularVelocity(analyticAngularVelocity(s.direction, s.speed, s.switchSpeed, s.sliding));
+}
+
+void SimBall::setKinematic(bool kinematic)
+{
+    // bullet sorts bodies by their type when adding them, thus readd the body
+    m_world->removeRigidBody(m_body);
+    if (kinematic) {
+        m_body->setMassProps(0, btVector3(0, 0, 0));
+        m_body->setCollisionFlags(m_body->getCollisionFlags() | btCollisionObject::CF_KINEMATIC_OBJECT);
+        m_body->setActivationState(DISABLE_DEACTIVATION);
+    } else {
+        btVector3 localInertia(0, 0, 0);
+        m_sphere->calculateLocalInertia(BALL_MASS, localInertia);
+        m_body->setMassProps(BALL_MASS, localInertia);
+        m_body->setCollisionFlags(m_body->getCollisionFlags() & ~btCollisionObject::CF_KINEMATIC_OBJECT);
+        m_body->forceActivationState(ACTIVE_TAG);
+    }
+    m_body->updateInertiaTensor();
+    // the static field can't push a kinematic ball, its path is checked by startAnalytic instead
+    const short mask = kinematic ? (COLLISION_BALL_MASK & ~COLLISION_FIELD) : COLLISION_BALL_MASK;
+    m_world->addRigidBody(m_body, COLLISION_BALL, mask);
+}
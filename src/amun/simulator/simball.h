@@ -27,10 +27,8 @@
  */
  
  #include "protobuf/command.pb.h"
- #include "protobuf/sslsim.h"
  #include <btBulletDynamicsCommon.h>
  #include "simfield.h"
- #include <QObject>
  
  /**
  * @def BALL_RADIUS
@@ -50,11 +48,30 @@
  */
  static const float BALL_DECELERATION = 0.5f;
  
- class RNG;
+ /**
+ * @def BALL_ACC_SLIDE
+ * @brief Deceleration of a sliding ball in m/s^2 (straight two phase model)
+ */
+ static const float BALL_ACC_SLIDE = 3.9f;
+ 
+ /**
+ * @def BALL_ACC_ROLL
+ * @brief Deceleration of a rolling ball in m/s^2 (straight two phase model)
+ */
+ static const float BALL_ACC_ROLL = 0.35f;
+ 
+ /**
+ * @def BALL_K_SWITCH
+ * @brief Fraction of the initial speed at which a sliding ball starts rolling (straight two phase model)
+ */
+ static const float BALL_K_SWITCH = 0.69f;
+ 
  class SSL_DetectionBall;
  
  namespace camun {
      namespace simulator {
+         class ErrorAggregator;
+         class FrameNoise;
          class SimBall;
          enum class ErrorSource;
      }
@@ -67,17 +84,16 @@
  * in a Bullet physics simulation. It handles ball movement, interactions with
  * the field and robots, and vision detection simulation.
  */
- class camun::simulator::SimBall: public QObject
+ class camun::simulator::SimBall
  {
-     Q_OBJECT
  public:
      /**
-     * @fn SimBall::SimBall(RNG *rng, btDiscreteDynamicsWorld *world)
+     * @fn SimBall::SimBall(btDiscreteDynamicsWorld *world, ErrorAggregator *aggregator)
      * @brief Constructs a simulated ball
-     * @param rng Random number generator for noise simulation
      * @param world Bullet physics world in which the ball exists
+     * @param aggregator Receives the errors caused by teleport commands
      */
-     SimBall(RNG *rng, btDiscreteDynamicsWorld *world);
+     SimBall(btDiscreteDynamicsWorld *world, ErrorAggregator *aggregator);
  
      /**
      * @fn SimBall::~SimBall()
@@ -87,16 +103,6 @@
      SimBall(const SimBall&) = delete;
      SimBall& operator=(const SimBall&) = delete;
  
- signals:
-     /**
-     * @fn void SimBall::sendSSLSimError(const SSLSimError& error, ErrorSource s)
-     * @brief Signal emitted when a simulation error occurs
-     * @param error Error message to be sent
-     * @param s Source of the error
-     */
-     void sendSSLSimError(const SSLSimError& error, ErrorSource s);
- 
- public:
      /**
      * @fn void SimBall::begin()
      * @brief Prepares the ball for a simulation step
@@ -106,10 +112,11 @@
      void begin();
  
      /**
-     * @fn bool SimBall::update(SSL_DetectionBall *ball, float stddev, float stddevArea, const btVector3 &cameraPosition, bool enableInvisibleBall, float visibilityThreshold, btVector3 positionOffset)
+     * @fn bool SimBall::update(SSL_DetectionBall *ball, FrameNoise &noise, float stddev, float stddevArea, const btVector3 &cameraPosition, bool enableInvisibleBall, float visibilityThreshold, btVector3 positionOffset)
      * @brief Updates a vision detection packet with ball information
      * Fills the SSL vision detection packet with the ball's position, adding simulated vision noise.
      * @param ball SSL detection ball message to be filled
+     * @param noise Random numbers of the current vision frame
      * @param stddev Standard deviation for position noise
      * @param stddevArea Standard deviation for area calculation
      * @param cameraPosition Position of the camera in the physics world
@@ -118,7 +125,7 @@
      * @param positionOffset Offset to apply to the ball's position
      * @return true if the ball was successfully updated, false otherwise
      */
-     bool update(SSL_DetectionBall *ball, float stddev, float stddevArea, const btVector3 &cameraPosition,
+     bool update(SSL_DetectionBall *ball, FrameNoise &noise, float stddev, float stddevArea, const btVector3 &cameraPosition,
                 bool enableInvisibleBall, float visibilityThreshold, btVector3 positionOffset);
  
      /**
@@ -155,6 +162,17 @@
      * @param ball World state ball message to be filled
      */
      void writeBallState(world::SimBall *ball) const;
+
+     /**
+     * @fn void SimBall::writeState(float *state) const
+     * @brief Writes the position and velocity of the body to a flat buffer
+     * Uses the coordinates of the world state: x, y, z, v_x, v_y and v_z.
+     * @param state Buffer for BALL_STATE_SIZE values
+     */
+     void writeState(float *state) const;
+
+     /// @brief Number of values written by writeState
+     static const int BALL_STATE_SIZE = 6;
      
      /**
      * @fn void SimBall::restoreState(const world::SimBall &ball)
@@ -178,10 +196,11 @@
      bool isInvalid() const;
  
      /**
-     * @fn bool SimBall::addDetection(SSL_DetectionBall *ball, btVector3 pos, float stddev, float stddevArea, const btVector3 &cameraPosition, bool enableInvisibleBall, float visibilityThreshold, btVector3 positionOffset)
+     * @fn bool SimBall::addDetection(SSL_DetectionBall *ball, FrameNoise &noise, btVector3 pos, float stddev, float stddevArea, const btVector3 &cameraPosition, bool enableInvisibleBall, float visibilityThreshold, btVector3 positionOffset)
      * @brief Adds a simulated ball detection at the specified position
      * This can be used to add ball mis-detections to the simulation for testing vision filtering.
      * @param ball SSL detection ball message to be filled
+     * @param noise Random numbers of the current vision frame
      * @param pos Position to use for the detection
      * @param stddev Standard deviation for position noise
      * @param stddevArea Standard deviation for area calculation
@@ -191,15 +210,92 @@
      * @param positionOffset Offset to apply to the ball's position
      * @return true if the detection was successfully added, false otherwise
      */
-     bool addDetection(SSL_DetectionBall *ball, btVector3 pos, float stddev, float stddevArea, const btVector3 &cameraPosition,
+     bool addDetection(SSL_DetectionBall *ball, FrameNoise &noise, btVector3 pos, float stddev, float stddevArea, const btVector3 &cameraPosition,
                        bool enableInvisibleBall, float visibilityThreshold, btVector3 positionOffset);
  
+     /**
+     * @fn bool SimBall::isFreeRolling() const
+     * @brief Checks whether the ball rolls on the ground without being held or teleported
+     * @return true if the ball could be advanced analytically
+     */
+     bool isFreeRolling() const;
+ 
+     /**
+     * @fn bool SimBall::startAnalytic()
+     * @brief Switches the ball to the closed form straight two phase model
+     * The ball becomes kinematic and is moved along its current direction until it
+     * stops or reaches the first static obstacle on its path, then Bullet takes over again.
+     * Robots are not considered, the caller has to check the path returned by rollingStopPosition.
+     * @return true if the analytic mode was started
+     */
+     bool startAnalytic();
+ 
+     /**
+     * @fn void SimBall::stopAnalytic()
+     * @brief Hands the ball back to Bullet with the current analytic position and velocity
+     */
+     void stopAnalytic();
+ 
+     /**
+     * @fn bool SimBall::isAnalytic() const
+     * @brief Checks whether the ball is currently advanced in closed form
+     * @return true if the analytic mode is active
+     */
+     bool isAnalytic() const { return m_analytic.active; }
+ 
+     /**
+     * @fn btVector3 SimBall::rollingStopPosition() const
+     * @brief Predicts where the ball comes to rest following the straight two phase model
+     * @return Position on the ground in the physics world
+     */
+     btVector3 rollingStopPosition() const;
+ 
  private:
-     /// @brief Random number generator for noise simulation
-     RNG *m_rng;
-     
+     /// @brief State of the ball while advanced in closed form, all values in meters and seconds
+     struct AnalyticState {
+         bool active = false;
+         btVector3 start;
+         btVector3 direction;
+         float speed = 0;
+         float switchSpeed = 0;
+         bool sliding = false;
+         float travelled = 0;
+         float freeDistance = 0;
+     };
+ 
+     /**
+     * @fn void SimBall::advanceAnalytic(float time)
+     * @brief Moves the analytic ball along its path
+     * @param time Time step in seconds
+     */
+     void advanceAnalytic(float time);
+ 
+     /**
+     * @fn void SimBall::setKinematic(bool kinematic)
+     * @brief Switches the rigid body between kinematic and dynamic
+     * @param kinematic true to move the body by hand
+     */
+     void setKinematic(bool kinematic);
+ 
+     /**
+     * @fn AnalyticState SimBall::initialAnalyticState() const
+     * @brief Derives the analytic state from the current state of the rigid body
+     * @return Inactive analytic state starting at the current ball position
+     */
+     AnalyticState initialAnalyticState() const;
+ 
+     /**
+     * @fn bool SimBall::isSliding() const
+     * @brief Checks whether the ball slides instead of rolling on the ground
+     * @return true if the contact point moves relative to the ground
+     */
+     bool isSliding() const;
+ 
      /// @brief Bullet physics world in which the ball exists
      btDiscreteDynamicsWorld *m_world;
+
+     /// @brief Receives the errors caused by teleport commands
+     ErrorAggregator *m_aggregator;
      
      /// @brief Collision shape for the ball (sphere)
      btCollisionShape *m_sphere;
@@ -212,6 +308,9 @@
      
      /// @brief Current teleport command
      sslsim::TeleportBall m_move;
+ 
+     /// @brief State of the analytic mode
+     AnalyticState m_analytic;
  };
  
  #endif // SIMBALL_H
\ No newline at end of file
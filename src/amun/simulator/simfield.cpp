@@ -19,17 +19,59 @@
  ***************************************************************************/
 
 #include "simfield.h"
-#include "simulator.h"
+#include "simulatorcore.h"
+#include <algorithm>
 
 using namespace camun::simulator;
 
+// height of the ceiling above the field
+static const float ROOM_HEIGHT = 8.0f;
+
+// records an obstacle of the layout
+static void addObject(FieldLayout &layout, btCollisionShape *shape, const btTransform &transform, float restitution, float friction)
+{
+    layout.objects.push_back(FieldLayout::Object{shape, transform, restitution, friction});
+}
+
+// the layout owns the shapes
+template<typename Shape>
+static Shape *addShape(FieldLayout &layout, Shape *shape)
+{
+    layout.shapes.emplace_back(shape);
+    return shape;
+}
+
 SimField::SimField(btDiscreteDynamicsWorld *world, const world::Geometry &geometry) :
-    m_world(world)
+    SimField(world, createLayout(geometry))
+{ }
+
+SimField::SimField(btDiscreteDynamicsWorld *world, std::shared_ptr<const FieldLayout> layout) :
+    m_world(world),
+    m_layout(std::move(layout))
 {
+    for (const FieldLayout::Object &obstacle : m_layout->objects) {
+        // create new obstacle
+        btCollisionObject* object = new btCollisionObject;
+        object->setCollisionShape(obstacle.shape);
+        // damp ball a bit if it hits an obstacle
+        object->setRestitution(obstacle.restitution);
+        // the friction is multiplied with the colliding obstacle ones
+        object->setFriction(obstacle.friction);
+        object->setRollingFriction(obstacle.friction);
+        object->setWorldTransform(obstacle.transform);
+        m_world->addCollisionObject(object, COLLISION_FIELD, COLLISION_FIELD_MASK);
+        m_objects.push_back(object);
+    }
+}
+
+std::shared_ptr<const FieldLayout> SimField::createLayout(const world::Geometry &geometry)
+{
+    auto layout = std::make_shared<FieldLayout>();
+
     const float totalWidth = geometry.field_width() / 2.0f + geometry.boundary_width();
     const float totalHeight = geometry.field_height() / 2.0f + geometry.boundary_width();
     // upper boundary
-    const float roomHeight = 8.0f;
+    const float roomHeight = ROOM_HEIGHT;
     const float height = geometry.field_height() / 2.0f - geometry.line_width();
     const float goalWidthHalf = geometry.goal_width() / 2.0f + geometry.goal_wall_width();
     const float goalHeightHalf = geometry.goal_height() / 2.0f;
@@ -38,36 +80,36 @@ SimField::SimField(btDiscreteDynamicsWorld *world, const world::Geometry &geomet
     const float goalWallHalf = geometry.goal_wall_width() / 2.0f;
 
     // obstacle prototypes
-    m_plane = new btStaticPlaneShape(btVector3(0, 0, 1), 0);
-    m_goalSide = new btBoxShape(btVector3(goalWallHalf, goalDepthHalf, goalHeightHalf) * SIMULATOR_SCALE);
-    m_goalBack = new btBoxShape(btVector3(goalWidthHalf, goalWallHalf, goalHeightHalf) * SIMULATOR_SCALE);
+    btCollisionShape *plane = addShape(*layout, new btStaticPlaneShape(btVector3(0, 0, 1), 0));
+    btCollisionShape *goalSide = addShape(*layout, new btBoxShape(btVector3(goalWallHalf, goalDepthHalf, goalHeightHalf) * SIMULATOR_SCALE));
+    btCollisionShape *goalBack = addShape(*layout, new btBoxShape(btVector3(goalWidthHalf, goalWallHalf, goalHeightHalf) * SIMULATOR_SCALE));
 
     // build field cube
     // floor
-    addObject(m_plane, btTransform(btQuaternion(btVector3(1, 0, 0), 0), btVector3(0, 0, 0) * SIMULATOR_SCALE), 0.56, 0.35);
+    addObject(*layout, plane, btTransform(btQuaternion(btVector3(1, 0, 0), 0), btVector3(0, 0, 0) * SIMULATOR_SCALE), 0.56, 0.35);
     // others
-    addObject(m_plane, btTransform(btQuaternion(btVector3(1, 0, 0), M_PI), btVector3(0, 0, roomHeight) * SIMULATOR_SCALE), 0.3, 0.35);
+    addObject(*layout, plane, btTransform(btQuaternion(btVector3(1, 0, 0), M_PI), btVector3(0, 0, roomHeight) * SIMULATOR_SCALE), 0.3, 0.35);
 
     // if boundary_width == 0.0 the game is played without boundary area and needs different colliders on the goal line
     if (geometry.boundary_width() == 0.0) {
         const auto goalLineBoundaryWidthHalf = 0.5 * (totalWidth - goalWidthHalf);
-        m_goalLineBoundaryShape.emplace(btVector3(goalLineBoundaryWidthHalf, 0.5, roomHeight * 0.5) * SIMULATOR_SCALE);
+        btCollisionShape *goalLineBoundaryShape = addShape(*layout, new btBoxShape(btVector3(goalLineBoundaryWidthHalf, 0.5, roomHeight * 0.5) * SIMULATOR_SCALE));
         const auto shapeOffsetX = goalWidthHalf + goalLineBoundaryWidthHalf;
         const auto shapeOffsetIntoVoidPositive = btVector3(0, 0.5, roomHeight * 0.5) * SIMULATOR_SCALE;
         const auto identity = btQuaternion::getIdentity();
-        addObject(&m_goalLineBoundaryShape.value(), btTransform(identity, shapeOffsetIntoVoidPositive + btVector3(shapeOffsetX, totalHeight, 0) * SIMULATOR_SCALE), 0.3, 0.35);
-        addObject(&m_goalLineBoundaryShape.value(), btTransform(identity, shapeOffsetIntoVoidPositive + btVector3(-shapeOffsetX, totalHeight, 0) * SIMULATOR_SCALE), 0.3, 0.35);
+        addObject(*layout, goalLineBoundaryShape, btTransform(identity, shapeOffsetIntoVoidPositive + btVector3(shapeOffsetX, totalHeight, 0) * SIMULATOR_SCALE), 0.3, 0.35);
+        addObject(*layout, goalLineBoundaryShape, btTransform(identity, shapeOffsetIntoVoidPositive + btVector3(-shapeOffsetX, totalHeight, 0) * SIMULATOR_SCALE), 0.3, 0.35);
 
         const auto shapeOffsetIntoVoidNegative = btVector3(0, -0.5, roomHeight * 0.5) * SIMULATOR_SCALE;
-        addObject(&m_goalLineBoundaryShape.value(), btTransform(identity, shapeOffsetIntoVoidNegative + btVector3(shapeOffsetX, -totalHeight, 0) * SIMULATOR_SCALE), 0.3, 0.35);
-        addObject(&m_goalLineBoundaryShape.value(), btTransform(identity, shapeOffsetIntoVoidNegative + btVector3(-shapeOffsetX, -totalHeight, 0) * SIMULATOR_SCALE), 0.3, 0.35);
+        addObject(*layout, goalLineBoundaryShape, btTransform(identity, shapeOffsetIntoVoidNegative + btVector3(shapeOffsetX, -totalHeight, 0) * SIMULATOR_SCALE), 0.3, 0.35);
+        addObject(*layout, goalLineBoundaryShape, btTransform(identity, shapeOffsetIntoVoidNegative + btVector3(-shapeOffsetX, -totalHeight, 0) * SIMULATOR_SCALE), 0.3, 0.35);
     } else {
-        addObject(m_plane, btTransform(btQuaternion(btVector3(1, 0, 0),  M_PI_2), btVector3(0,  totalHeight, 0) * SIMULATOR_SCALE), 0.3, 0.35);
-        addObject(m_plane, btTransform(btQuaternion(btVector3(1, 0, 0), -M_PI_2), btVector3(0, -totalHeight, 0) * SIMULATOR_SCALE), 0.3, 0.35);
+        addObject(*layout, plane, btTransform(btQuaternion(btVector3(1, 0, 0),  M_PI_2), btVector3(0,  totalHeight, 0) * SIMULATOR_SCALE), 0.3, 0.35);
+        addObject(*layout, plane, btTransform(btQuaternion(btVector3(1, 0, 0), -M_PI_2), btVector3(0, -totalHeight, 0) * SIMULATOR_SCALE), 0.3, 0.35);
     }
 
-    addObject(m_plane, btTransform(btQuaternion(btVector3(0, 1, 0),  M_PI_2), btVector3(-totalWidth, 0, 0) * SIMULATOR_SCALE), 0.3, 0.35);
-    addObject(m_plane, btTransform(btQuaternion(btVector3(0, 1, 0), -M_PI_2), btVector3( totalWidth, 0, 0) * SIMULATOR_SCALE), 0.3, 0.35);
+    addObject(*layout, plane, btTransform(btQuaternion(btVector3(0, 1, 0),  M_PI_2), btVector3(-totalWidth, 0, 0) * SIMULATOR_SCALE), 0.3, 0.35);
+    addObject(*layout, plane, btTransform(btQuaternion(btVector3(0, 1, 0), -M_PI_2), btVector3( totalWidth, 0, 0) * SIMULATOR_SCALE), 0.3, 0.35);
 
     // corner blocks to smooth out the edges
     // on the actual field they are triangular blocks put in the corners of the field,
@@ -77,7 +119,7 @@ SimField::SimField(btDiscreteDynamicsWorld *world, const world::Geometry &geomet
         const float hypothenuse = sqrt(2 * cathetus * cathetus);
         // basically the height of the triangle when looking top down onto the field
         const float blockOffset = (cathetus * cathetus) / hypothenuse;
-        m_cornerBlockShape.emplace(btVector3(hypothenuse * 0.5, goalWallHalf, roomHeight * 0.5) * SIMULATOR_SCALE);
+        btCollisionShape *cornerBlockShape = addShape(*layout, new btBoxShape(btVector3(hypothenuse * 0.5, goalWallHalf, roomHeight * 0.5) * SIMULATOR_SCALE));
 
         // this places the blocks to smooth the edges in order of angle, but since half of it can just be mirrored with a 180° rotation only the cases of
         // M_PI / 4 and 3 * M_PI / 4 are listed and if negativeYHalf is true it computes the same positions and just additionally rotates them in the end
@@ -96,7 +138,7 @@ SimField::SimField(btDiscreteDynamicsWorld *world, const world::Geometry &geomet
                 if (negativeYHalf) {
                     cornerTransform = btTransform(btQuaternion(btVector3(0, 0, 1), M_PI)) * cornerTransform;
                 }
-                addObject(&m_cornerBlockShape.value(), cornerTransform, 0.3, 0.35);
+                addObject(*layout, cornerBlockShape, cornerTransform, 0.3, 0.35);
 
                 // if boundary_width == 0.0 the game is played without boundary area and does not need the blocks around the goals
                 if (geometry.boundary_width() != 0.0) {
@@ -105,7 +147,7 @@ SimField::SimField(btDiscreteDynamicsWorld *world, const world::Geometry &geomet
                     if (negativeYHalf) {
                         goalTransform = btTransform(btQuaternion(btVector3(0, 0, 1), M_PI)) * goalTransform;
                     }
-                    addObject(&m_cornerBlockShape.value(), goalTransform, 0.3, 0.35);
+                    addObject(*layout, cornerBlockShape, goalTransform, 0.3, 0.35);
                 }
             }
         }
@@ -120,35 +162,29 @@ SimField::SimField(btDiscreteDynamicsWorld *world, const world::Geometry &geomet
         // so we have to offset the goals by line_width / 2
         const auto lineWidthOffset = geometry.boundary_width() != 0.0 ? 0.0 : geometry.line_width() * 0.5;
 
-        addObject(m_goalSide, btTransform(rot, btVector3((goalWidthHalf - goalWallHalf), side * (height + goalDepthHalf + lineWidthOffset), goalHeightHalf) * SIMULATOR_SCALE), 0.3, 0.5);
-        addObject(m_goalSide, btTransform(rot, btVector3(-(goalWidthHalf - goalWallHalf), side * (height + goalDepthHalf + lineWidthOffset), goalHeightHalf) * SIMULATOR_SCALE), 0.3, 0.5);
-        addObject(m_goalBack, btTransform(rot, btVector3(0.0f, side * (height + goalDepth - goalWallHalf + lineWidthOffset), goalHeightHalf) * SIMULATOR_SCALE), 0.1, 0.5);
+        addObject(*layout, goalSide, btTransform(rot, btVector3((goalWidthHalf - goalWallHalf), side * (height + goalDepthHalf + lineWidthOffset), goalHeightHalf) * SIMULATOR_SCALE), 0.3, 0.5);
+        addObject(*layout, goalSide, btTransform(rot, btVector3(-(goalWidthHalf - goalWallHalf), side * (height + goalDepthHalf + lineWidthOffset), goalHeightHalf) * SIMULATOR_SCALE), 0.3, 0.5);
+        addObject(*layout, goalBack, btTransform(rot, btVector3(0.0f, side * (height + goalDepth - goalWallHalf + lineWidthOffset), goalHeightHalf) * SIMULATOR_SCALE), 0.1, 0.5);
     }
+    return layout;
 }
 
 SimField::~SimField()
 {
-    foreach (btCollisionObject *object, m_objects) {
+    for (btCollisionObject *object : m_objects) {
         m_world->removeCollisionObject(object);
         delete object;
     }
-
-    delete m_goalSide;
-    delete m_goalBack;
-    delete m_plane;
 }
 
-void SimField::addObject(btCollisionShape *shape, const btTransform &transform, float restitution, float friction)
+void SimField::worldBounds(const world::Geometry &geometry, btVector3 &aabbMin, btVector3 &aabbMax)
 {
-    // create new obstacle
-    btCollisionObject* object = new btCollisionObject;
-    object->setCollisionShape(shape);
-    // damp ball a bit if it hits an obstacle
-    object->setRestitution(restitution);
-    // the friction is multiplied with the colliding obstacle ones
-    object->setFriction(friction);
-    object->setRollingFriction(friction);
-    object->setWorldTransform(transform);
-    m_world->addCollisionObject(object);
-    m_objects.append(object);
+    // the goals may stand outside of the boundary if there is none
+    const float goalDepth = geometry.goal_depth() + geometry.goal_wall_width() + geometry.line_width();
+    const float totalWidth = geometry.field_width() / 2.0f + geometry.boundary_width();
+    const float totalHeight = geometry.field_height() / 2.0f + std::max(geometry.boundary_width(), goalDepth);
+    // leave some room for objects that are pushed through the walls
+    const float margin = 1.0f;
+    aabbMax = btVector3(totalWidth + margin, totalHeight + margin, ROOM_HEIGHT + margin) * SIMULATOR_SCALE;
+    aabbMin = btVector3(-aabbMax.x(), -aabbMax.y(), -margin * SIMULATOR_SCALE);
 }
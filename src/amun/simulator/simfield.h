@@ -27,9 +27,9 @@
  * The file defines the simfield class under simulator
  */
 #include "protobuf/world.pb.h"
-#include <QList>
 #include <btBulletDynamicsCommon.h>
-#include <optional>
+#include <memory>
+#include <vector>
 
 /**
  * Declaring the namespaces under which simfield is a class
@@ -37,8 +37,33 @@
 namespace camun {
     namespace simulator {
         class SimField;
+        struct FieldLayout;
     }
 }
+
+/**
+ * @struct FieldLayout
+ * @brief Static collision shapes of a field and where they are placed
+ * Bullet only reads the shapes during the simulation, thus one layout
+ * can be shared by the fields of several physics worlds.
+ */
+struct camun::simulator::FieldLayout
+{
+    /**
+     * @struct Object
+     * @brief Placement of one static obstacle
+     */
+    struct Object {
+        btCollisionShape *shape;  /**< Shape owned by the layout */
+        btTransform transform;    /**< Pose in simulator coordinates */
+        float restitution;        /**< Damping provided when a collision happens */
+        float friction;           /**< Friction coefficient */
+    };
+
+    std::vector<std::unique_ptr<btCollisionShape>> shapes;
+    std::vector<Object> objects;
+};
+
 /**
  * @class SimField
  * @brief Incudes the funcions to add objects
@@ -53,28 +78,37 @@ public:
      * @param &geometry Refers to the adress of the geometry parameter
      */
     SimField(btDiscreteDynamicsWorld *world, const world::Geometry &geometry);
+
+    /**
+     * @brief Adds the obstacles of a prebuilt layout to the world
+     * @param *world Refers to the value of the pointer world
+     * @param layout Layout which may be shared with other fields
+     */
+    SimField(btDiscreteDynamicsWorld *world, std::shared_ptr<const FieldLayout> layout);
     ~SimField();
     SimField(const SimField&) = delete;
     SimField& operator=(const SimField&) = delete;
 
-private:
     /**
-     * @brief Adds objects to the field
-     * @param *shape Refers to the value of the shape pointer
-     * @param &transform Refers to the adress of the transform of the object
-     * @param restitution The value of the damping provide when collision happens 
-     * @param friction The value of the friction coefficient
+     * @brief Computes a box enclosing everything that can move on the field
+     * Used to size bounded broadphases, objects leaving it still collide, just less efficiently.
+     * @param &geometry Field geometry
+     * @param &aabbMin Receives the lower corner in simulator coordinates
+     * @param &aabbMax Receives the upper corner in simulator coordinates
+     */
+    static void worldBounds(const world::Geometry &geometry, btVector3 &aabbMin, btVector3 &aabbMax);
+
+    /**
+     * @brief Builds the obstacles of a field
+     * @param &geometry Field geometry
+     * @return Layout to create any number of fields from
      */
-    void addObject(btCollisionShape *shape, const btTransform &transform, float restitution, float friction);
+    static std::shared_ptr<const FieldLayout> createLayout(const world::Geometry &geometry);
 
 private:
     btDiscreteDynamicsWorld *m_world;
-    btCollisionShape *m_plane;
-    btCollisionShape *m_goalSide;
-    btCollisionShape *m_goalBack;
-    std::optional<btBoxShape> m_cornerBlockShape;
-    std::optional<btBoxShape> m_goalLineBoundaryShape;
-    QList<btCollisionObject*> m_objects;
+    std::shared_ptr<const FieldLayout> m_layout;
+    std::vector<btCollisionObject*> m_objects;
 };
 
 #endif // SIMFIELD_H
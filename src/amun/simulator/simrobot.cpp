@@ -18,13 +18,14 @@
  *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
  ***************************************************************************/
 
-#include "core/rng.h"
+#include "erroraggregator.h"
+#include "framenoise.h"
 #include "core/coordinates.h"
 #include "mesh.h"
 #include "protobuf/ssl_detection.pb.h"
 #include "simball.h"
 #include "simrobot.h"
-#include "simulator.h"
+#include "simulatorcore.h"
 #include <cmath>
 #include <QDebug>
 
@@ -39,10 +40,51 @@ float boundSpeed(float speed)
 }
 
 
-SimRobot::SimRobot(RNG *rng, const robot::Specs &specs, btDiscreteDynamicsWorld *world, const btVector3 &pos, float dir) :
-    m_rng(rng),
+RobotShapes::RobotShapes(const robot::Specs &specs)
+{
+    btCompoundShape * wholeShape = new btCompoundShape;
+    btTransform robotShapeTransform;
+    robotShapeTransform.setIdentity();
+
+    // subtract collision margin from dimensions
+    Mesh mesh(specs.radius() - COLLISION_MARGIN / SIMULATOR_SCALE,
+              specs.height() - 2 * COLLISION_MARGIN / SIMULATOR_SCALE, specs.angle(), 0.04f, specs.dribbler_height() + 0.02f);
+    for (const std::vector<btVector3> & hullPart : mesh.hull()) {
+        btConvexHullShape* hullPartShape = new btConvexHullShape;
+        m_shapes.push_back(hullPartShape);
+        for (const btVector3& v : hullPart) {
+            hullPartShape->addPoint(v * SIMULATOR_SCALE);
+        }
+        wholeShape->addChildShape(robotShapeTransform, hullPartShape);
+    }
+    m_shapes.push_back(wholeShape);
+    m_detailed = wholeShape;
+    // the cylinder margin is inside of its dimensions
+    m_simple = new btCylinderShapeZ(btVector3(specs.radius(), specs.radius(), specs.height() / 2.0f) * SIMULATOR_SCALE);
+    m_shapes.push_back(m_simple);
+
+    m_dribbler = new btCylinderShapeX(btVector3(specs.dribbler_width() / 2.0f, 0.007f, 0.007f) * SIMULATOR_SCALE);
+    m_shapes.push_back(m_dribbler);
+}
+
+RobotShapes::~RobotShapes()
+{
+    for (btCollisionShape *shape : m_shapes) {
+        delete shape;
+    }
+}
+
+std::string RobotShapes::key(const robot::Specs &specs)
+{
+    const float dimensions[] = {specs.radius(), specs.height(), specs.angle(), specs.dribbler_height(), specs.dribbler_width()};
+    return std::string(reinterpret_cast<const char *>(dimensions), sizeof(dimensions));
+}
+
+SimRobot::SimRobot(const robot::Specs &specs, std::shared_ptr<const RobotShapes> shapes, btDiscreteDynamicsWorld *world, ErrorAggregator *aggregator, const btVector3 &pos, float dir) :
     m_specs(specs),
     m_world(world),
+    m_aggregator(aggregator),
+    m_shapes(std::move(shapes)),
     m_charge(false),
     m_isCharged(false),
     m_inStandby(false),
@@ -52,23 +94,7 @@ SimRobot::SimRobot(RNG *rng, const robot::Specs &specs, btDiscreteDynamicsWorld
     error_sum_v_f(0),
     error_sum_omega(0)
 {
-
-    btCompoundShape * wholeShape = new btCompoundShape;
-    btTransform robotShapeTransform;
-    robotShapeTransform.setIdentity();
-
-    // subtract collision margin from dimensions
-    Mesh mesh(m_specs.radius() - COLLISION_MARGIN / SIMULATOR_SCALE,
-              m_specs.height() - 2 * COLLISION_MARGIN / SIMULATOR_SCALE, m_specs.angle(), 0.04f, m_specs.dribbler_height() + 0.02f);
-    for (const QList<QVector3D> & hullPart : mesh.hull()) {
-        btConvexHullShape* hullPartShape = new btConvexHullShape;
-        m_shapes.append(hullPartShape);
-        for (const QVector3D& v : hullPart) {
-            hullPartShape->addPoint(btVector3(v.x(), v.y(), v.z()) * SIMULATOR_SCALE);
-        }
-        wholeShape->addChildShape(robotShapeTransform, hullPartShape);
-    }
-    m_shapes.append(wholeShape);
+    btCollisionShape *wholeShape = m_shapes->detailed();
 
     btTransform startWorldTransform;
     startWorldTransform.setIdentity();
@@ -87,10 +113,17 @@ SimRobot::SimRobot(RNG *rng, const robot::Specs &specs, btDiscreteDynamicsWorld
     // see simulator.cpp
     m_body->setRestitution(0.6f);
     m_body->setFriction(0.22f);
-    m_world->addRigidBody(m_body);
 
-    btCylinderShape * dribblerShape = new btCylinderShapeX(btVector3(m_specs.dribbler_width() / 2.0f, 0.007f, 0.007f) * SIMULATOR_SCALE);
-    m_shapes.append(dribblerShape);
+    // carries the detailed shape against the ball while the body itself uses the simple one
+    btRigidBody::btRigidBodyConstructionInfo rbProxyInfo(0, nullptr, wholeShape);
+    rbProxyInfo.m_startWorldTransform = startWorldTransform;
+    m_ballProxy = new btRigidBody(rbProxyInfo);
+    m_ballProxy->setCollisionFlags(m_ballProxy->getCollisionFlags() | btCollisionObject::CF_KINEMATIC_OBJECT);
+    m_ballProxy->setActivationState(DISABLE_DEACTIVATION);
+    m_ballProxy->setRestitution(0.6f);
+    m_ballProxy->setFriction(0.22f);
+
+    btCollisionShape *dribblerShape = m_shapes->dribbler();
     // WARNING: hack, instead of 0.02 should be the dribbler height
     // the ball seems to get instable if the dribbler is at correct height
     // possibly the ball gets 'sucked' onto the robot
@@ -109,7 +142,6 @@ SimRobot::SimRobot(RNG *rng, const robot::Specs &specs, btDiscreteDynamicsWorld
     dribblerBody->setRestitution(0.2f);
     dribblerBody->setFriction(1.5f);
     m_dribblerBody = dribblerBody;
-    m_world->addRigidBody(dribblerBody);
 
     btTransform localA, localB;
     localA.setIdentity();
@@ -119,7 +151,7 @@ SimRobot::SimRobot(RNG *rng, const robot::Specs &specs, btDiscreteDynamicsWorld
     localB.setRotation(btQuaternion(btVector3(0, 1, 0), M_PI_2));
     m_dribblerConstraint = new btHingeConstraint(*m_body, *dribblerBody, localA, localB);
     m_dribblerConstraint->enableAngularMotor(false, 0, 0);
-    m_world->addConstraint(m_dribblerConstraint, true);
+    addToWorld();
 
     generateVelocityCoupling();
 //    reportAccelerationLimits();
@@ -127,17 +159,115 @@ SimRobot::SimRobot(RNG *rng, const robot::Specs &specs, btDiscreteDynamicsWorld
 
 SimRobot::~SimRobot()
 {
-    if (m_holdBallConstraint) {
-        m_world->removeConstraint(m_holdBallConstraint.get());
-    }
-    m_world->removeConstraint(m_dribblerConstraint);
-    m_world->removeRigidBody(m_dribblerBody);
-    m_world->removeRigidBody(m_body);
+    removeFromWorld();
     delete m_dribblerConstraint;
+    delete m_ballProxy;
     delete m_body;
     delete m_dribblerBody;
     delete m_motionState;
-    qDeleteAll(m_shapes);
+}
+
+void SimRobot::addToWorld()
+{
+    if (m_inWorld) {
+        return;
+    }
+    if (m_simplifiedCollision) {
+        m_world->addRigidBody(m_body, COLLISION_ROBOT, COLLISION_ROBOT_MASK & ~COLLISION_BALL);
+        updateBallProxy();
+        m_world->addRigidBody(m_ballProxy, COLLISION_ROBOT, COLLISION_BALL);
+    } else {
+        m_world->addRigidBody(m_body, COLLISION_ROBOT, COLLISION_ROBOT_MASK);
+    }
+    m_world->addRigidBody(m_dribblerBody, COLLISION_DRIBBLER, COLLISION_DRIBBLER_MASK);
+    m_world->addConstraint(m_dribblerConstraint, true);
+    m_inWorld = true;
+}
+
+void SimRobot::removeFromWorld()
+{
+    if (!m_inWorld) {
+        return;
+    }
+    stopDribbling();
+    m_world->removeConstraint(m_dribblerConstraint);
+    m_world->removeRigidBody(m_dribblerBody);
+    if (m_simplifiedCollision) {
+        m_world->removeRigidBody(m_ballProxy);
+    }
+    m_world->removeRigidBody(m_body);
+    m_inWorld = false;
+}
+
+void SimRobot::setSimplifiedCollision(bool simplified)
+{
+    if (simplified == m_simplifiedCollision) {
+        return;
+    }
+    // the filter mask of the body changes, thus readd it
+    const bool inWorld = m_inWorld;
+    removeFromWorld();
+    m_simplifiedCollision = simplified;
+    // keeps the inertia of the detailed shape, only the contacts change
+    m_body->setCollisionShape(simplified ? m_shapes->simple() : m_shapes->detailed());
+    if (inWorld) {
+        addToWorld();
+    }
+}
+
+void SimRobot::updateBallProxy()
+{
+    if (!m_simplifiedCollision) {
+        return;
+    }
+    // the ball bounces off the proxy as if it was the robot body
+    m_ballProxy->setWorldTransform(m_body->getWorldTransform());
+    m_ballProxy->setInterpolationWorldTransform(m_body->getWorldTransform());
+    m_ballProxy->setLinearVelocity(m_body->getLinearVelocity());
+    m_ballProxy->setAngularVelocity(m_body->getAngularVelocity());
+}
+
+void SimRobot::resetBody(btRigidBody *body, const btTransform &transform)
+{
+    body->setWorldTransform(transform);
+    body->setInterpolationWorldTransform(transform);
+    body->setLinearVelocity(btVector3(0, 0, 0));
+    body->setAngularVelocity(btVector3(0, 0, 0));
+    body->setInterpolationLinearVelocity(btVector3(0, 0, 0));
+    body->setInterpolationAngularVelocity(btVector3(0, 0, 0));
+    body->clearForces();
+    body->setDamping(0.0, 0.0);
+    body->activate(true);
+    // contact points cached for the old pose would push the body around otherwise
+    if (m_inWorld && body->getBroadphaseHandle()) {
+        m_world->getBroadphase()->getOverlappingPairCache()->cleanProxyFromPairs(body->getBroadphaseHandle(), m_world->getDispatcher());
+    }
+}
+
+void SimRobot::reset(const btVector3 &pos, float dir)
+{
+    stopDribbling();
+
+    // same placement as in the constructor
+    const btQuaternion rotation(btVector3(0, 0, 1), dir - M_PI_2);
+    const btVector3 robotBasePos(btVector3(pos.x(), pos.y(), m_specs.height() / 2.0f) * SIMULATOR_SCALE);
+    const btTransform bodyTransform(rotation, robotBasePos);
+    m_motionState->setWorldTransform(bodyTransform);
+    resetBody(m_body, bodyTransform);
+    resetBody(m_dribblerBody, btTransform(rotation, m_dribblerCenter + robotBasePos));
+    resetBody(m_ballProxy, bodyTransform);
+
+    m_move.Clear();
+    m_sslCommand.Clear();
+    m_charge = false;
+    m_isCharged = false;
+    m_inStandby = false;
+    m_shootTime = 0.0;
+    m_commandTime = 0.0;
+    error_sum_v_s = 0;
+    error_sum_v_f = 0;
+    error_sum_omega = 0;
+    m_lastSendTime = 0;
 }
 
 void SimRobot::calculateDribblerMove(const btVector3 pos, const btQuaternion rot, const btVector3 linVel, float omega)
@@ -205,11 +335,11 @@ void SimRobot::setDribbleMode(bool perfectDribbler)
 bool SimRobot::handleMoveCommand()
 {
     auto sendPartialCoordError = [this](const std::string& msg){
-        SSLSimError error{new sslsim::SimulatorError};
-        error->set_code("PARTIAL_COORD");
+        sslsim::SimulatorError error;
+        error.set_code("PARTIAL_COORD");
         std::string message = "Partial coordinates are not implemented yet";
-        error->set_message(message + msg);
-        emit this->sendSSLSimError(error, ErrorSource::CONFIG);
+        error.set_message(message + msg);
+        m_aggregator->aggregate(error, ErrorSource::CONFIG);
         if (!m_move.has_by_force() || !m_move.by_force()) {
             m_move.Clear();
         }
@@ -254,10 +384,10 @@ bool SimRobot::handleMoveCommand()
             sendError |= m_move.v_angular() != 0;
         }
         if (sendError) {
-            SSLSimError error{new sslsim::SimulatorError};
-            error->set_code("VELOCITY_FORCE");
-            error->set_message("Velocities != 0 and by_force are incompatible");
-            emit sendSSLSimError(error, ErrorSource::CONFIG);
+            sslsim::SimulatorError error;
+            error.set_code("VELOCITY_FORCE");
+            error.set_message("Velocities != 0 and by_force are incompatible");
+            m_aggregator->aggregate(error, ErrorSource::CONFIG);
             return true;
         }
     } // TODO: check for force and orientation
@@ -626,7 +756,7 @@ robot::RadioResponse SimRobot::setCommand(const sslsim::RobotCommand &command, S
     return response;
 }
 
-void SimRobot::update(SSL_DetectionRobot *robot, float stddev_p, float stddev_phi, qint64 time, btVector3 positionOffset)
+void SimRobot::update(SSL_DetectionRobot *robot, FrameNoise &noise, float stddev_p, float stddev_phi, int64_t time, btVector3 positionOffset)
 {
     // setup vision packet
     robot->set_robot_id(m_specs.id());
@@ -638,13 +768,13 @@ void SimRobot::update(SSL_DetectionRobot *robot, float stddev_p, float stddev_ph
     btTransform transform;
     m_motionState->getWorldTransform(transform);
     const btVector3 p = transform.getOrigin() / SIMULATOR_SCALE + positionOffset;
-    const Vector p_noise = m_rng->normalVector(stddev_p);
+    const Vector p_noise = noise.normalVector(stddev_p);
     robot->set_x((p.y() + p_noise.x) * 1000.0f);
     robot->set_y(-(p.x() + p_noise.y) * 1000.0f);
 
     const btQuaternion q = transform.getRotation();
     const btVector3 dir = btMatrix3x3(q).getColumn(0);
-    robot->set_orientation(atan2(dir.y(), dir.x()) + m_rng->normal(stddev_phi));
+    robot->set_orientation(atan2(dir.y(), dir.x()) + noise.normal(stddev_phi));
 
     m_lastSendTime = time;
 }
@@ -685,13 +815,41 @@ void SimRobot::update(world::SimRobot* robot, SimBall *ball) const
         if ((objectA == m_dribblerBody && objectB == ball->body())
                 || (objectA == ball->body() && objectB == m_dribblerBody)
                 || (objectA == m_body && objectB == ball->body())
-                || (objectA == ball->body() && objectB == m_body)) {
+                || (objectA == ball->body() && objectB == m_body)
+                || (objectA == m_ballProxy && objectB == ball->body())
+                || (objectA == ball->body() && objectB == m_ballProxy)) {
             ballTouchesRobot = true;
         }
     }
     robot->set_touches_ball(ballTouchesRobot);
 }
 
+void SimRobot::writeState(float *state) const
+{
+    const btTransform &transform = m_body->getWorldTransform();
+    const btVector3 position = transform.getOrigin() / SIMULATOR_SCALE;
+    const btVector3 dir = transform.getBasis().getColumn(0);
+    const btVector3 velocity = m_body->getLinearVelocity() / SIMULATOR_SCALE;
+    state[0] = position.x();
+    state[1] = position.y();
+    // the body is rotated by the vision angle, report the forward angle that reset takes
+    state[2] = std::remainder(coordinates::fromVisionRotation(std::atan2(dir.y(), dir.x())), float(2 * M_PI));
+    state[3] = velocity.x();
+    state[4] = velocity.y();
+    state[5] = m_body->getAngularVelocity().z();
+}
+
+void SimRobot::readState(const float *state)
+{
+    reset(btVector3(state[0], state[1], 0), state[2]);
+    const btVector3 velocity = btVector3(state[3], state[4], 0) * SIMULATOR_SCALE;
+    const btVector3 angular(0, 0, state[5]);
+    m_body->setLinearVelocity(velocity);
+    m_body->setAngularVelocity(angular);
+    m_dribblerBody->setLinearVelocity(velocity);
+    m_dribblerBody->setAngularVelocity(angular);
+}
+
 void SimRobot::restoreState(const world::SimRobot &robot)
 {
     btVector3 position(robot.p_x(), robot.p_y(), robot.p_z());
@@ -28,23 +28,75 @@
 
 #include "protobuf/command.pb.h"
 #include "protobuf/robot.pb.h"
-#include "protobuf/sslsim.h"
-#include <QList>
+#include "protobuf/ssl_simulation_robot_control.pb.h"
 #include <Eigen/Dense>
 #include <Eigen/QR>
 #include <btBulletDynamicsCommon.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
 
-class RNG;
 class SSL_DetectionRobot;
 
 namespace camun {
     namespace simulator {
+        class ErrorAggregator;
+        class FrameNoise;
+        class RobotShapes;
         class SimBall;
         class SimRobot;
         enum class ErrorSource;
     }
 }
 
+/**
+* @class camun::simulator::RobotShapes
+* @brief Collision shapes of a robot, shared by all robots with the same dimensions
+* Bullet only reads the shapes during the simulation, thus they can be used
+* by the robots of several physics worlds at once.
+*/
+class camun::simulator::RobotShapes
+{
+public:
+    /**
+    * @fn RobotShapes::RobotShapes(const robot::Specs &specs)
+    * @brief Builds the robot mesh and the approximations of the robot and the dribbler
+    * @param specs Robot specifications, only the dimensions are used
+    */
+    explicit RobotShapes(const robot::Specs &specs);
+
+    /**
+    * @fn RobotShapes::~RobotShapes()
+    * @brief Deletes the shapes, no robot may use them anymore
+    */
+    ~RobotShapes();
+    RobotShapes(const RobotShapes&) = delete;
+    RobotShapes& operator=(const RobotShapes&) = delete;
+
+    /**
+    * @fn static std::string RobotShapes::key(const robot::Specs &specs)
+    * @brief Identifies the shapes of the specs, equal for specs which only differ in id, mass or capabilities
+    * @param specs Robot specifications
+    * @return Key for shape caches
+    */
+    static std::string key(const robot::Specs &specs);
+
+    /// @brief Compound of the convex hulls of the robot mesh
+    btCollisionShape *detailed() const { return m_detailed; }
+    /// @brief Cylinder approximation of the robot used in the simplified collision mode
+    btCollisionShape *simple() const { return m_simple; }
+    /// @brief Dribbler bar
+    btCollisionShape *dribbler() const { return m_dribbler; }
+
+private:
+    /// @brief All owned shapes, including the parts of the compound
+    std::vector<btCollisionShape*> m_shapes;
+    btCollisionShape *m_detailed;
+    btCollisionShape *m_simple;
+    btCollisionShape *m_dribbler;
+};
+
 /**
 * @class camun::simulator::SimRobot
 * @brief Physics-based simulation of an SSL robot
@@ -52,20 +104,20 @@ namespace camun {
 * in a Bullet physics simulation. It handles robot movement, ball interaction,
 * command processing, and state reporting.
 */
-class camun::simulator::SimRobot: public QObject
+class camun::simulator::SimRobot
 {
-    Q_OBJECT
 public:
     /**
-    * @fn SimRobot::SimRobot(RNG *rng, const robot::Specs &specs, btDiscreteDynamicsWorld *world, const btVector3 &pos, float dir)
+    * @fn SimRobot::SimRobot(const robot::Specs &specs, std::shared_ptr<const RobotShapes> shapes, btDiscreteDynamicsWorld *world, ErrorAggregator *aggregator, const btVector3 &pos, float dir)
     * @brief Constructs a simulated robot
-    * @param rng Random number generator for noise simulation
     * @param specs Robot specifications (dimensions, capabilities, etc.)
+    * @param shapes Collision shapes built for specs, may be shared with other robots
     * @param world Bullet physics world in which the robot exists
+    * @param aggregator Receives the errors caused by commands for this robot
     * @param pos Initial position of the robot
     * @param dir Initial orientation of the robot (radians)
     */
-    SimRobot(RNG *rng, const robot::Specs &specs, btDiscreteDynamicsWorld *world, const btVector3 &pos, float dir);
+    SimRobot(const robot::Specs &specs, std::shared_ptr<const RobotShapes> shapes, btDiscreteDynamicsWorld *world, ErrorAggregator *aggregator, const btVector3 &pos, float dir);
 
     /**
     * @fn SimRobot::~SimRobot()
@@ -76,17 +128,6 @@ public:
     SimRobot(const SimRobot&) = delete;
     SimRobot& operator=(const SimRobot&) = delete;
 
-signals:
-    /**
-
-    * @fn void SimRobot::sendSSLSimError(const SSLSimError& error, ErrorSource s)
-    * @brief Signal emitted when a simulation error occurs
-    * @param error Error message to be sent
-    * @param s Source of the error
-    */
-    void sendSSLSimError(const SSLSimError& error, ErrorSource s);
-
-public:
     /**
     * @fn void SimRobot::begin(SimBall *ball, double time)
     * @brief Updates the robot state for a simulation step
@@ -133,17 +174,18 @@ public:
     robot::RadioResponse setCommand(const sslsim::RobotCommand &command, SimBall *ball, bool charge, float rxLoss, float txLoss);
 
     /**
-    * @fn void SimRobot::update(SSL_DetectionRobot *robot, float stddev_p, float stddev_phi, qint64 time, btVector3 positionOffset)
+    * @fn void SimRobot::update(SSL_DetectionRobot *robot, FrameNoise &noise, float stddev_p, float stddev_phi, int64_t time, btVector3 positionOffset)
     * @brief Updates a vision detection packet with robot information
     * Fills the SSL vision detection packet with the robot's position and orientation,
     * adding simulated vision noise.
     * @param robot SSL detection robot message to be filled
+    * @param noise Random numbers of the current vision frame
     * @param stddev_p Standard deviation for position noise
     * @param stddev_phi Standard deviation for orientation noise
     * @param time Current simulation time
     * @param positionOffset Offset to apply to the robot's position
     */
-    void update(SSL_DetectionRobot *robot, float stddev_p, float stddev_phi, qint64 time, btVector3 positionOffset);
+    void update(SSL_DetectionRobot *robot, FrameNoise &noise, float stddev_p, float stddev_phi, int64_t time, btVector3 positionOffset);
 
     /**
     * @fn void SimRobot::update(world::SimRobot *robot, SimBall *ball) const
@@ -153,6 +195,26 @@ public:
     */
     void update(world::SimRobot *robot, SimBall *ball) const;
 
+    /**
+    * @fn void SimRobot::writeState(float *state) const
+    * @brief Writes the pose and velocity of the body to a flat buffer
+    * Uses the coordinates of the world state: x, y, orientation, v_x, v_y and the angular velocity.
+    * The orientation is the forward direction in (-pi, pi], the same angle reset takes.
+    * @param state Buffer for ROBOT_STATE_SIZE values
+    */
+    void writeState(float *state) const;
+
+    /**
+    * @fn void SimRobot::readState(const float *state)
+    * @brief Places the robot at a state written by writeState
+    * Resets the robot like reset and then applies the velocities.
+    * @param state ROBOT_STATE_SIZE values
+    */
+    void readState(const float *state);
+
+    /// @brief Number of values written by writeState
+    static const int ROBOT_STATE_SIZE = 6;
+
     /**
     * @fn void SimRobot::restoreState(const world::SimRobot &robot)
     * @brief Restores the robot's state from a world state message
@@ -190,11 +252,11 @@ public:
     btVector3 dribblerCorner(bool left) const;
 
     /**
-    * @fn qint64 SimRobot::getLastSendTime() const
+    * @fn int64_t SimRobot::getLastSendTime() const
     * @brief Gets the timestamp of the last vision update
     * @return Time of the last vision update
     */
-    qint64 getLastSendTime() const { return m_lastSendTime; }
+    int64_t getLastSendTime() const { return m_lastSendTime; }
 
     /**
     * @fn void SimRobot::setDribbleMode(bool perfectDribbler)
@@ -209,6 +271,45 @@ public:
     */
     void stopDribbling();
 
+    /**
+    * @fn void SimRobot::reset(const btVector3 &pos, float dir)
+    * @brief Moves the robot to a new pose and clears its motion and command state
+    * The rigid bodies are kept, this is used to reuse a robot instead of recreating it.
+    * Safe to call from the physics tick callback.
+    * @param pos New position of the robot
+    * @param dir New orientation of the robot (radians)
+    */
+    void reset(const btVector3 &pos, float dir);
+
+    /**
+    * @fn void SimRobot::addToWorld()
+    * @brief Adds the robot bodies and the dribbler constraint to the physics world
+    */
+    void addToWorld();
+
+    /**
+    * @fn void SimRobot::removeFromWorld()
+    * @brief Removes the robot bodies and all of its constraints from the physics world
+    */
+    void removeFromWorld();
+
+    /**
+    * @fn void SimRobot::setSimplifiedCollision(bool simplified)
+    * @brief Switches the collision level of detail of the robot body
+    * When simplified the body collides as a cylinder with robots and the field,
+    * only a kinematic copy of the detailed hull following the body touches the ball.
+    * The mass and inertia of the robot are not changed.
+    * @param simplified true to use the cylinder, false for the detailed hull everywhere
+    */
+    void setSimplifiedCollision(bool simplified);
+
+    /**
+    * @fn void SimRobot::updateBallProxy()
+    * @brief Moves the detailed hull used against the ball to the current body pose
+    * Has to be called before every physics step while the collision is simplified.
+    */
+    void updateBallProxy();
+
     /**
     * @fn const robot::Specs& SimRobot::specs() const
     * @brief Gets the robot specifications
@@ -292,9 +393,13 @@ private:
     */
     void generateVelocityCoupling();
 
-
-    /// @brief random number generator for noise simulation
-    RNG *m_rng;
+    /**
+    * @fn void SimRobot::resetBody(btRigidBody *body, const btTransform &transform)
+    * @brief Places a body at the given transform at rest and drops its cached contacts
+    * @param body Body to reset
+    * @param transform New world transform of the body
+    */
+    void resetBody(btRigidBody *body, const btTransform &transform);
 
     /// @brief Specifications for the robot like capabilities,dimensions,etc.
     robot::Specs m_specs;
@@ -302,6 +407,9 @@ private:
     /// @brief Bullet physics world in which the robot exists.
     btDiscreteDynamicsWorld *m_world;
 
+    /// @brief Receives the errors caused by commands for this robot
+    ErrorAggregator *m_aggregator;
+
     /// @brief Main rigid body for the robot
     btRigidBody * m_body;
 
@@ -311,8 +419,11 @@ private:
     /// @brief Hinge constraint that connects main dribbler body to the main rigid body.
     btHingeConstraint *m_dribblerConstraint;
 
-    /// @brief collection of collision shapes
-    QList<btCollisionShape*> m_shapes;
+    /// @brief Collision shapes of the bodies
+    std::shared_ptr<const RobotShapes> m_shapes;
+
+    /// @brief Kinematic body with the detailed shape that collides with the ball in the simplified mode
+    btRigidBody *m_ballProxy;
 
     /// @brief Motion state of the main robot body.
     btMotionState * m_motionState;
@@ -362,7 +473,13 @@ private:
     /// @brief  whether the bot is in perfect dribbler mode
     bool m_perfectDribbler = false;
 
-    qint64 m_lastSendTime = 0;
+    /// @brief whether the bodies are currently part of m_world
+    bool m_inWorld = false;
+
+    /// @brief whether the body collides as a cylinder, see setSimplifiedCollision
+    bool m_simplifiedCollision = false;
+
+    int64_t m_lastSendTime = 0;
 
     Eigen::Matrix<float, 4, 3> m_velocityCoupling;
     Eigen::CompleteOrthogonalDecomposition<Eigen::Matrix<float, 4, 3>> m_inverseCoupling;
@@ -0,0 +1,1135 @@
+/***************************************************************************
+ *   Copyright 2020 Michael Eischer, Philipp Nordhus, Andreas Wendler      *
+ *   Robotics Erlangen e.V.                                                *
+ *   http://www.robotics-erlangen.de/                                      *
+ *   info@robotics-erlangen.de                                             *
+ *                                                                         *
+ *   This program is free software: you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation, either version 3 of the License, or     *
+ *   any later version.                                                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#include "simulatorcore.h"
+#include "core/rng.h"
+#include "core/counterrng.h"
+#include "core/coordinates.h"
+#include "protobuf/ssl_wrapper.pb.h"
+#include "protobuf/geometry.h"
+#include "framenoise.h"
+#include "robotpool.h"
+#include "simball.h"
+#include "simfield.h"
+#include "simrobot.h"
+#include "erroraggregator.h"
+#include "worldtemplate.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <limits>
+
+using namespace camun::simulator;
+
+/* Friction and restitution between robots, ball and field: (empirical measurments)
+ * Ball vs. Robot:
+ * Restitution: about 0.60
+ * Friction: trial and error in simulator 0.18 (similar results as in reality)
+ *
+ * Ball vs. Floor:
+ * Restitution: sqrt(h'/h) = sqrt(0.314) = 0.56
+ * Friction: \mu_k = -a / g (while slipping) = 0.35
+ *
+ * Robot vs. Floor:
+ * Restitution and Friction should be as low as possible
+ *
+ * Calculations:
+ * Variables: r: restitution, f: friction
+ * Indices: b: ball; f: floor; r: robot
+ *
+ * r_b * r_f = 0.56
+ * r_b * r_r = 0.60
+ * r_f * r_r = small
+ * => r_b = 1; r_f = 0.56; r_r = 0.60
+ *
+ * f_b * f_f = 0.35
+ * f_b * f_r = 0.22
+ * f_f * f_r = very small
+ * => f_b = 1; f_f = 0.35; f_r = 0.22
+ */
+
+// purposes of the independent random streams of a world, see CounterRNG
+enum RandomStream : uint32_t {
+    STREAM_RADIO_LOSS = 1,
+    STREAM_VISION = 2,
+    STREAM_BALL_SHUFFLE = 3
+};
+
+static int64_t monotonicTime()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// splits the collision detection of each step into its phases to measure them
+class TimedDynamicsWorld : public btDiscreteDynamicsWorld
+{
+public:
+    using btDiscreteDynamicsWorld::btDiscreteDynamicsWorld;
+
+    void performDiscreteCollisionDetection() override
+    {
+        // same as btCollisionWorld::performDiscreteCollisionDetection
+        const int64_t start = monotonicTime();
+        updateAabbs();
+        m_broadphasePairCache->calculateOverlappingPairs(m_dispatcher1);
+        const int64_t broadphaseDone = monotonicTime();
+        btOverlappingPairCache *pairs = m_broadphasePairCache->getOverlappingPairCache();
+        m_dispatcher1->dispatchAllCollisionPairs(pairs, getDispatchInfo(), m_dispatcher1);
+
+        stats.steps++;
+        stats.broadphaseTime += broadphaseDone - start;
+        stats.narrowphaseTime += monotonicTime() - broadphaseDone;
+        stats.pairs += pairs->getNumOverlappingPairs();
+        stats.manifolds += m_dispatcher1->getNumManifolds();
+    }
+
+    CollisionStats stats;
+};
+
+// pairs the dribblers like bullet's default filter does, with the field and with every moving body,
+// the kinematic ball hulls of the simplified robot collision still only touch the ball
+class UnfilteredDribblers : public btOverlapFilterCallback
+{
+public:
+    bool needBroadphaseCollision(btBroadphaseProxy *proxy0, btBroadphaseProxy *proxy1) const override
+    {
+        if ((proxy0->m_collisionFilterGroup & proxy1->m_collisionFilterMask)
+                && (proxy1->m_collisionFilterGroup & proxy0->m_collisionFilterMask)) {
+            return true;
+        }
+        if (proxy0->m_collisionFilterGroup & COLLISION_DRIBBLER) {
+            return pairsWithDribbler(proxy1);
+        }
+        if (proxy1->m_collisionFilterGroup & COLLISION_DRIBBLER) {
+            return pairsWithDribbler(proxy0);
+        }
+        return false;
+    }
+
+private:
+    static bool pairsWithDribbler(const btBroadphaseProxy *proxy)
+    {
+        const btCollisionObject *object = static_cast<const btCollisionObject *>(proxy->m_clientObject);
+        return (proxy->m_collisionFilterGroup & COLLISION_FIELD) || !object->isStaticOrKinematicObject();
+    }
+};
+
+static UnfilteredDribblers unfilteredDribblers;
+
+struct camun::simulator::SimulatorData
+{
+    uint32_t seed;
+    uint32_t world;
+    CounterRNG radioLossRng;
+    CounterRNG visionRng;
+    CounterRNG shuffleRng;
+    FrameNoise frameNoise{&visionRng};
+    btDefaultCollisionConfiguration *collision;
+    btCollisionDispatcher *dispatcher;
+    btBroadphaseInterface *overlappingPairCache;
+    amun::SimulatorSetup::Broadphase broadphase;
+    bool collisionFilters;
+    btSequentialImpulseConstraintSolver *solver;
+    TimedDynamicsWorld *dynamicsWorld;
+    world::Geometry geometry;
+    std::vector<SSL_GeometryCameraCalibration> reportedCameraSetup;
+    std::vector<btVector3> cameraPositions;
+    SimField *field;
+    SimBall *ball;
+    RobotPool *robotPool;
+    SimulatorCore::RobotMap robotsBlue;
+    SimulatorCore::RobotMap robotsYellow;
+    std::map<uint32_t, robot::Specs> specsBlue;
+    std::map<uint32_t, robot::Specs> specsYellow;
+    bool flip;
+    float stddevBall;
+    float stddevBallArea;
+    float stddevRobot;
+    float stddevRobotPhi;
+    float ballDetectionsAtDribbler; // per robot per second
+    bool enableInvisibleBall;
+    float ballVisibilityThreshold;
+    float cameraOverlap;
+    float cameraPositionError;
+    float objectPositionOffset;
+    float robotCommandPacketLoss;
+    float robotReplyPacketLoss;
+    float missingBallDetections;
+    bool dribblePerfect;
+    float missingRobotDetections;
+    bool analyticBallRolling;
+    bool simplifiedRobotCollision;
+};
+
+static btBroadphaseInterface *createBroadphase(amun::SimulatorSetup::Broadphase type, const world::Geometry &geometry, bool collisionFilters)
+{
+    btBroadphaseInterface *broadphase;
+    if (type == amun::SimulatorSetup::AXIS_SWEEP) {
+        btVector3 aabbMin, aabbMax;
+        SimField::worldBounds(geometry, aabbMin, aabbMax);
+        broadphase = new btAxisSweep3(aabbMin, aabbMax);
+    } else {
+        broadphase = new btDbvtBroadphase();
+    }
+    if (!collisionFilters) {
+        broadphase->getOverlappingPairCache()->setOverlapFilterCallback(&unfilteredDribblers);
+    }
+    return broadphase;
+}
+
+static void simulatorTickCallback(btDynamicsWorld *world, btScalar timeStep)
+{
+    SimulatorCore *sim = reinterpret_cast<SimulatorCore *>(world->getWorldUserInfo());
+    sim->handleSimulatorTick(timeStep);
+}
+
+/*!
+ * \class SimulatorCore
+ * \ingroup simulator
+ * \brief %Simulator without event loop, driven by step
+ */
+
+SimulatorCore::SimulatorCore(const amun::SimulatorSetup &setup) :
+    SimulatorCore(setup, SimField::createLayout(setup.geometry()), RobotShapeMap())
+{ }
+
+SimulatorCore::SimulatorCore(const WorldTemplate &world) :
+    SimulatorCore(world.setup(), world.field(), world.robotShapes())
+{
+    setTeam(m_data->robotsBlue, 1.0f, world.team(true), m_data->specsBlue);
+    setTeam(m_data->robotsYellow, -1.0f, world.team(false), m_data->specsYellow);
+    if (world.hasInitialState()) {
+        restoreState(world.initialState());
+    }
+}
+
+SimulatorCore::SimulatorCore(const amun::SimulatorSetup &setup, std::shared_ptr<const FieldLayout> field, const RobotShapeMap &robotShapes) :
+    m_time(0),
+    m_lastSentStatusTime(0),
+    m_charge(false),
+    m_visionDelay(35 * 1000 * 1000),
+    m_visionProcessingTime(5 * 1000 * 1000),
+    m_aggregator(new ErrorAggregator)
+{
+    // setup bullet
+    m_data = new SimulatorData;
+    m_data->geometry.CopyFrom(setup.geometry());
+    m_data->collision = new btDefaultCollisionConfiguration();
+    m_data->dispatcher = new btCollisionDispatcher(m_data->collision);
+    m_data->broadphase = setup.broadphase();
+    m_data->collisionFilters = setup.collision_filters();
+    m_data->overlappingPairCache = createBroadphase(m_data->broadphase, m_data->geometry, m_data->collisionFilters);
+    m_data->solver = new btSequentialImpulseConstraintSolver;
+    m_data->dynamicsWorld = new TimedDynamicsWorld(m_data->dispatcher, m_data->overlappingPairCache, m_data->solver, m_data->collision);
+    m_data->dynamicsWorld->setGravity(btVector3(0.0f, 0.0f, -9.81f * SIMULATOR_SCALE));
+    m_data->dynamicsWorld->setInternalTickCallback(simulatorTickCallback, this, true);
+
+    // the default RNG seed is time based, keep the streams just as unpredictable until seedPRGN is called
+    seedStreams(RNG().uniformInt(), 0);
+
+    setupCameras(setup);
+    m_data->analyticBallRolling = setup.analytic_ball_rolling();
+    m_data->simplifiedRobotCollision = setup.simplified_robot_collision();
+
+    // add field and ball
+    m_data->field = new SimField(m_data->dynamicsWorld, std::move(field));
+    m_data->ball = new SimBall(m_data->dynamicsWorld, m_aggregator);
+    m_data->robotPool = new RobotPool(m_data->dynamicsWorld, m_aggregator, robotShapes);
+    m_data->flip = false;
+    m_data->stddevBall = 0.0f;
+    m_data->stddevBallArea = 0.0f;
+    m_data->stddevRobot = 0.0f;
+    m_data->stddevRobotPhi = 0.0f;
+    m_data->ballDetectionsAtDribbler = 0.0f;
+    m_data->enableInvisibleBall = true;
+    m_data->ballVisibilityThreshold = 0.4;
+    m_data->cameraOverlap = 0.3;
+    m_data->cameraPositionError = 0;
+    m_data->objectPositionOffset = 0;
+    m_data->robotCommandPacketLoss = 0;
+    m_data->robotReplyPacketLoss = 0;
+    m_data->missingBallDetections = 0;
+    m_data->dribblePerfect = false;
+    m_data->missingRobotDetections = 0;
+
+    // no robots after initialisation
+}
+
+// returns all Simrobots in the RobotMap to the pool, does not clear map
+// (just like qDeleteAll would)
+static void releaseAll(RobotPool *pool, const SimulatorCore::RobotMap& map) {
+    for(const auto& e : map) {
+        pool->release(e.second.first);
+    }
+}
+
+SimulatorCore::~SimulatorCore()
+{
+    releaseAll(m_data->robotPool, m_data->robotsBlue);
+    releaseAll(m_data->robotPool, m_data->robotsYellow);
+    delete m_data->robotPool;
+    delete m_data->ball;
+    delete m_data->field;
+    delete m_data->dynamicsWorld;
+    delete m_data->solver;
+    delete m_data->overlappingPairCache;
+    delete m_data->dispatcher;
+    delete m_data->collision;
+    delete m_data;
+    delete m_aggregator;
+}
+
+void SimulatorCore::setupCameras(const amun::SimulatorSetup &setup)
+{
+    m_data->reportedCameraSetup.clear();
+    m_data->cameraPositions.clear();
+    for (const auto& camera : setup.camera_setup()) {
+        m_data->reportedCameraSetup.push_back(camera);
+        Vector visionPosition(camera.derived_camera_world_tx(), camera.derived_camera_world_ty());
+        btVector3 truePosition;
+        coordinates::fromVision(visionPosition, truePosition);
+        truePosition.setZ(camera.derived_camera_world_tz() / 1000.0f);
+        m_data->cameraPositions.push_back(truePosition);
+    }
+}
+
+void SimulatorCore::applySetup(const amun::SimulatorSetup &setup)
+{
+    // the camera tables are cheap, always take them
+    setupCameras(setup);
+    m_data->analyticBallRolling = setup.analytic_ball_rolling();
+    if (!m_data->analyticBallRolling) {
+        m_data->ball->stopAnalytic();
+    }
+    if (setup.simplified_robot_collision() != m_data->simplifiedRobotCollision) {
+        m_data->simplifiedRobotCollision = setup.simplified_robot_collision();
+        for (const RobotMap *robots : {&m_data->robotsBlue, &m_data->robotsYellow}) {
+            for (const auto& it : *robots) {
+                it.second.first->setSimplifiedCollision(m_data->simplifiedRobotCollision);
+            }
+        }
+    }
+    // removed cameras restart their frame numbers if they are added again
+    m_lastFrameNumber.erase(m_lastFrameNumber.lower_bound(m_data->cameraPositions.size()), m_lastFrameNumber.end());
+
+    const bool geometryChanged = setup.geometry().SerializeAsString() != m_data->geometry.SerializeAsString();
+    if (geometryChanged) {
+        // only the static collision objects depend on the geometry,
+        // removing them from the world also drops their contacts with robots and ball
+        m_data->geometry.CopyFrom(setup.geometry());
+        delete m_data->field;
+        m_data->field = new SimField(m_data->dynamicsWorld, m_data->geometry);
+    }
+    // the pair cache only filters new pairs, drop the old ones along with the broadphase
+    const bool filtersChanged = setup.collision_filters() != m_data->collisionFilters;
+    m_data->collisionFilters = setup.collision_filters();
+    // a bounded broadphase is sized for the geometry
+    if (setup.broadphase() != m_data->broadphase || filtersChanged
+            || (geometryChanged && setup.broadphase() == amun::SimulatorSetup::AXIS_SWEEP)) {
+        replaceBroadphase(setup.broadphase());
+    }
+}
+
+void SimulatorCore::replaceBroadphase(amun::SimulatorSetup::Broadphase type)
+{
+    btBroadphaseInterface *oldBroadphase = m_data->overlappingPairCache;
+    btBroadphaseInterface *broadphase = createBroadphase(type, m_data->geometry, m_data->collisionFilters);
+
+    // btCollisionWorld::refreshBroadphaseProxy can't move proxies between broadphases
+    btCollisionObjectArray &objects = m_data->dynamicsWorld->getCollisionObjectArray();
+    for (int i = 0; i < objects.size(); i++) {
+        btCollisionObject *object = objects[i];
+        btBroadphaseProxy *proxy = object->getBroadphaseHandle();
+        const short group = proxy->m_collisionFilterGroup;
+        const short mask = proxy->m_collisionFilterMask;
+        // also releases the contact manifolds of its pairs
+        oldBroadphase->destroyProxy(proxy, m_data->dispatcher);
+
+        btVector3 aabbMin, aabbMax;
+        object->getCollisionShape()->getAabb(object->getWorldTransform(), aabbMin, aabbMax);
+        object->setBroadphaseHandle(broadphase->createProxy(aabbMin, aabbMax, object->getCollisionShape()->getShapeType(),
+                                                            object, group, mask, m_data->dispatcher, nullptr));
+    }
+
+    m_data->dynamicsWorld->setBroadphase(broadphase);
+    m_data->overlappingPairCache = broadphase;
+    m_data->broadphase = type;
+    delete oldBroadphase;
+}
+
+CollisionStats SimulatorCore::collisionStats() const
+{
+    return m_data->dynamicsWorld->stats;
+}
+
+void SimulatorCore::resetCollisionStats()
+{
+    m_data->dynamicsWorld->stats = CollisionStats();
+}
+
+void SimulatorCore::applyCommands()
+{
+    // apply only radio commands that were already received by the robots
+    while (m_radioCommands.size() > 0 && std::get<1>(m_radioCommands.front()) < m_time) {
+        const RadioCommand &commands = m_radioCommands.front();
+        for (const sslsim::RobotCommand& command : std::get<0>(commands).robot_commands()) {
+            if (m_data->robotCommandPacketLoss > 0 && m_data->radioLossRng.uniformFloat(0, 1) <= m_data->robotCommandPacketLoss) {
+                continue;
+            }
+
+            // pass radio command to robot that matches the id
+            const RobotMap& map = std::get<2>(commands) ? m_data->robotsBlue : m_data->robotsYellow;
+            const auto it = map.find(command.id());
+            if (it == map.end()) {
+                continue;
+            }
+            robot::RadioResponse response = it->second.first->setCommand(command, m_data->ball, m_charge,
+                                                                          m_data->robotCommandPacketLoss, m_data->robotReplyPacketLoss);
+            response.set_time(m_time);
+            response.set_is_blue(std::get<2>(commands));
+
+            // only collect valid responses
+            if (response.IsInitialized()) {
+                if (m_data->robotReplyPacketLoss == 0 || m_data->radioLossRng.uniformFloat(0, 1) > m_data->robotReplyPacketLoss) {
+                    m_radioResponses.push_back(std::move(response));
+                }
+            }
+        }
+        m_radioCommands.pop_front();
+    }
+}
+
+void SimulatorCore::applyRobotCommand(bool isBlue, const sslsim::RobotCommand &command)
+{
+    SimRobot *robot = this->robot(isBlue, command.id());
+    if (robot != nullptr) {
+        robot->setCommand(command, m_data->ball, m_charge, 0, 0);
+    }
+}
+
+SimRobot *SimulatorCore::robot(bool isBlue, unsigned int id) const
+{
+    const RobotMap &map = isBlue ? m_data->robotsBlue : m_data->robotsYellow;
+    const auto it = map.find(id);
+    return it == map.end() ? nullptr : it->second.first;
+}
+
+SimBall *SimulatorCore::ball() const
+{
+    return m_data->ball;
+}
+
+void SimulatorCore::step(int64_t dt)
+{
+    m_data->dynamicsWorld->stepSimulation(dt * 1E-9, 10, SUB_TIMESTEP);
+    m_time += dt;
+
+    // only send a vision packet every third frame = 15 ms - epsilon (=half frame)
+    // gives a vision frequency of 66.67Hz
+    if (m_visionEnabled && m_lastSentStatusTime + 12500000 <= m_time) {
+        m_vision.push_back(createVisionPacket());
+        m_lastSentStatusTime = m_time;
+    }
+}
+
+void SimulatorCore::collectOutputs(SimulatorOutput &output)
+{
+    // swap instead of copying, both sides keep their buffers for the next round
+    output.radioResponses.clear();
+    output.radioResponses.swap(m_radioResponses);
+    output.vision.clear();
+    output.vision.swap(m_vision);
+    for (ErrorSource source : {ErrorSource::BLUE, ErrorSource::YELLOW, ErrorSource::CONFIG}) {
+        m_aggregator->takeAggregates(source, output.errors[source]);
+    }
+}
+
+void SimulatorCore::clearVision()
+{
+    m_vision.clear();
+}
+
+static void createRobot(SimulatorCore::RobotMap &list, float x, float y, uint32_t id, SimulatorData* data, const std::map<uint32_t, robot::Specs>& teamSpecs)
+{
+    const robot::Specs &specs = teamSpecs.at(id);
+    SimRobot *robot = data->robotPool->acquire(specs, btVector3(x, y, 0), 0.f);
+    robot->setDribbleMode(data->dribblePerfect);
+    robot->setSimplifiedCollision(data->simplifiedRobotCollision);
+    list[id] = {robot, specs.generation()};
+
+}
+
+void SimulatorCore::resetFlipped(SimulatorCore::RobotMap &robots, float side)
+{
+    // find flipped robots and align them on a line
+    const float x = m_data->geometry.field_width() / 2 - 0.2;
+    float y = m_data->geometry.field_height() / 2 - 0.2;
+
+    for (RobotMap::iterator it = robots.begin(); it != robots.end(); ++it) {
+        SimRobot *robot = it->second.first;
+        if (robot->isFlipped()) {
+            // reset in place, this runs inside the physics tick and must not allocate
+            robot->reset(btVector3(x, side * y, 0), 0.0f);
+        }
+        y -= 0.3;
+    }
+}
+
+// distance from a to the segment from b to c
+static float distanceToSegment(const btVector3 &a, const btVector3 &b, const btVector3 &c)
+{
+    const btVector3 segment = c - b;
+    const float length2 = segment.length2();
+    const float t = length2 > 0 ? std::clamp((a - b).dot(segment) / length2, 0.0f, 1.0f) : 0.0f;
+    return (a - (b + segment * t)).length();
+}
+
+void SimulatorCore::updateAnalyticBall()
+{
+    SimBall *ball = m_data->ball;
+    if (!ball->isAnalytic() && !ball->isFreeRolling()) {
+        return;
+    }
+
+    // robots close to the remaining path of the ball need bullet for the contact
+    // the margin covers the distance a robot can drive until the next check
+    const float margin = 0.05f;
+    const btVector3 from = ball->position() / SIMULATOR_SCALE;
+    const btVector3 to = ball->rollingStopPosition() / SIMULATOR_SCALE;
+    bool pathBlocked = false;
+    for (const RobotMap *robots : {&m_data->robotsBlue, &m_data->robotsYellow}) {
+        for (const auto& it : *robots) {
+            const SimRobot *robot = it.second.first;
+            const float clearance = robot->specs().radius() + BALL_RADIUS + margin;
+            if (distanceToSegment(robot->position() / SIMULATOR_SCALE, from, to) < clearance) {
+                pathBlocked = true;
+            }
+        }
+    }
+
+    if (ball->isAnalytic() && pathBlocked) {
+        ball->stopAnalytic();
+    } else if (!ball->isAnalytic() && !pathBlocked) {
+        ball->startAnalytic();
+    }
+}
+
+void SimulatorCore::handleSimulatorTick(double timeStep)
+{
+    // has to be done according to bullet wiki
+    m_data->dynamicsWorld->clearForces();
+
+    resetFlipped(m_data->robotsBlue, 1.0f);
+    resetFlipped(m_data->robotsYellow, -1.0f);
+    if (m_data->ball->isInvalid()) {
+        delete m_data->ball;
+        m_data->ball = new SimBall(m_data->dynamicsWorld, m_aggregator);
+    }
+
+    if (m_data->analyticBallRolling) {
+        updateAnalyticBall();
+    }
+
+    // apply commands and forces to ball and robots
+    m_data->ball->begin();
+    for(const auto& pair : m_data->robotsBlue) {
+        pair.second.first->begin(m_data->ball, timeStep);
+        pair.second.first->updateBallProxy();
+    }
+    for(const auto& pair : m_data->robotsYellow) {
+        pair.second.first->begin(m_data->ball, timeStep);
+        pair.second.first->updateBallProxy();
+    }
+
+    // add gravity to all ACTIVE objects
+    // thus has to be done after applying commands
+    m_data->dynamicsWorld->applyGravity();
+}
+
+static bool checkCameraID(const std::size_t cameraId, const btVector3 &p, const std::vector<btVector3> &cameraPositions, const float overlap)
+{
+    float minDistance = std::numeric_limits<float>::max();
+    float ownDistance = 0;
+    for (std::size_t i = 0;i<cameraPositions.size();i++) {
+        // manhattan distance for rectangular camera regions (if the cameras are distributed normally)
+        float distance = std::abs(cameraPositions[i].x() - p.x()) + std::abs(cameraPositions[i].y() - p.y());
+        minDistance = std::min(minDistance, distance);
+        if (i == cameraId) {
+            ownDistance = distance;
+        }
+    }
+    return ownDistance <= minDistance + 2 * overlap;
+}
+
+void SimulatorCore::initializeDetection(SSL_DetectionFrame *detection, std::size_t cameraId)
+{
+    detection->set_frame_number(m_lastFrameNumber[cameraId]++);
+    detection->set_camera_id(cameraId);
+    detection->set_t_capture((m_time + m_visionDelay - m_visionProcessingTime)*1E-9);
+    detection->set_t_sent((m_time + m_visionDelay)*1E-9);
+}
+
+static btVector3 positionOffsetForCamera(float offsetStrength, btVector3 cameraPos)
+{
+    btVector3 cam2d{cameraPos.x(), cameraPos.y(), 0};
+    if (offsetStrength < 1e-9) {
+        // do not produce an offset that tiny
+        return {0, 0, 0};
+    }
+    if (cam2d.length() < offsetStrength ) {
+        // do not normalize a 0 vector
+        return cam2d;
+    }
+    return btVector3(cameraPos.x(), cameraPos.y(), 0).normalized() * offsetStrength;
+}
+
+VisionOutput SimulatorCore::createVisionPacket()
+{
+    const std::size_t numCameras = m_data->reportedCameraSetup.size();
+    world::SimulatorState simState;
+    simState.set_time(m_time);
+
+    std::vector<SSL_DetectionFrame> detections(numCameras);
+    for (std::size_t i = 0;i<numCameras;i++) {
+        initializeDetection(&detections[i], i);
+    }
+
+    // draw all random numbers of this frame at once, the detection code only reads them
+    // per camera: ball (missing check, area, position) and for every robot
+    // missing check, position, orientation and a possible dribbler ball detection
+    const std::size_t numRobots = m_data->robotsBlue.size() + m_data->robotsYellow.size();
+    m_data->frameNoise.generate(numCameras * (3 + numRobots * 6), numCameras * (1 + numRobots * 2));
+
+    auto* ball = simState.mutable_ball();
+    m_data->ball->writeBallState(ball);
+
+    const btVector3 ballPosition = m_data->ball->position() / SIMULATOR_SCALE;
+    if (m_time - m_lastBallSendTime >= m_minBallDetectionTime) {
+        m_lastBallSendTime = m_time;
+
+        for (std::size_t cameraId = 0; cameraId < numCameras; ++cameraId) {
+            // at least one id is always valid
+            if (!checkCameraID(cameraId, ballPosition, m_data->cameraPositions, m_data->cameraOverlap)) {
+                continue;
+            }
+
+            bool missingBall = m_data->missingBallDetections > 0 && m_data->frameNoise.uniform() <= m_data->missingBallDetections;
+            if (missingBall) {
+                continue;
+            }
+
+            // get ball position
+            const btVector3 positionOffset = positionOffsetForCamera(m_data->objectPositionOffset, m_data->cameraPositions[cameraId]);
+            bool visible = m_data->ball->update(detections[cameraId].add_balls(), m_data->frameNoise, m_data->stddevBall, m_data->stddevBallArea, m_data->cameraPositions[cameraId],
+                    m_data->enableInvisibleBall, m_data->ballVisibilityThreshold, positionOffset);
+            if (!visible) {
+                detections[cameraId].clear_balls();
+            }
+        }
+    }
+
+    // get robot positions
+    for (bool teamIsBlue : {true, false}) {
+        auto &team = teamIsBlue ? m_data->robotsBlue : m_data->robotsYellow;
+
+        for (const auto& it : team) {
+            SimRobot* robot = it.second.first;
+            auto* robotProto = teamIsBlue ? simState.add_blue_robots() : simState.add_yellow_robots();
+            robot->update(robotProto, m_data->ball);
+
+            if (m_time - robot->getLastSendTime() >= m_minRobotDetectionTime) {
+                const float timeDiff = (m_time - robot->getLastSendTime()) * 1E-9;
+                const btVector3 robotPos = robot->position() / SIMULATOR_SCALE;
+
+                for (std::size_t cameraId = 0; cameraId < numCameras; ++cameraId) {
+
+                    if (!checkCameraID(cameraId, robotPos, m_data->cameraPositions, m_data->cameraOverlap)) {
+                        continue;
+                    }
+
+                    bool missingRobot = m_data->missingRobotDetections > 0 && m_data->frameNoise.uniform() <= m_data->missingRobotDetections;
+                    if (missingRobot) {
+                        continue;
+                    }
+
+                    const btVector3 positionOffset = positionOffsetForCamera(m_data->objectPositionOffset, m_data->cameraPositions[cameraId]);
+                    if (teamIsBlue) {
+                        robot->update(detections[cameraId].add_robots_blue(), m_data->frameNoise, m_data->stddevRobot, m_data->stddevRobotPhi, m_time, positionOffset);
+                    } else {
+                        robot->update(detections[cameraId].add_robots_yellow(), m_data->frameNoise, m_data->stddevRobot, m_data->stddevRobotPhi, m_time, positionOffset);
+                    }
+
+                    // once in a while, add a ball mis-detection at a corner of the dribbler
+                    // in real games, this happens because the ball detection light beam used by many teams is red
+                    float detectionProb = timeDiff * m_data->ballDetectionsAtDribbler;
+                    if (m_data->ballDetectionsAtDribbler > 0 && m_data->frameNoise.uniform() < detectionProb) {
+                        // always on the right side of the dribbler for now
+                        if (!m_data->ball->addDetection(detections[cameraId].add_balls(), m_data->frameNoise, robot->dribblerCorner(false) / SIMULATOR_SCALE,
+                                                        m_data->stddevRobot, 0, m_data->cameraPositions[cameraId], false, 0, positionOffset)) {
+                            detections[cameraId].mutable_balls()->DeleteSubrange(detections[cameraId].balls_size()-1, 1);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    std::vector<SSL_WrapperPacket> packets;
+    packets.reserve(numCameras);
+
+    // add a wrapper packet for all detections (also for empty ones).
+    // The reason is that other teams might rely on the fact that these detections are in regular intervals.
+    for (auto &frame : detections) {
+
+        // if multiple balls are reported, shuffle them randomly (the tracking might have systematic errors depending on the ball order)
+        if (frame.balls_size() > 1) {
+            std::shuffle(frame.mutable_balls()->begin(), frame.mutable_balls()->end(), m_data->shuffleRng);
+        }
+
+        SSL_WrapperPacket packet;
+        packet.mutable_detection()->CopyFrom(frame);
+        packets.push_back(packet);
+    }
+
+    // add field geometry
+    if (packets.size() == 0) {
+        packets.push_back(SSL_WrapperPacket());
+    }
+    SSL_GeometryData *geometry = packets[0].mutable_geometry();
+    SSL_GeometryFieldSize *field = geometry->mutable_field();
+    convertToSSlGeometry(m_data->geometry, field);
+
+    const btVector3 positionErrorSimScale = btVector3(0.3f, 0.7f, 0.05f).normalized() * m_data->cameraPositionError;
+    btVector3 positionErrorVisionScale{0, 0, positionErrorSimScale.z() * 1000};
+    coordinates::toVision(positionErrorSimScale, positionErrorVisionScale);
+    for (const auto &calibration : m_data->reportedCameraSetup) {
+        auto calib = geometry->add_calib();
+        calib->CopyFrom(calibration);
+        calib->set_derived_camera_world_tx(calib->derived_camera_world_tx() + positionErrorVisionScale.x());
+        calib->set_derived_camera_world_ty(calib->derived_camera_world_ty() + positionErrorVisionScale.y());
+        calib->set_derived_camera_world_tz(calib->derived_camera_world_tz() + positionErrorVisionScale.z());
+    }
+
+    // add ball model to geometry data
+    geometry->mutable_models()->mutable_straight_two_phase()->set_acc_roll(-BALL_ACC_ROLL);
+    geometry->mutable_models()->mutable_straight_two_phase()->set_acc_slide(-BALL_ACC_SLIDE);
+    geometry->mutable_models()->mutable_straight_two_phase()->set_k_switch(BALL_K_SWITCH);
+    geometry->mutable_models()->mutable_chip_fixed_loss()->set_damping_z(0.566);
+    geometry->mutable_models()->mutable_chip_fixed_loss()->set_damping_xy_first_hop(0.715);
+    geometry->mutable_models()->mutable_chip_fixed_loss()->set_damping_xy_other_hops(1);
+
+    // serialize "vision packet"
+    VisionOutput output;
+    output.packets.resize(packets.size());
+    for (std::size_t i = 0; i < packets.size(); ++i) {
+        if (!packets[i].SerializeToString(&output.packets[i])) {
+            output.packets[i].clear();
+        }
+    }
+
+    if (!simState.SerializeToString(&output.trueState)) {
+        output.trueState.clear();
+    }
+    output.time = m_time + m_visionDelay;
+    return output;
+}
+
+void SimulatorCore::queueRadioCommands(const sslsim::RobotControl &commands, bool isBlue, int64_t processingStart)
+{
+    m_radioCommands.emplace_back(commands, processingStart, isBlue);
+}
+
+
+void SimulatorCore::setTeam(SimulatorCore::RobotMap &list, float side, const robot::Team &team, std::map<uint32_t, robot::Specs>& teamSpecs)
+{
+    // remove old team
+    releaseAll(m_data->robotPool, list);
+    list.clear();
+
+    // changing a team is also triggering a tracking reset
+    // thus the old robots will disappear immediatelly
+    // however if the delayed vision packets arrive the old robots will be tracked again
+    // thus after removing a robot from a team it can take 1 simulated second for the robot to disappear
+    // to prevent this remove outdated vision packets, the caller also drops those it has already collected
+    clearVision();
+
+    // align robots on a line
+    const float x = m_data->geometry.field_width() / 2 - 0.2;
+    float y = m_data->geometry.field_height() / 2 - 0.2;
+
+
+    for (int i = 0; i < team.robot_size(); i++) {
+        const robot::Specs& specs = team.robot(i);
+        const auto id = specs.id();
+
+        // (color, robot id) must be unique
+        if (list.count(id) > 0) {
+            std::cerr << "Error: Two ids for the same color, aborting!" << std::endl;
+            continue;
+        }
+        teamSpecs[id].CopyFrom(specs);
+
+
+
+        createRobot(list, x, side * y, id, m_data, teamSpecs);
+        y -= 0.3;
+    }
+}
+
+
+#define FLIP(X, ATTR) do{if(X.has_##ATTR()){X.set_##ATTR(-X.ATTR());}} while(0)
+
+void SimulatorCore::moveBall(const sslsim::TeleportBall& ball)
+{
+    // remove the dribbling constraint
+    if (!ball.has_by_force() || !ball.by_force()) {
+        for (const RobotMap *robots : {&m_data->robotsBlue, &m_data->robotsYellow}) {
+            for (const auto& it : *robots) {
+                it.second.first->stopDribbling();
+            }
+        }
+    }
+
+    sslsim::TeleportBall b = ball;
+    if (m_data->flip) {
+        FLIP(b, x);
+        FLIP(b, y);
+        FLIP(b, vx);
+        FLIP(b, vy);
+    }
+
+    if (b.teleport_safely()) {
+        if (!b.has_x() || !b.has_y()) {
+            sslsim::SimulatorError error;
+            error.set_code("TELEPORT_SAFELY_PARTIAL");
+            error.set_message("teleporting the ball safly with partial coordinates is not possible");
+            m_aggregator->aggregate(error, ErrorSource::CONFIG);
+            return;
+        }
+        safelyTeleportBall(b.x(), b.y());
+    }
+
+    m_data->ball->move(b);
+
+}
+
+void SimulatorCore::moveRobot(const sslsim::TeleportRobot &robot) {
+    if (!robot.id().has_team()) return;
+    if (!robot.id().has_id()) return;
+    bool is_blue = robot.id().team() == gameController::Team::BLUE;
+
+    RobotMap& list = is_blue ? m_data->robotsBlue : m_data->robotsYellow;
+    bool isPresent = list.count(robot.id().id()) > 0;
+    std::map<uint32_t, robot::Specs>& teamSpecs = is_blue ? m_data->specsBlue : m_data->specsYellow;
+    if (robot.has_present()) {
+        if (robot.present() && !isPresent) {
+            // add the requested robot
+            if (teamSpecs.count(robot.id().id()) == 0) {
+                sslsim::SimulatorError error;
+                error.set_code("CREATE_UNSPEC_ROBOT");
+                std::string message = "trying to create robot " + std::to_string(robot.id().id());
+                message += ", but no spec for this robot was found";
+                error.set_message(std::move(message));
+                m_aggregator->aggregate(error, ErrorSource::CONFIG);
+            } else if(!robot.has_x() || !robot.has_y()){
+                sslsim::SimulatorError error;
+                error.set_code("CREATE_NOPOS_ROBOT");
+                std::string message = "trying to create robot " + std::to_string(robot.id().id());
+                message += " without giving a position";
+                error.set_message(std::move(message));
+                m_aggregator->aggregate(error, ErrorSource::CONFIG);
+            } else {
+                Vector targetPos;
+                coordinates::fromVision(robot, targetPos);
+                //TODO: check if the given position is fine
+                createRobot(list, targetPos.x, targetPos.y, robot.id().id(), m_data, teamSpecs);
+            }
+        }
+        else if (!robot.present() && isPresent) {
+            //remove the robot
+            auto it = list.find(robot.id().id());
+            m_data->robotPool->release(it->second.first);
+            list.erase(it);
+            return;
+        }
+        else if (!robot.present() && !isPresent) {
+            return;
+        }
+        // Fall though: If the robot is already on the field and needs to be on the field, we just use that robot.
+    } else {
+        if (!isPresent) return;
+    }
+
+    if (list.count(robot.id().id()) == 0) return; // Recheck the list in case the has_present paragraph did change it.
+
+
+    sslsim::TeleportRobot r = robot;
+
+    if (m_data->flip) {
+        FLIP(r, x);
+        FLIP(r, y);
+        FLIP(r, v_x);
+        FLIP(r, v_y);
+    }
+
+    SimRobot* sim_robot = list[robot.id().id()].first;
+    if (!r.has_by_force() || !r.by_force()) {
+        sim_robot->stopDribbling();
+    }
+    sim_robot->move(r);
+}
+
+void SimulatorCore::setFlipped(bool flipped)
+{
+    m_data->flip = flipped;
+}
+
+void SimulatorCore::handleCommand(const amun::Command &command)
+{
+    bool teamOrPerfectDribbleChanged = false;
+
+    if (command.has_simulator()) {
+        const amun::CommandSimulator &sim = command.simulator();
+        if (sim.has_simulator_setup()) {
+            applySetup(sim.simulator_setup());
+        }
+
+        if (sim.has_realism_config()) {
+            auto realism = sim.realism_config();
+            if (realism.has_stddev_ball_p()) {
+                m_data->stddevBall = realism.stddev_ball_p();
+            }
+
+            if (realism.has_stddev_robot_p()) {
+                m_data->stddevRobot = realism.stddev_robot_p();
+            }
+
+            if (realism.has_stddev_robot_phi()) {
+                m_data->stddevRobotPhi = realism.stddev_robot_phi();
+            }
+
+            if (realism.has_stddev_ball_area()) {
+                m_data->stddevBallArea = realism.stddev_ball_area();
+            }
+
+            if (realism.has_dribbler_ball_detections()) {
+                m_data->ballDetectionsAtDribbler = realism.dribbler_ball_detections();
+            }
+
+            if (realism.has_enable_invisible_ball()) {
+                m_data->enableInvisibleBall = realism.enable_invisible_ball();
+            }
+
+            if (realism.has_ball_visibility_threshold()) {
+                m_data->ballVisibilityThreshold = realism.ball_visibility_threshold();
+            }
+
+            if (realism.has_camera_overlap()) {
+                m_data->cameraOverlap = realism.camera_overlap();
+            }
+
+            if (realism.has_camera_position_error()) {
+                m_data->cameraPositionError = realism.camera_position_error();
+            }
+
+            if (realism.has_object_position_offset()) {
+                m_data->objectPositionOffset = realism.object_position_offset();
+            }
+
+            if (realism.has_robot_command_loss()) {
+                m_data->robotCommandPacketLoss = realism.robot_command_loss();
+            }
+
+            if (realism.has_robot_response_loss()) {
+                m_data->robotReplyPacketLoss = realism.robot_response_loss();
+            }
+
+            if (realism.has_missing_ball_detections()) {
+                m_data->missingBallDetections = realism.missing_ball_detections();
+            }
+
+            if (realism.has_missing_robot_detections()) {
+                m_data->missingRobotDetections = realism.missing_robot_detections();
+            }
+
+            if (realism.has_vision_delay()) {
+                m_visionDelay = std::max((int64_t)0, (int64_t)realism.vision_delay());
+            }
+
+            if (realism.has_vision_processing_time()) {
+                m_visionProcessingTime = std::max((int64_t)0, (int64_t)realism.vision_processing_time());
+            }
+
+            if (realism.has_simulate_dribbling()) {
+                m_data->dribblePerfect = !realism.simulate_dribbling();
+                teamOrPerfectDribbleChanged = true;
+            }
+        }
+
+        if (sim.has_ssl_control()) {
+            const auto& sslControl = sim.ssl_control();
+            if (sslControl.has_teleport_ball()) {
+                moveBall(sslControl.teleport_ball());
+            }
+            for (const auto& moveR : sslControl.teleport_robot()) {
+                moveRobot(moveR);
+            }
+        }
+
+        if (sim.has_vision_worst_case()) {
+            if (sim.vision_worst_case().has_min_ball_detection_time()) {
+                m_minBallDetectionTime = sim.vision_worst_case().min_ball_detection_time() * 1E9;
+            }
+            if (sim.vision_worst_case().has_min_robot_detection_time()) {
+                m_minRobotDetectionTime = sim.vision_worst_case().min_robot_detection_time() * 1E9;
+            }
+        }
+
+        if (sim.has_set_simulator_state()) {
+            restoreState(sim.set_simulator_state());
+        }
+    }
+
+    if (command.has_transceiver()) {
+        const amun::CommandTransceiver &t = command.transceiver();
+        if (t.has_charge()) {
+            m_charge = t.charge();
+        }
+    }
+
+    if (command.has_set_team_blue()) {
+        teamOrPerfectDribbleChanged = true;
+        setTeam(m_data->robotsBlue, 1.0f, command.set_team_blue(), m_data->specsBlue);
+    }
+
+    if (command.has_set_team_yellow()) {
+        teamOrPerfectDribbleChanged = true;
+        setTeam(m_data->robotsYellow, -1.0f, command.set_team_yellow(), m_data->specsYellow);
+    }
+
+    if (teamOrPerfectDribbleChanged) {
+        for (const RobotMap *robots : {&m_data->robotsBlue, &m_data->robotsYellow}) {
+            for (const auto& it : *robots) {
+                SimRobot *robot = it.second.first;
+                robot->setDribbleMode(m_data->dribblePerfect);
+            }
+        }
+    }
+}
+
+void SimulatorCore::restoreState(const world::SimulatorState &state)
+{
+    if (state.has_ball()) {
+        m_data->ball->restoreState(state.ball());
+    }
+    const auto restoreRobots = [](RobotMap& map, auto robots) {
+        for(const auto& robot: robots) {
+            const auto it = map.find(robot.id());
+            if (it != map.end()) {
+                it->second.first->restoreState(robot);
+            }
+        }
+    };
+    restoreRobots(m_data->robotsYellow, state.yellow_robots());
+    restoreRobots(m_data->robotsBlue, state.blue_robots());
+}
+
+void SimulatorCore::seedPRGN(uint32_t seed, uint32_t world)
+{
+    seedStreams(seed, world);
+}
+
+void SimulatorCore::seedStreams(uint32_t seed, uint32_t world)
+{
+    m_data->seed = seed;
+    m_data->world = world;
+    m_data->radioLossRng = CounterRNG::stream(seed, world, 0, STREAM_RADIO_LOSS);
+    m_data->visionRng = CounterRNG::stream(seed, world, 0, STREAM_VISION);
+    m_data->shuffleRng = CounterRNG::stream(seed, world, 0, STREAM_BALL_SHUFFLE);
+}
+
+static bool overlapCheck(const btVector3& p0, const float& r0, const btVector3& p1, const float& r1)
+{
+    const float distance = (p1 - p0).length();
+    return distance <= r0+r1;
+}
+
+// uses the real world scale
+void SimulatorCore::teleportRobotToFreePosition(SimRobot *robot)
+{
+    btVector3 robotPos = robot->position() / SIMULATOR_SCALE;
+    btVector3 direction = (robotPos - m_data->ball->position() / SIMULATOR_SCALE).normalize();
+    float distance = 2 * (BALL_RADIUS + robot->specs().radius());
+    bool valid = true;
+    do {
+        valid = true;
+        robotPos = robotPos + 2 * direction*distance;
+
+        for (const RobotMap *robots : {&m_data->robotsBlue, &m_data->robotsYellow}) {
+            for (const auto& it : *robots) {
+                SimRobot *robot2 = it.second.first;
+                if (robot == robot2) {
+                    continue;
+                }
+
+                btVector3 tmp = robot2->position() / SIMULATOR_SCALE;
+                if (overlapCheck(robotPos, robot->specs().radius(), tmp, robot2->specs().radius())) {
+                    valid = false;
+                    break;
+                }
+            }
+            if (!valid) {
+                break;
+            }
+        }
+    } while(!valid);
+
+    sslsim::TeleportRobot robotCommand;
+    robotCommand.mutable_id()->set_id(robot->specs().id());
+    coordinates::toVision(robotPos, robotCommand);
+
+    robotCommand.set_v_x(0);
+    robotCommand.set_v_y(0);
+    robot->move(robotCommand);
+}
+
+void SimulatorCore::safelyTeleportBall(const float x, const float y)
+{
+    // remove the speed of all robots in this radius to avoid them running over the ball
+    const float STOP_ROBOTS_RADIUS = 1.5f;
+
+    btVector3 newBallPos(x, y, 0);
+    for (const RobotMap *robots : {&m_data->robotsBlue, &m_data->robotsYellow}) {
+        for (const auto& it : *robots) {
+            SimRobot* robot = it.second.first;
+            btVector3 robotPos = robot->position() / SIMULATOR_SCALE;
+            if (overlapCheck(newBallPos, BALL_RADIUS, robotPos, robot->specs().radius())) {
+                teleportRobotToFreePosition(robot);
+            } else if (overlapCheck(newBallPos, STOP_ROBOTS_RADIUS, robotPos, robot->specs().radius())) {
+                // set the speed to zero but keep the robot where it is
+                sslsim::TeleportRobot robotCommand;
+                robotCommand.mutable_id()->set_id(robot->specs().id());
+                robotCommand.set_v_x(0);
+                robotCommand.set_v_y(0);
+                robot->move(robotCommand);
+            }
+        }
+    }
+}
@@ -0,0 +1,223 @@
+/***************************************************************************
+ *   Copyright 2026 Kuruk contributors                                     *
+ *                                                                         *
+ *   This program is free software: you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation, either version 3 of the License, or     *
+ *   any later version.                                                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#include "vectorenv.h"
+#include "worldtemplate.h"
+#include "core/counterrng.h"
+#include "protobuf/robot.h"
+#include "simball.h"
+#include "simrobot.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace camun::simulator;
+
+// follows the RandomStream purposes used by SimulatorCore, the object is the episode
+static const uint32_t STREAM_RESET = 4;
+
+// robots of a team are placed on a grid of this many columns in their half
+static const int RESET_COLUMNS = 4;
+static const float RESET_JITTER = 0.15f;
+static const int RESET_BALL_TRIES = 10;
+
+VectorEnv::VectorEnv(int envs, const Config &config) :
+    m_config(config),
+    m_steps(envs, 0),
+    m_episodes(envs, 0)
+{
+    robot::Team team;
+    for (int i = 0; i < m_config.robotsPerTeam; i++) {
+        robot::Specs *specs = team.add_robot();
+        robotSetDefault(specs);
+        specs->set_id(i);
+    }
+    // the field and robot shapes are built once for all environments
+    const WorldTemplate world(m_config.setup, team, team);
+
+    // kicks need charged capacitors
+    amun::Command command;
+    command.mutable_transceiver()->set_charge(true);
+
+    m_cores.reserve(envs);
+    for (int env = 0; env < envs; env++) {
+        SimulatorCore *core = new SimulatorCore(world);
+        core->seedPRGN(m_config.seed, env);
+        core->setVisionEnabled(false);
+        core->handleCommand(command);
+        m_cores.push_back(core);
+    }
+}
+
+VectorEnv::~VectorEnv()
+{
+    for (SimulatorCore *core : m_cores) {
+        delete core;
+    }
+}
+
+int VectorEnv::observationSize() const
+{
+    return SimBall::BALL_STATE_SIZE + robots() * SimRobot::ROBOT_STATE_SIZE;
+}
+
+void VectorEnv::reset(float *observations)
+{
+    for (int env = 0; env < envs(); env++) {
+        resetEnv(env);
+        observe(env, observations + env * observationSize());
+    }
+}
+
+void VectorEnv::step(const float *actions, float *observations, uint8_t *dones, float *finalObservations)
+{
+    const world::Geometry &geometry = m_config.setup.geometry();
+    const float halfWidth = geometry.field_width() / 2 + BALL_RADIUS;
+    const float halfHeight = geometry.field_height() / 2 + BALL_RADIUS;
+
+    for (int env = 0; env < envs(); env++) {
+        SimulatorCore *core = m_cores[env];
+        const float *action = actions + env * actionSize();
+        for (int i = 0; i < robots(); i++, action += ACTION_SIZE) {
+            const bool isBlue = i < m_config.robotsPerTeam;
+            m_command.set_id(isBlue ? i : i - m_config.robotsPerTeam);
+            sslsim::MoveLocalVelocity *velocity = m_command.mutable_move_command()->mutable_local_velocity();
+            velocity->set_forward(action[0]);
+            velocity->set_left(action[1]);
+            velocity->set_angular(action[2]);
+            if (action[3] > 0) {
+                m_command.set_kick_speed(action[3]);
+            } else {
+                m_command.clear_kick_speed();
+            }
+            m_command.set_dribbler_speed(action[4]);
+            core->applyRobotCommand(isBlue, m_command);
+        }
+
+        core->step(m_config.stepTime);
+        // there is nobody to report errors to, drop them
+        core->collectOutputs(m_output);
+        m_steps[env]++;
+
+        float *observation = observations + env * observationSize();
+        observe(env, observation);
+
+        Done done = RUNNING;
+        if (std::abs(observation[0]) > halfWidth || std::abs(observation[1]) > halfHeight) {
+            done = BALL_OUT;
+        } else if (m_steps[env] >= m_config.episodeSteps) {
+            done = TIME_LIMIT;
+        }
+        dones[env] = done;
+
+        if (done != RUNNING) {
+            if (finalObservations) {
+                std::memcpy(finalObservations + env * observationSize(), observation, observationSize() * sizeof(float));
+            }
+            resetEnv(env);
+            observe(env, observation);
+        }
+    }
+}
+
+void VectorEnv::resetEnv(int env)
+{
+    SimulatorCore *core = m_cores[env];
+    CounterRNG rng = CounterRNG::stream(m_config.seed, env, m_episodes[env]++, STREAM_RESET);
+    m_steps[env] = 0;
+
+    const world::Geometry &geometry = m_config.setup.geometry();
+    const float width = geometry.field_width();
+    const float halfHeight = geometry.field_height() / 2;
+    const int rows = (m_config.robotsPerTeam + RESET_COLUMNS - 1) / RESET_COLUMNS;
+
+    for (int i = 0; i < robots(); i++) {
+        const bool isBlue = i < m_config.robotsPerTeam;
+        const int id = isBlue ? i : i - m_config.robotsPerTeam;
+        // blue defends the positive y half
+        const float side = isBlue ? 1.0f : -1.0f;
+        const float x = width * ((id % RESET_COLUMNS + 1) / float(RESET_COLUMNS + 1) - 0.5f)
+                + rng.uniformFloat(-RESET_JITTER, RESET_JITTER);
+        const float y = side * halfHeight * (id / RESET_COLUMNS + 1) / float(rows + 1)
+                + rng.uniformFloat(-RESET_JITTER, RESET_JITTER);
+        core->robot(isBlue, id)->reset(btVector3(x, y, 0), rng.uniformFloat(-M_PI, M_PI));
+    }
+
+    // keep the ball clear of the robots, give up after a few tries and let the physics push it away
+    float ballX = 0, ballY = 0;
+    for (int tries = 0; tries < RESET_BALL_TRIES; tries++) {
+        ballX = rng.uniformFloat(-width / 4, width / 4);
+        ballY = rng.uniformFloat(-halfHeight / 2, halfHeight / 2);
+        bool free = true;
+        for (int i = 0; i < robots() && free; i++) {
+            const bool isBlue = i < m_config.robotsPerTeam;
+            const SimRobot *robot = core->robot(isBlue, isBlue ? i : i - m_config.robotsPerTeam);
+            const btVector3 robotPos = robot->position() / SIMULATOR_SCALE;
+            const float clearance = robot->specs().radius() + 2 * BALL_RADIUS;
+            free = std::hypot(robotPos.x() - ballX, robotPos.y() - ballY) > clearance;
+        }
+        if (free) {
+            break;
+        }
+    }
+
+    world::SimBall ball;
+    ball.set_p_x(ballX);
+    ball.set_p_y(ballY);
+    ball.set_p_z(BALL_RADIUS);
+    ball.set_v_x(0);
+    ball.set_v_y(0);
+    ball.set_v_z(0);
+    core->ball()->restoreState(ball);
+}
+
+void VectorEnv::observe(float *observations) const
+{
+    for (int env = 0; env < envs(); env++) {
+        observe(env, observations + env * observationSize());
+    }
+}
+
+void VectorEnv::setState(int env, const float *observation)
+{
+    SimulatorCore *core = m_cores[env];
+    world::SimBall ball;
+    ball.set_p_x(observation[0]);
+    ball.set_p_y(observation[1]);
+    ball.set_p_z(observation[2]);
+    ball.set_v_x(observation[3]);
+    ball.set_v_y(observation[4]);
+    ball.set_v_z(observation[5]);
+    core->ball()->restoreState(ball);
+
+    observation += SimBall::BALL_STATE_SIZE;
+    for (int i = 0; i < robots(); i++, observation += SimRobot::ROBOT_STATE_SIZE) {
+        const bool isBlue = i < m_config.robotsPerTeam;
+        core->robot(isBlue, isBlue ? i : i - m_config.robotsPerTeam)->readState(observation);
+    }
+}
+
+void VectorEnv::observe(int env, float *observation) const
+{
+    const SimulatorCore *core = m_cores[env];
+    core->ball()->writeState(observation);
+    observation += SimBall::BALL_STATE_SIZE;
+    for (int i = 0; i < robots(); i++, observation += SimRobot::ROBOT_STATE_SIZE) {
+        const bool isBlue = i < m_config.robotsPerTeam;
+        core->robot(isBlue, isBlue ? i : i - m_config.robotsPerTeam)->writeState(observation);
+    }
+}
@@ -0,0 +1,51 @@
+/***************************************************************************
+ *   Copyright 2026 Kuruk contributors                                     *
+ *                                                                         *
+ *   This program is free software: you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation, either version 3 of the License, or     *
+ *   any later version.                                                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#include "worldtemplate.h"
+#include "simfield.h"
+#include "simrobot.h"
+
+using namespace camun::simulator;
+
+/*!
+ * \class WorldTemplate
+ * \ingroup simulator
+ * \brief Prebuilt setup and shapes to instantiate SimulatorCores from
+ */
+
+WorldTemplate::WorldTemplate(const amun::SimulatorSetup &setup, const robot::Team &blue, const robot::Team &yellow,
+                             const world::SimulatorState *initialState) :
+    m_setup(setup),
+    m_blue(blue),
+    m_yellow(yellow),
+    m_hasInitialState(initialState != nullptr),
+    m_field(SimField::createLayout(setup.geometry()))
+{
+    if (initialState) {
+        m_initialState.CopyFrom(*initialState);
+    }
+
+    // robots usually share their dimensions, build each mesh only once
+    for (const robot::Team *team : {&m_blue, &m_yellow}) {
+        for (const robot::Specs &specs : team->robot()) {
+            std::shared_ptr<const RobotShapes> &shapes = m_robotShapes[RobotShapes::key(specs)];
+            if (!shapes) {
+                shapes = std::make_shared<const RobotShapes>(specs);
+            }
+        }
+    }
+}
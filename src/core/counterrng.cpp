@@ -0,0 +1,399 @@
+/***************************************************************************
+ *   Copyright 2026 Kuruk contributors                                     *
+ *                                                                         *
+ *   This program is free software: you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation, either version 3 of the License, or     *
+ *   any later version.                                                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#include "counterrng.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define COUNTERRNG_X86
+#include <immintrin.h>
+#endif
+
+/*!
+ * \class CounterRNG
+ * \ingroup core
+ * \brief Counter based pseudorandom number generator
+ *
+ * J. K. Salmon et al., Parallel Random Numbers: As Easy as 1, 2, 3 (SC11)
+ */
+
+static const uint32_t PHILOX_M0 = 0xD2511F53;
+static const uint32_t PHILOX_M1 = 0xCD9E8D57;
+static const uint32_t PHILOX_W0 = 0x9E3779B9;
+static const uint32_t PHILOX_W1 = 0xBB67AE85;
+
+// random words buffered on the stack by the bulk float functions
+static const std::size_t CHUNK_WORDS = 128;
+
+static inline void philoxRound(uint32_t &c0, uint32_t &c1, uint32_t &c2, uint32_t &c3, uint32_t k0, uint32_t k1)
+{
+    const uint64_t p0 = uint64_t(PHILOX_M0) * c0;
+    const uint64_t p1 = uint64_t(PHILOX_M1) * c2;
+    const uint32_t n0 = uint32_t(p1 >> 32) ^ c1 ^ k0;
+    const uint32_t n2 = uint32_t(p0 >> 32) ^ c3 ^ k1;
+    c1 = uint32_t(p1);
+    c3 = uint32_t(p0);
+    c0 = n0;
+    c2 = n2;
+}
+
+#ifdef COUNTERRNG_X86
+static bool hasAvx2()
+{
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    return avx2;
+}
+#endif
+
+// Box-Muller transform on 24 bit uniform values with cephes style polynomials for log, sin and cos.
+// The AVX2 and the scalar version perform exactly the same IEEE operations in the same order
+// (no fused multiply add), thus both produce bit identical results.
+
+static const float LOG_SQRTHF = 0.707106781186547524f;
+static const float LOG_P[9] = {
+    7.0376836292E-2f, -1.1514610310E-1f, 1.1676998740E-1f, -1.2420140846E-1f, 1.4249322787E-1f,
+    -1.6668057665E-1f, 2.0000714765E-1f, -2.4999993993E-1f, 3.3333331174E-1f
+};
+static const float LOG_Q1 = -2.12194440e-4f;
+static const float LOG_Q2 = 0.693359375f;
+static const float SIN_P[3] = { -1.9515295891E-4f, 8.3321608736E-3f, -1.6666654611E-1f };
+static const float COS_P[3] = { 2.443315711809948E-5f, -1.388731625493765E-3f, 4.166664568298827E-2f };
+static const float TWO_PI = 6.28318530717958647692f;
+static const float INV_2_24 = 1.0f / 16777216.0f;
+
+static inline float floatFromBits(uint32_t bits)
+{
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static inline uint32_t bitsFromFloat(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static void boxMullerScalar(const uint32_t *u1Words, const uint32_t *u2Words, float *z0, float *z1, std::size_t n)
+{
+    for (std::size_t j = 0; j < n; j++) {
+        // u1 in (0, 1] to keep the logarithm finite, u2 in [0, 1)
+        const float u1 = float(int32_t((u1Words[j] >> 8) + 1)) * INV_2_24;
+        const float u2 = float(int32_t(u2Words[j] >> 8)) * INV_2_24;
+
+        // log(u1): split into mantissa in [sqrt(0.5), sqrt(2)) and exponent
+        const uint32_t bits = bitsFromFloat(u1);
+        int32_t e = int32_t((bits >> 23) & 0xff) - 126;
+        float m = floatFromBits((bits & 0x807fffff) | 0x3f000000);
+        const bool small = m < LOG_SQRTHF;
+        e -= small ? 1 : 0;
+        m = (m - 1.0f) + (small ? m : 0.0f);
+        const float fe = float(e);
+        const float z = m * m;
+        float y = LOG_P[0];
+        for (int i = 1; i < 9; i++) {
+            y = y * m + LOG_P[i];
+        }
+        y = (y * m) * z;
+        y = y + LOG_Q1 * fe;
+        y = y - 0.5f * z;
+        const float logU1 = (m + y) + LOG_Q2 * fe;
+        const float r = std::sqrt(-2.0f * logU1);
+
+        // sin and cos of 2 pi u2, the reduction to [-pi/4, pi/4] is exact for 24 bit values
+        const int32_t quadrant = int32_t(u2 * 4.0f + 0.5f);
+        const float x = (u2 - float(quadrant) * 0.25f) * TWO_PI;
+        const float x2 = x * x;
+        const float s = ((((SIN_P[0] * x2 + SIN_P[1]) * x2 + SIN_P[2]) * x2) * x) + x;
+        const float c = (((((COS_P[0] * x2 + COS_P[1]) * x2 + COS_P[2]) * x2) * x2) - 0.5f * x2) + 1.0f;
+        const bool swap = (quadrant & 1) != 0;
+        float sinValue = swap ? c : s;
+        float cosValue = swap ? s : c;
+        sinValue = floatFromBits(bitsFromFloat(sinValue) ^ (uint32_t(quadrant & 2) << 30));
+        cosValue = floatFromBits(bitsFromFloat(cosValue) ^ (uint32_t((quadrant + 1) & 2) << 30));
+
+        z0[j] = r * cosValue;
+        z1[j] = r * sinValue;
+    }
+}
+
+#ifdef COUNTERRNG_X86
+__attribute__((target("avx2")))
+static std::size_t boxMullerAvx2(const uint32_t *u1Words, const uint32_t *u2Words, float *z0, float *z1, std::size_t n)
+{
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256 inv224 = _mm256_set1_ps(INV_2_24);
+    std::size_t j = 0;
+    for (; j + 8 <= n; j += 8) {
+        const __m256i w1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(u1Words + j));
+        const __m256i w2 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(u2Words + j));
+        const __m256 u1 = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_srli_epi32(w1, 8), one)), inv224);
+        const __m256 u2 = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(w2, 8)), inv224);
+
+        const __m256i bits = _mm256_castps_si256(u1);
+        __m256i e = _mm256_sub_epi32(_mm256_and_si256(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(0xff)), _mm256_set1_epi32(126));
+        __m256 m = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(int32_t(0x807fffff))),
+                                                       _mm256_set1_epi32(0x3f000000)));
+        const __m256 small = _mm256_cmp_ps(m, _mm256_set1_ps(LOG_SQRTHF), _CMP_LT_OQ);
+        // the comparison mask is -1 for true
+        e = _mm256_add_epi32(e, _mm256_castps_si256(small));
+        m = _mm256_add_ps(_mm256_sub_ps(m, _mm256_set1_ps(1.0f)), _mm256_and_ps(small, m));
+        const __m256 fe = _mm256_cvtepi32_ps(e);
+        const __m256 z = _mm256_mul_ps(m, m);
+        __m256 y = _mm256_set1_ps(LOG_P[0]);
+        for (int i = 1; i < 9; i++) {
+            y = _mm256_add_ps(_mm256_mul_ps(y, m), _mm256_set1_ps(LOG_P[i]));
+        }
+        y = _mm256_mul_ps(_mm256_mul_ps(y, m), z);
+        y = _mm256_add_ps(y, _mm256_mul_ps(_mm256_set1_ps(LOG_Q1), fe));
+        y = _mm256_sub_ps(y, _mm256_mul_ps(_mm256_set1_ps(0.5f), z));
+        const __m256 logU1 = _mm256_add_ps(_mm256_add_ps(m, y), _mm256_mul_ps(_mm256_set1_ps(LOG_Q2), fe));
+        const __m256 r = _mm256_sqrt_ps(_mm256_mul_ps(_mm256_set1_ps(-2.0f), logU1));
+
+        const __m256i quadrant = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(u2, _mm256_set1_ps(4.0f)), _mm256_set1_ps(0.5f)));
+        const __m256 x = _mm256_mul_ps(_mm256_sub_ps(u2, _mm256_mul_ps(_mm256_cvtepi32_ps(quadrant), _mm256_set1_ps(0.25f))),
+                                       _mm256_set1_ps(TWO_PI));
+        const __m256 x2 = _mm256_mul_ps(x, x);
+        __m256 s = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(SIN_P[0]), x2), _mm256_set1_ps(SIN_P[1]));
+        s = _mm256_add_ps(_mm256_mul_ps(s, x2), _mm256_set1_ps(SIN_P[2]));
+        s = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(s, x2), x), x);
+        __m256 c = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(COS_P[0]), x2), _mm256_set1_ps(COS_P[1]));
+        c = _mm256_add_ps(_mm256_mul_ps(c, x2), _mm256_set1_ps(COS_P[2]));
+        c = _mm256_add_ps(_mm256_sub_ps(_mm256_mul_ps(_mm256_mul_ps(c, x2), x2), _mm256_mul_ps(_mm256_set1_ps(0.5f), x2)),
+                          _mm256_set1_ps(1.0f));
+        const __m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(quadrant, one), one));
+        __m256 sinValue = _mm256_blendv_ps(s, c, swap);
+        __m256 cosValue = _mm256_blendv_ps(c, s, swap);
+        const __m256i two = _mm256_set1_epi32(2);
+        sinValue = _mm256_xor_ps(sinValue, _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(quadrant, two), 30)));
+        cosValue = _mm256_xor_ps(cosValue, _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(_mm256_add_epi32(quadrant, one), two), 30)));
+
+        _mm256_storeu_ps(z0 + j, _mm256_mul_ps(r, cosValue));
+        _mm256_storeu_ps(z1 + j, _mm256_mul_ps(r, sinValue));
+    }
+    return j;
+}
+
+#endif
+
+static void boxMuller(const uint32_t *u1Words, const uint32_t *u2Words, float *z0, float *z1, std::size_t n)
+{
+    std::size_t done = 0;
+#ifdef COUNTERRNG_X86
+    if (hasAvx2()) {
+        done = boxMullerAvx2(u1Words, u2Words, z0, z1, n);
+    }
+#endif
+    boxMullerScalar(u1Words + done, u2Words + done, z0 + done, z1 + done, n - done);
+}
+
+static void philoxBlocksScalar(const uint32_t key[2], uint64_t first, uint32_t object, uint32_t purpose, uint32_t *out, std::size_t blocks)
+{
+    for (std::size_t b = 0; b < blocks; b++) {
+        const uint64_t index = first + b;
+        const uint32_t counter[4] = { uint32_t(index), uint32_t(index >> 32), object, purpose };
+        CounterRNG::block(key, counter, out + 4 * b);
+    }
+}
+
+#ifdef COUNTERRNG_X86
+// high and low halves of the 32 x 32 bit products of all eight lanes
+__attribute__((target("avx2")))
+static inline void mulhilo(__m256i a, __m256i multiplier, __m256i &hi, __m256i &lo)
+{
+    const __m256i even = _mm256_mul_epu32(a, multiplier);
+    const __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), multiplier);
+    lo = _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xaa);
+    hi = _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xaa);
+}
+
+// eight blocks at once, one block per lane
+__attribute__((target("avx2")))
+static std::size_t philoxBlocksAvx2(const uint32_t key[2], uint64_t first, uint32_t object, uint32_t purpose, uint32_t *out, std::size_t blocks)
+{
+    const __m256i m0 = _mm256_set1_epi32(int32_t(PHILOX_M0));
+    const __m256i m1 = _mm256_set1_epi32(int32_t(PHILOX_M1));
+    const __m256i laneOffset = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    std::size_t b = 0;
+    for (; b + 8 <= blocks; b += 8) {
+        const uint64_t index = first + b;
+        __m256i c0 = _mm256_add_epi32(_mm256_set1_epi32(int32_t(uint32_t(index))), laneOffset);
+        // carry into the upper counter word for lanes which wrapped around
+        const __m256i wrapped = _mm256_cmpgt_epi32(_mm256_xor_si256(_mm256_set1_epi32(int32_t(uint32_t(index))), _mm256_set1_epi32(INT32_MIN)),
+                                                   _mm256_xor_si256(c0, _mm256_set1_epi32(INT32_MIN)));
+        __m256i c1 = _mm256_sub_epi32(_mm256_set1_epi32(int32_t(uint32_t(index >> 32))), wrapped);
+        __m256i c2 = _mm256_set1_epi32(int32_t(object));
+        __m256i c3 = _mm256_set1_epi32(int32_t(purpose));
+        uint32_t k0 = key[0], k1 = key[1];
+        for (int round = 0; round < 10; round++) {
+            if (round > 0) {
+                k0 += PHILOX_W0;
+                k1 += PHILOX_W1;
+            }
+            __m256i hi0, lo0, hi1, lo1;
+            mulhilo(c0, m0, hi0, lo0);
+            mulhilo(c2, m1, hi1, lo1);
+            c0 = _mm256_xor_si256(_mm256_xor_si256(hi1, c1), _mm256_set1_epi32(int32_t(k0)));
+            c1 = lo1;
+            c2 = _mm256_xor_si256(_mm256_xor_si256(hi0, c3), _mm256_set1_epi32(int32_t(k1)));
+            c3 = lo0;
+        }
+        // transpose from one word of eight blocks per register to consecutive blocks
+        const __m256i t0 = _mm256_unpacklo_epi32(c0, c1);
+        const __m256i t1 = _mm256_unpackhi_epi32(c0, c1);
+        const __m256i t2 = _mm256_unpacklo_epi32(c2, c3);
+        const __m256i t3 = _mm256_unpackhi_epi32(c2, c3);
+        const __m256i r0 = _mm256_unpacklo_epi64(t0, t2);
+        const __m256i r1 = _mm256_unpackhi_epi64(t0, t2);
+        const __m256i r2 = _mm256_unpacklo_epi64(t1, t3);
+        const __m256i r3 = _mm256_unpackhi_epi64(t1, t3);
+        __m256i *target = reinterpret_cast<__m256i *>(out + 4 * b);
+        _mm256_storeu_si256(target + 0, _mm256_permute2x128_si256(r0, r1, 0x20));
+        _mm256_storeu_si256(target + 1, _mm256_permute2x128_si256(r2, r3, 0x20));
+        _mm256_storeu_si256(target + 2, _mm256_permute2x128_si256(r0, r1, 0x31));
+        _mm256_storeu_si256(target + 3, _mm256_permute2x128_si256(r2, r3, 0x31));
+    }
+    return b;
+}
+#endif
+
+static void philoxBlocks(const uint32_t key[2], uint64_t first, uint32_t object, uint32_t purpose, uint32_t *out, std::size_t blocks)
+{
+    std::size_t done = 0;
+#ifdef COUNTERRNG_X86
+    if (hasAvx2()) {
+        done = philoxBlocksAvx2(key, first, object, purpose, out, blocks);
+    }
+#endif
+    philoxBlocksScalar(key, first + done, object, purpose, out + 4 * done, blocks - done);
+}
+
+CounterRNG::CounterRNG(uint32_t seed, uint32_t world, uint32_t object, uint32_t purpose) :
+    m_key{seed, world},
+    m_object(object),
+    m_purpose(purpose),
+    m_nextBlock(0),
+    m_buffer{0, 0, 0, 0},
+    m_bufferPos(4)
+{
+}
+
+void CounterRNG::block(const uint32_t key[2], const uint32_t counter[4], uint32_t out[4])
+{
+    uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+    uint32_t k0 = key[0], k1 = key[1];
+    for (int round = 0; round < 10; round++) {
+        if (round > 0) {
+            k0 += PHILOX_W0;
+            k1 += PHILOX_W1;
+        }
+        philoxRound(c0, c1, c2, c3, k0, k1);
+    }
+    out[0] = c0;
+    out[1] = c1;
+    out[2] = c2;
+    out[3] = c3;
+}
+
+void CounterRNG::refill()
+{
+    const uint32_t counter[4] = { uint32_t(m_nextBlock), uint32_t(m_nextBlock >> 32), m_object, m_purpose };
+    block(m_key, counter, m_buffer);
+    m_nextBlock++;
+    m_bufferPos = 0;
+}
+
+void CounterRNG::setPosition(uint64_t position)
+{
+    m_nextBlock = position / 4;
+    m_bufferPos = 4;
+    if (position % 4 != 0) {
+        refill();
+        m_bufferPos = position % 4;
+    }
+}
+
+Vector CounterRNG::normalVector(double sigma, double mean)
+{
+    const double u1 = uniformPositive();
+    const double u2 = uniform();
+    // Box-Muller transform (basic form, no rejection)
+    const double r = sigma * std::sqrt(-2.0 * std::log(u1));
+    const double phi = 2.0 * M_PI * u2;
+
+    Vector result;
+    result.x = r * std::cos(phi) + mean;
+    result.y = r * std::sin(phi) + mean;
+    return result;
+}
+
+void CounterRNG::fillUniformInt(uint32_t *out, std::size_t count)
+{
+    std::size_t i = 0;
+    // use up the current block first to stay in sync with uniformInt
+    while (i < count && m_bufferPos < 4) {
+        out[i++] = m_buffer[m_bufferPos++];
+    }
+
+    const std::size_t blocks = (count - i) / 4;
+    philoxBlocks(m_key, m_nextBlock, m_object, m_purpose, out + i, blocks);
+    m_nextBlock += blocks;
+    i += 4 * blocks;
+
+    while (i < count) {
+        out[i++] = uniformInt();
+    }
+}
+
+void CounterRNG::fillUniform(float *out, std::size_t count)
+{
+    uint32_t words[CHUNK_WORDS];
+    for (std::size_t i = 0; i < count; i += CHUNK_WORDS) {
+        const std::size_t n = std::min(count - i, CHUNK_WORDS);
+        fillUniformInt(words, n);
+        for (std::size_t j = 0; j < n; j++) {
+            // 24 bits are exactly representable
+            out[i + j] = (words[j] >> 8) * (1.0f / 16777216.0f);
+        }
+    }
+}
+
+void CounterRNG::fillNormal(float *out, std::size_t count, float sigma, float mean)
+{
+    // pairs of standard normals per chunk, a chunk of n pairs uses n words for u1 followed by n words for u2
+    const std::size_t CHUNK = CHUNK_WORDS / 2;
+    const std::size_t pairs = (count + 1) / 2;
+    uint32_t words[2 * CHUNK];
+    float z0[CHUNK];
+    float z1[CHUNK];
+    for (std::size_t p = 0; p < pairs; p += CHUNK) {
+        const std::size_t n = std::min(pairs - p, CHUNK);
+        fillUniformInt(words, 2 * n);
+        boxMuller(words, words + n, z0, z1, n);
+
+        const std::size_t offset = 2 * p;
+        for (std::size_t j = 0; j < n; j++) {
+            out[offset + 2 * j] = z0[j] * sigma + mean;
+            if (offset + 2 * j + 1 < count) {
+                out[offset + 2 * j + 1] = z1[j] * sigma + mean;
+            }
+        }
+    }
+}
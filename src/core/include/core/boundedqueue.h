@@ -0,0 +1,125 @@
+/***************************************************************************
+ *   Copyright 2026 Kuruk contributors                                     *
+ *                                                                         *
+ *   This program is free software: you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation, either version 3 of the License, or     *
+ *   any later version.                                                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+ #ifndef BOUNDEDQUEUE_H
+ #define BOUNDEDQUEUE_H
+ 
+ #include <atomic>
+ #include <cstddef>
+ #include <memory>
+ 
+ /*!
+  * \class BoundedQueue
+  * \brief Lock-free bounded queue for multiple producers and consumers.
+  *
+  * Array based queue in which every cell carries a sequence number (D. Vyukov's bounded
+  * MPMC queue). Push and pop never block or allocate, they fail if the queue is full or
+  * empty respectively. The capacity is rounded up to the next power of two.
+  */
+ template<typename T>
+ class BoundedQueue
+ {
+ public:
+     explicit BoundedQueue(std::size_t capacity) :
+         m_mask(roundUp(capacity) - 1),
+         m_cells(new Cell[m_mask + 1])
+     {
+         for (std::size_t i = 0; i <= m_mask; i++) {
+             m_cells[i].sequence.store(i, std::memory_order_relaxed);
+         }
+     }
+ 
+     BoundedQueue(const BoundedQueue&) = delete;
+     BoundedQueue& operator=(const BoundedQueue&) = delete;
+ 
+     std::size_t capacity() const { return m_mask + 1; }
+ 
+     /*!
+      * \brief Appends a value.
+      * \param value Value to append, left untouched on failure.
+      * \param position Optional output, position of the value in the total order of pushes.
+      * \return False if the queue is full.
+      */
+     bool push(T &value, std::size_t *position = nullptr)
+     {
+         std::size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+         for (;;) {
+             Cell &cell = m_cells[pos & m_mask];
+             const std::size_t seq = cell.sequence.load(std::memory_order_acquire);
+             const std::ptrdiff_t diff = std::ptrdiff_t(seq) - std::ptrdiff_t(pos);
+             if (diff == 0) {
+                 if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                     cell.value = std::move(value);
+                     cell.sequence.store(pos + 1, std::memory_order_release);
+                     if (position) {
+                         *position = pos;
+                     }
+                     return true;
+                 }
+             } else if (diff < 0) {
+                 return false;
+             } else {
+                 pos = m_enqueuePos.load(std::memory_order_relaxed);
+             }
+         }
+     }
+ 
+     //! Removes the oldest value, returns false if the queue is empty
+     bool pop(T &value)
+     {
+         std::size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+         for (;;) {
+             Cell &cell = m_cells[pos & m_mask];
+             const std::size_t seq = cell.sequence.load(std::memory_order_acquire);
+             const std::ptrdiff_t diff = std::ptrdiff_t(seq) - std::ptrdiff_t(pos + 1);
+             if (diff == 0) {
+                 if (m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                     value = std::move(cell.value);
+                     cell.sequence.store(pos + m_mask + 1, std::memory_order_release);
+                     return true;
+                 }
+             } else if (diff < 0) {
+                 return false;
+             } else {
+                 pos = m_dequeuePos.load(std::memory_order_relaxed);
+             }
+         }
+     }
+ 
+ private:
+     struct Cell {
+         std::atomic<std::size_t> sequence;
+         T value;
+     };
+ 
+     static std::size_t roundUp(std::size_t capacity)
+     {
+         std::size_t size = 2;
+         while (size < capacity) {
+             size *= 2;
+         }
+         return size;
+     }
+ 
+     // keep producer and consumer positions on separate cache lines
+     alignas(64) std::atomic<std::size_t> m_enqueuePos{0};
+     alignas(64) std::atomic<std::size_t> m_dequeuePos{0};
+     const std::size_t m_mask;
+     std::unique_ptr<Cell[]> m_cells;
+ };
+ 
+ #endif // BOUNDEDQUEUE_H
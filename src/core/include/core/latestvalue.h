@@ -0,0 +1,100 @@
+/***************************************************************************
+ *   Copyright 2026 Kuruk contributors                                     *
+ *                                                                         *
+ *   This program is free software: you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation, either version 3 of the License, or     *
+ *   any later version.                                                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+ #ifndef LATESTVALUE_H
+ #define LATESTVALUE_H
+ 
+ #include <atomic>
+ #include <cstddef>
+ #include <cstdint>
+ #include <memory>
+ 
+ /*!
+  * \class LatestValue
+  * \brief Lock-free slot holding the most recent value of a single producer.
+  *
+  * The producer replaces the value, any number of consumers take a reference to the
+  * latest one. Values are shared immutable objects, thus consumers may keep them as long
+  * as they like while the producer continues. Intermediate values a consumer did not
+  * look at are simply skipped, version() tells whether there is something new.
+  *
+  * The value lives in one of Slots cells. A consumer announces itself in the cell it is
+  * about to copy and only copies if the cell is still the published one. The producer only
+  * writes cells which are neither published nor announced, so store never waits unless
+  * Slots - 1 consumers are copying at the very same moment.
+  */
+ template<typename T, std::size_t Slots = 4>
+ class LatestValue
+ {
+     static_assert(Slots >= 2, "the producer needs a cell besides the published one");
+ 
+ public:
+     typedef std::shared_ptr<const T> Pointer;
+ 
+     LatestValue() = default;
+     LatestValue(const LatestValue&) = delete;
+     LatestValue& operator=(const LatestValue&) = delete;
+ 
+     //! Publishes a new value, only one thread may store
+     void store(Pointer value)
+     {
+         const std::size_t current = m_current.load(std::memory_order_seq_cst);
+         std::size_t next = (current + 1) % Slots;
+         for (;;) {
+             if (next != current && m_cells[next].readers.load(std::memory_order_seq_cst) == 0) {
+                 break;
+             }
+             next = (next + 1) % Slots;
+         }
+         // the previous value of the cell is released here, on the producer thread
+         m_cells[next].value = std::move(value);
+         m_current.store(next, std::memory_order_seq_cst);
+         m_version.fetch_add(1, std::memory_order_release);
+     }
+ 
+     //! Returns the latest value, null before the first store
+     Pointer load() const
+     {
+         for (;;) {
+             const std::size_t current = m_current.load(std::memory_order_seq_cst);
+             Cell &cell = m_cells[current];
+             cell.readers.fetch_add(1, std::memory_order_seq_cst);
+             // the cell may have been replaced before the announcement was visible
+             if (m_current.load(std::memory_order_seq_cst) == current) {
+                 Pointer value = cell.value;
+                 cell.readers.fetch_sub(1, std::memory_order_release);
+                 return value;
+             }
+             cell.readers.fetch_sub(1, std::memory_order_release);
+         }
+     }
+ 
+     //! Number of stores so far
+     uint64_t version() const { return m_version.load(std::memory_order_acquire); }
+ 
+ private:
+     struct alignas(64) Cell {
+         std::atomic<std::size_t> readers{0};
+         Pointer value;
+     };
+ 
+     mutable Cell m_cells[Slots];
+     std::atomic<std::size_t> m_current{0};
+     std::atomic<uint64_t> m_version{0};
+ };
+ 
+ #endif // LATESTVALUE_H
@@ -0,0 +1,123 @@
+/***************************************************************************
+ *   Copyright 2026 Kuruk contributors                                     *
+ *                                                                         *
+ *   This program is free software: you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation, either version 3 of the License, or     *
+ *   any later version.                                                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+ #ifndef MAPPEDPROTOBUFFILEREADER_H
+ #define MAPPEDPROTOBUFFILEREADER_H
+ 
+ #include <google/protobuf/message.h>
+ #include <QFile>
+ #include <QString>
+ #include <functional>
+ #include <vector>
+ 
+ /*!
+  * \class MappedProtobufFileReader
+  * \brief Random access reader for files written by ProtobufFileSaver.
+  *
+  * The file is memory mapped and messages are parsed directly from the mapping,
+  * without copying the record into a temporary buffer first. The record offsets are
+  * stored in a sidecar index file (see \ref indexFileName), which is reused as long as
+  * the log file does not change and rebuilt otherwise. An index whose records do not fit
+  * into the log is rebuilt as well.
+  *
+  * All const member functions may be called concurrently.
+  */
+ class MappedProtobufFileReader
+ {
+ public:
+     //! Returns the timestamp of a serialized record
+     typedef std::function<qint64(const char *data, int size)> TimeExtractor;
+     //! Called for every record by \ref forEachParallel
+     typedef std::function<void(int index, const char *data, int size)> RecordFunction;
+ 
+     MappedProtobufFileReader();
+     ~MappedProtobufFileReader();
+     MappedProtobufFileReader(const MappedProtobufFileReader&) = delete;
+     MappedProtobufFileReader& operator=(const MappedProtobufFileReader&) = delete;
+ 
+     /*!
+      * \brief Maps the file and loads or builds the offset index.
+      * \param filename Path to the file.
+      * \param filePrefix Prefix the file was saved with.
+      * \return True if the file was mapped and has the expected prefix and version.
+      */
+     bool open(QString filename, QString filePrefix);
+     void close();
+ 
+     //! Name of the sidecar index belonging to filename
+     static QString indexFileName(QString filename) { return filename + ".idx"; }
+ 
+     //! Number of complete records in the file
+     int count() const { return int(m_offsets.size()); }
+     //! Index of the record returned by the next call of \ref readNext
+     int position() const { return m_position; }
+ 
+     /*!
+      * \brief Sets the record returned by the next call of \ref readNext.
+      * \return False if index is out of range.
+      */
+     bool seekToIndex(int index);
+ 
+     /*!
+      * \brief Seeks to the first record with a timestamp of at least time.
+      *
+      * Performs a binary search, the records must be sorted by time.
+      * \param time Timestamp to search for.
+      * \param extractTime Returns the timestamp of a record.
+      * \return False if all records are older than time.
+      */
+     bool seekToTime(qint64 time, const TimeExtractor &extractTime);
+ 
+     /*!
+      * \brief Parses the next record into message.
+      * \return False at the end of the file or if the record could not be parsed.
+      */
+     bool readNext(google::protobuf::Message &message);
+ 
+     //! Parses the record at index into message
+     bool parse(int index, google::protobuf::Message &message) const;
+ 
+     //! Serialized record at index, points into the mapping
+     const char *recordData(int index) const;
+     int recordSize(int index) const;
+ 
+     /*!
+      * \brief Calls function for every record in [begin, end) on multiple threads.
+      *
+      * The range is split into contiguous parts, one per thread. Records within a part
+      * are visited in order. Returns after all records were visited.
+      * \param threads Number of threads, 0 uses one per core.
+      */
+     void forEachParallel(int begin, int end, const RecordFunction &function, int threads = 0) const;
+ 
+ private:
+     bool loadIndex();
+     //! True if the loaded offsets are ascending and every record lies inside the mapping
+     bool indexInBounds() const;
+     void buildIndex();
+     void saveIndex() const;
+ 
+ private:
+     QFile m_file;
+     const char *m_data = nullptr;   //!< Start of the mapping
+     qint64 m_size = 0;
+     qint64 m_dataStart = 0;         //!< Offset of the first record
+     std::vector<qint64> m_offsets;  //!< Offset of every record's length prefix
+     int m_position = 0;
+ };
+ 
+ #endif // MAPPEDPROTOBUFFILEREADER_H
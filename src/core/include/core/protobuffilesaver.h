@@ -21,12 +21,19 @@
  #ifndef PROTOBUFFILESAVER_H
  #define PROTOBUFFILESAVER_H
  
+ #include "boundedqueue.h"
  #include <google/protobuf/message.h>
  #include <QDataStream>
  #include <QFile>
  #include <QMutex>
  #include <QObject>
  #include <QString>
+ #include <atomic>
+ #include <condition_variable>
+ #include <memory>
+ #include <mutex>
+ #include <string>
+ #include <thread>
  
  /*!
   * \class ProtobufFileSaver
@@ -34,12 +41,38 @@
   *
   * The file is only created when \ref saveMessage is called for the first time.
   * Messages are written sequentially in a binary format using Qt's QDataStream.
+  *
+  * In asynchronous mode (\ref enableAsync) the caller only serializes the message into a
+  * pooled buffer and pushes it onto a lock-free queue. A writer thread coalesces the
+  * queued buffers into large sequential writes. The file format is identical in both modes.
   */
  class ProtobufFileSaver : QObject
  {
      Q_OBJECT
  
  public:
+     //! When to force written data to the disk
+     enum class FsyncPolicy {
+         Never,          //!< Leave it to the operating system
+         OnClose,        //!< Once when the file is closed
+         Periodic,       //!< At most once per AsyncOptions::fsyncInterval, and on close
+         EveryWrite      //!< After every write to the file
+     };
+ 
+     //! What saveMessage does when the queue of the asynchronous writer is full
+     enum class QueueFullPolicy {
+         Block,          //!< Wait for the writer to make room (backpressure)
+         Drop            //!< Discard the message
+     };
+ 
+     struct AsyncOptions {
+         int queueCapacity = 1024;                       //!< Messages in flight, rounded up to a power of two
+         QueueFullPolicy queueFull = QueueFullPolicy::Block;
+         FsyncPolicy fsync = FsyncPolicy::Never;
+         int fsyncInterval = 1000;                       //!< Milliseconds, for FsyncPolicy::Periodic
+         int maxWriteSize = 1024 * 1024;                 //!< Bytes coalesced into a single write
+     };
+ 
      /*!
       * \brief Constructs a ProtobufFileSaver.
       * \param filename Base filename to save to.
@@ -47,37 +80,88 @@
       * \param parent Optional QObject parent.
       */
      ProtobufFileSaver(QString filename, QString filePrefix, QObject *parent = nullptr);
+     ~ProtobufFileSaver() override;
+ 
+     /*!
+      * \brief Switches to asynchronous writing.
+      *
+      * Must be called before the first message is saved.
+      * \param options Queue size, fsync and backpressure settings.
+      */
+     void enableAsync(const AsyncOptions &options);
+     void enableAsync();
+ 
+     /*!
+      * \brief Sets the fsync policy for synchronous mode.
+      * \param policy FsyncPolicy::Periodic is treated like FsyncPolicy::OnClose.
+      */
+     void setFsyncPolicy(FsyncPolicy policy) { m_options.fsync = policy; }
  
      /*!
       * \brief Saves a protobuf message to the file.
       *
       * This function is thread-safe and can be called from any thread.
       * If the file is not yet opened, it will open it first.
+      * In asynchronous mode the returned offset is where the record will be written.
       *
       * \param message The protobuf message to be serialized and written.
+      * \return File offset at which the record starts, or -1 if nothing was written,
+      * which includes every call after \ref close.
       */
-     void saveMessage(const google::protobuf::Message &message);
+     qint64 saveMessage(const google::protobuf::Message &message);
  
      /*!
       * \brief Closes the output file stream.
+      *
+      * In asynchronous mode all queued messages are written first, including those of
+      * saveMessage calls which run concurrently. Later messages are rejected.
       */
-     void close() { m_file.close(); }
+     void close();
+ 
+     //! Messages discarded because the asynchronous queue was full
+     quint64 droppedMessages() const { return m_dropped.load(std::memory_order_relaxed); }
+     //! Messages which had to wait because the asynchronous queue was full
+     quint64 blockedMessages() const { return m_blocked.load(std::memory_order_relaxed); }
  
  private:
      //! Opens the file stream if not already opened.
      void open();
+     qint64 enqueue(const google::protobuf::Message &message);
+     void runWriter();
+     void writeCoalesced(std::string &data);
+     void recycle(std::string *buffer);
+     void wakeWriter();
+     void sync();
  
  private:
      QString m_filename;     //!< Output filename (or base path)
      QString m_filePrefix;   //!< Optional prefix for message entries
      QFile m_file;           //!< Output file handle
      QDataStream m_stream;   //!< Stream for binary writing
-     QMutex m_mutex;         //!< Mutex for thread safety
+     QMutex m_mutex;         //!< Mutex for thread safety (synchronous mode and opening)
      /* 
      * A mutex ensures that only one thread at a time can lock
      * it and enter a critical section of code (like writing
      * to a file or modifying shared data).
      */
+ 
+     // asynchronous mode
+     AsyncOptions m_options;
+     bool m_async = false;
+     std::atomic<bool> m_opened{false};
+     std::atomic<bool> m_closed{false};                      //!< Set by close(), rejects further messages
+     std::atomic<int> m_producers{0};                        //!< Asynchronous saves in progress
+     std::unique_ptr<BoundedQueue<std::string*>> m_queue;    //!< Serialized records, in file order
+     std::unique_ptr<BoundedQueue<std::string*>> m_buffers;  //!< Recycled record buffers
+     std::atomic<std::size_t> m_offsetTicket{0};             //!< Queue position allowed to take the next offset
+     qint64 m_nextOffset = 0;                                //!< File offset of the next queued record
+     std::thread m_writer;
+     std::atomic<bool> m_stopWriter{false};
+     std::atomic<bool> m_writerIdle{false};
+     std::mutex m_wakeupMutex;
+     std::condition_variable m_wakeup;
+     std::atomic<quint64> m_dropped{0};
+     std::atomic<quint64> m_blocked{0};
  };
  
  #endif // PROTOBUFFILESAVER_H
@@ -0,0 +1,103 @@
+/***************************************************************************
+ *   Copyright 2026 Kuruk contributors                                     *
+ *                                                                         *
+ *   This program is free software: you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation, either version 3 of the License, or     *
+ *   any later version.                                                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+ #ifndef SIMULATIONRECORDER_H
+ #define SIMULATIONRECORDER_H
+ 
+ #include "protobuffilesaver.h"
+ #include "protobuf/recording.pb.h"
+ #include "protobuf/sslsim.h"
+ #include <QByteArray>
+ #include <QObject>
+ #include <QString>
+ #include <string>
+ 
+ class Timer;
+ 
+ /*!
+  * \class SimulationRecorder
+  * \brief Records vision, ground truth and radio commands into an indexed, chunked file.
+  *
+  * Records are collected into chunks which are written through a ProtobufFileSaver once
+  * they exceed a duration or size limit. Every chunk carries its time range and a crc32
+  * of its payload. On \ref close an index of all chunks is appended, followed by a fixed
+  * size trailer, which allows SimulationRecordingReader to seek in O(log n).
+  *
+  * The slots are not thread-safe, connect them with queued connections when the
+  * signals are emitted from several threads.
+  */
+ class SimulationRecorder : public QObject
+ {
+     Q_OBJECT
+ 
+ public:
+     static const QString FILE_PREFIX;
+ 
+     /*!
+      * \brief Constructs a SimulationRecorder.
+      * \param filename File to write the recording to.
+      * \param timer Timer used to timestamp records which carry no time of their own.
+      * \param parent Optional QObject parent.
+      */
+     SimulationRecorder(QString filename, const Timer *timer, QObject *parent = nullptr);
+     ~SimulationRecorder() override;
+     SimulationRecorder(const SimulationRecorder&) = delete;
+     SimulationRecorder& operator=(const SimulationRecorder&) = delete;
+ 
+     /*!
+      * \brief Sets the limits after which the current chunk is written.
+      * \param duration Maximum time span of a chunk in nanoseconds.
+      * \param bytes Maximum payload size of a chunk.
+      */
+     void setChunkLimits(qint64 duration, int bytes);
+ 
+     //! crc32 (IEEE 802.3) as stored in recording::Chunk::checksum
+     static quint32 checksum(const std::string &data);
+ 
+ public slots:
+     //! Matches Simulator::gotPacket
+     void recordVisionPacket(const QByteArray &data, qint64 time, QString sender);
+     //! Matches Simulator::sendRealData, a serialized world::SimulatorState
+     void recordSimulatorState(const QByteArray &data);
+     //! Matches RobotCommandAdaptor::sendRadioCommands
+     void recordRadioCommands(const SSLSimRobotControl &control, bool isBlue, qint64 processingStart);
+     //! Writes the pending chunk, the index and the trailer. Further records are ignored.
+     void close();
+ 
+ private:
+     void addRecord(recording::RecordType type, qint64 time, const char *data, int size);
+     void flushChunk();
+ 
+ private:
+     ProtobufFileSaver m_saver;
+     const Timer *m_timer;
+     bool m_closed = false;
+ 
+     qint64 m_maxChunkDuration;
+     int m_maxChunkBytes;
+ 
+     recording::RecordBatch m_batch;     //!< Records of the chunk being collected
+     int m_batchBytes = 0;
+     qint64 m_chunkStart = 0;
+     qint64 m_chunkEnd = 0;
+     quint32 m_frameNumber = 0;          //!< Number of the next record
+     quint32 m_chunkFirstFrame = 0;
+ 
+     recording::Index m_index;
+ };
+ 
+ #endif // SIMULATIONRECORDER_H
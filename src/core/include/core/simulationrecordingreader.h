@@ -0,0 +1,89 @@
+/***************************************************************************
+ *   Copyright 2026 Kuruk contributors                                     *
+ *                                                                         *
+ *   This program is free software: you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation, either version 3 of the License, or     *
+ *   any later version.                                                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+ #ifndef SIMULATIONRECORDINGREADER_H
+ #define SIMULATIONRECORDINGREADER_H
+ 
+ #include "protobuf/recording.pb.h"
+ #include <QDataStream>
+ #include <QFile>
+ #include <QString>
+ 
+ /*!
+  * \class SimulationRecordingReader
+  * \brief Reads recordings written by SimulationRecorder.
+  *
+  * The chunk index is loaded from the end of the file. Recordings which were not closed
+  * properly have no index, in that case it is rebuilt by scanning all chunks once.
+  * Chunks with a checksum mismatch are skipped. A stored index whose chunks are not sorted
+  * by time is treated as corrupt and rebuilt as well.
+  */
+ class SimulationRecordingReader
+ {
+ public:
+     SimulationRecordingReader();
+ 
+     /*!
+      * \brief Opens a recording and loads its index.
+      * \param filename Path to the recording.
+      * \return True if the file is a recording with at least one intact chunk.
+      */
+     bool open(QString filename);
+ 
+     /*!
+      * \brief Positions the reader at the first record with a timestamp of at least time.
+      *
+      * Uses a binary search over the chunk index, only the target chunk is read.
+     * If the chunk end times are not sorted, the index is scanned linearly instead.
+      * \return False if no record at or after time exists.
+      */
+     bool seek(qint64 time);
+ 
+     /*!
+      * \brief Reads the next record.
+      * \return False at the end of the recording.
+      */
+     bool readNext(recording::Record &record);
+ 
+     //! True if the index was read from the file instead of being rebuilt
+     bool hasStoredIndex() const { return m_hasStoredIndex; }
+     int chunkCount() const { return m_index.chunks_size(); }
+     qint64 startTime() const;
+     qint64 endTime() const;
+     //! Identifies the recording, see timeline::FrameDescriptor
+     const timeline::FrameDescriptor &frames() const { return m_index.frames(); }
+ 
+ private:
+     bool readEntry(qint64 offset, recording::Entry &entry);
+     bool readStoredIndex();
+     void rebuildIndex(qint64 dataStart);
+     bool isSorted() const;
+     bool loadChunk(int chunk);
+ 
+ private:
+     QFile m_file;
+     QDataStream m_stream;
+     recording::Index m_index;
+     bool m_hasStoredIndex = false;
+     bool m_sorted = false;            //!< Chunk end times are ascending, seek can bisect
+ 
+     recording::RecordBatch m_batch;   //!< Records of the loaded chunk
+     int m_chunk = -1;                 //!< Index of the loaded chunk
+     int m_record = 0;                 //!< Next record inside the loaded chunk
+ };
+ 
+ #endif // SIMULATIONRECORDINGREADER_H
@@ -0,0 +1,89 @@
+/***************************************************************************
+ *   Copyright 2026 Kuruk contributors                                     *
+ *                                                                         *
+ *   This program is free software: you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation, either version 3 of the License, or     *
+ *   any later version.                                                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+ #ifndef WORLDSNAPSHOT_H
+ #define WORLDSNAPSHOT_H
+ 
+ #include "latestvalue.h"
+ #include "protobuf/ssl_detection.pb.h"
+ #include "protobuf/ssl_geometry.pb.h"
+ #include <QtGlobal>
+ #include <memory>
+ #include <vector>
+ 
+ /*!
+  * \struct WorldSnapshot
+  * \brief Immutable view of everything the vision system reported so far.
+  *
+  * Holds the latest detection frame of every camera and the latest geometry. The protobuf
+  * messages are shared between successive snapshots, a datagram is parsed only once no
+  * matter how many snapshots and consumers see it.
+  */
+ struct WorldSnapshot
+ {
+     //! Latest frame of a camera
+     struct Camera {
+         std::shared_ptr<const SSL_DetectionFrame> frame;
+         qint64 receiveTime; //!< Time at which the frame arrived, in nanoseconds
+     };
+ 
+     quint64 sequence = 0;     //!< Number of packets merged into this snapshot
+     qint64 receiveTime = 0;   //!< Arrival time of the newest packet, in nanoseconds
+     std::shared_ptr<const SSL_GeometryData> geometry; //!< Null until the first geometry packet
+     std::vector<Camera> cameras; //!< Sorted by camera id
+ };
+ 
+ typedef std::shared_ptr<const WorldSnapshot> WorldSnapshotPtr;
+ typedef LatestValue<WorldSnapshot> WorldSnapshotSlot;
+ 
+ /*!
+  * \class WorldSnapshotBuilder
+  * \brief Merges serialized SSL_WrapperPackets into successive WorldSnapshots.
+  *
+  * Not thread-safe, the builder belongs to the thread which receives the packets.
+  */
+ class WorldSnapshotBuilder
+ {
+ public:
+     /*!
+      * \brief Sets after which time without a new frame a camera is dropped.
+      * \param timeout Timeout in nanoseconds, the default is one second.
+      */
+     void setCameraTimeout(qint64 timeout) { m_cameraTimeout = timeout; }
+ 
+     /*!
+      * \brief Parses a packet and merges it into the previous snapshot.
+      * \param data Serialized SSL_WrapperPacket
+      * \param size Size of data in bytes
+      * \param receiveTime Arrival time of the packet, in nanoseconds
+      * \return The new snapshot, null if the packet could not be parsed
+      */
+     WorldSnapshotPtr addPacket(const char *data, int size, qint64 receiveTime);
+ 
+     //! Returns the latest snapshot, null before the first packet
+     WorldSnapshotPtr snapshot() const { return m_snapshot; }
+ 
+     //! Forgets all cameras and the geometry, e.g. after jumping in a replay
+     void clear();
+ 
+ private:
+     WorldSnapshotPtr m_snapshot;
+     quint64 m_sequence = 0;
+     qint64 m_cameraTimeout = 1000000000;
+ };
+ 
+ #endif // WORLDSNAPSHOT_H
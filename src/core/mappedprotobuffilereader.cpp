@@ -0,0 +1,269 @@
+/***************************************************************************
+ *   Copyright 2026 Kuruk contributors                                     *
+ *                                                                         *
+ *   This program is free software: you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation, either version 3 of the License, or     *
+ *   any later version.                                                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#include "mappedprotobuffilereader.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QtEndian>
+#include <algorithm>
+#include <thread>
+
+// increment when the layout of the index file changes
+static const quint32 INDEX_MAGIC = 0x50424958; // "PBIX"
+static const qint32 INDEX_VERSION = 1;
+
+// QDataStream writes a QByteArray as big endian length followed by the data,
+// a null array has the length 0xFFFFFFFF
+static const int LENGTH_SIZE = 4;
+static const quint32 NULL_LENGTH = 0xFFFFFFFF;
+
+MappedProtobufFileReader::MappedProtobufFileReader()
+{ }
+
+MappedProtobufFileReader::~MappedProtobufFileReader()
+{
+    close();
+}
+
+bool MappedProtobufFileReader::open(QString filename, QString filePrefix)
+{
+    close();
+    m_file.setFileName(filename);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream stream(&m_file);
+    // ensure compatibility across qt versions
+    stream.setVersion(QDataStream::Qt_4_6);
+    QString fileType;
+    int version;
+    stream >> fileType >> version;
+    if (stream.status() != QDataStream::Ok || fileType != filePrefix || version != 0) {
+        close();
+        return false;
+    }
+    m_dataStart = m_file.pos();
+
+    m_size = m_file.size();
+    m_data = reinterpret_cast<const char*>(m_file.map(0, m_size));
+    if (!m_data) {
+        close();
+        return false;
+    }
+
+    if (!loadIndex()) {
+        buildIndex();
+        saveIndex();
+    }
+    m_position = 0;
+    return true;
+}
+
+void MappedProtobufFileReader::close()
+{
+    if (m_data) {
+        m_file.unmap(reinterpret_cast<uchar*>(const_cast<char*>(m_data)));
+        m_data = nullptr;
+    }
+    m_file.close();
+    m_size = 0;
+    m_offsets.clear();
+    m_position = 0;
+}
+
+bool MappedProtobufFileReader::loadIndex()
+{
+    QFile indexFile(indexFileName(m_file.fileName()));
+    if (!indexFile.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream stream(&indexFile);
+    stream.setVersion(QDataStream::Qt_4_6);
+
+    quint32 magic;
+    qint32 version;
+    qint64 fileSize, lastModified, dataStart;
+    quint32 count;
+    stream >> magic >> version >> fileSize >> lastModified >> dataStart >> count;
+    const qint64 modified = QFileInfo(m_file).lastModified().toMSecsSinceEpoch();
+    if (stream.status() != QDataStream::Ok || magic != INDEX_MAGIC || version != INDEX_VERSION
+            || fileSize != m_size || lastModified != modified || dataStart != m_dataStart) {
+        return false;
+    }
+    // every record takes at least its length, a larger count can't belong to this file
+    if (count > quint64(m_size - m_dataStart) / LENGTH_SIZE) {
+        return false;
+    }
+
+    m_offsets.resize(count);
+    for (qint64 &offset : m_offsets) {
+        stream >> offset;
+    }
+    if (stream.status() != QDataStream::Ok || !indexInBounds()) {
+        m_offsets.clear();
+        return false;
+    }
+    return true;
+}
+
+bool MappedProtobufFileReader::indexInBounds() const
+{
+    // a stale or corrupted index must not point past the mapping
+    qint64 end = m_dataStart;
+    for (qint64 offset : m_offsets) {
+        if (offset < end || offset > m_size - LENGTH_SIZE) {
+            return false;
+        }
+        quint32 length = qFromBigEndian<quint32>(m_data + offset);
+        if (length == NULL_LENGTH) {
+            length = 0;
+        }
+        end = offset + LENGTH_SIZE + qint64(length);
+        if (end > m_size) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void MappedProtobufFileReader::buildIndex()
+{
+    m_offsets.clear();
+    qint64 offset = m_dataStart;
+    while (offset + LENGTH_SIZE <= m_size) {
+        quint32 length = qFromBigEndian<quint32>(m_data + offset);
+        if (length == NULL_LENGTH) {
+            length = 0;
+        }
+        // a truncated last record is not part of the index
+        if (offset + LENGTH_SIZE + qint64(length) > m_size) {
+            break;
+        }
+        m_offsets.push_back(offset);
+        offset += LENGTH_SIZE + length;
+    }
+}
+
+void MappedProtobufFileReader::saveIndex() const
+{
+    // the index is only a cache, failing to write it is not an error
+    QFile indexFile(indexFileName(m_file.fileName()));
+    if (!indexFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return;
+    }
+    QDataStream stream(&indexFile);
+    stream.setVersion(QDataStream::Qt_4_6);
+
+    const qint64 modified = QFileInfo(m_file).lastModified().toMSecsSinceEpoch();
+    stream << INDEX_MAGIC << INDEX_VERSION << m_size << modified << m_dataStart << quint32(m_offsets.size());
+    for (qint64 offset : m_offsets) {
+        stream << offset;
+    }
+}
+
+const char *MappedProtobufFileReader::recordData(int index) const
+{
+    return m_data + m_offsets[index] + LENGTH_SIZE;
+}
+
+int MappedProtobufFileReader::recordSize(int index) const
+{
+    const quint32 length = qFromBigEndian<quint32>(m_data + m_offsets[index]);
+    return length == NULL_LENGTH ? 0 : int(length);
+}
+
+bool MappedProtobufFileReader::parse(int index, google::protobuf::Message &message) const
+{
+    if (index < 0 || index >= count()) {
+        return false;
+    }
+    return message.ParseFromArray(recordData(index), recordSize(index));
+}
+
+bool MappedProtobufFileReader::seekToIndex(int index)
+{
+    if (index < 0 || index >= count()) {
+        return false;
+    }
+    m_position = index;
+    return true;
+}
+
+bool MappedProtobufFileReader::seekToTime(qint64 time, const TimeExtractor &extractTime)
+{
+    int first = 0;
+    int last = count();
+    while (first < last) {
+        const int middle = first + (last - first) / 2;
+        if (extractTime(recordData(middle), recordSize(middle)) < time) {
+            first = middle + 1;
+        } else {
+            last = middle;
+        }
+    }
+    if (first >= count()) {
+        return false;
+    }
+    m_position = first;
+    return true;
+}
+
+bool MappedProtobufFileReader::readNext(google::protobuf::Message &message)
+{
+    if (m_position >= count()) {
+        return false;
+    }
+    return parse(m_position++, message);
+}
+
+void MappedProtobufFileReader::forEachParallel(int begin, int end, const RecordFunction &function, int threads) const
+{
+    begin = std::max(begin, 0);
+    end = std::min(end, count());
+    if (begin >= end) {
+        return;
+    }
+    if (threads <= 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = std::min(threads, end - begin);
+
+    auto visit = [this, &function](int from, int to) {
+        for (int i = from; i < to; i++) {
+            function(i, recordData(i), recordSize(i));
+        }
+    };
+
+    const int perThread = (end - begin + threads - 1) / threads;
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    for (int t = 1; t < threads; t++) {
+        const int from = begin + t * perThread;
+        const int to = std::min(end, from + perThread);
+        if (from < to) {
+            workers.emplace_back(visit, from, to);
+        }
+    }
+    // the calling thread takes the first part
+    visit(begin, std::min(end, begin + perThread));
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+}
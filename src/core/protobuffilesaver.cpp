@@ -21,6 +21,23 @@
 #include "protobuffilesaver.h"
 
 #include <QDebug>
+#include <QtEndian>
+#include <chrono>
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
+#ifdef Q_OS_WIN
+#include <io.h>
+#endif
+
+namespace {
+    // counts a thread as saving until it leaves the scope
+    struct ProducerGuard {
+        explicit ProducerGuard(std::atomic<int> &count) : count(count) { count.fetch_add(1); }
+        ~ProducerGuard() { count.fetch_sub(1); }
+        std::atomic<int> &count;
+    };
+}
 
 ProtobufFileSaver::ProtobufFileSaver(QString filename, QString filePrefix, QObject *parent) :
     QObject(parent),
@@ -30,6 +47,35 @@ ProtobufFileSaver::ProtobufFileSaver(QString filename, QString filePrefix, QObje
     m_mutex(QMutex::Recursive)
 { }
 
+ProtobufFileSaver::~ProtobufFileSaver()
+{
+    close();
+    if (m_buffers) {
+        std::string *buffer;
+        while (m_buffers->pop(buffer)) {
+            delete buffer;
+        }
+    }
+}
+
+void ProtobufFileSaver::enableAsync()
+{
+    enableAsync(AsyncOptions());
+}
+
+void ProtobufFileSaver::enableAsync(const AsyncOptions &options)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_file.isOpen()) {
+        qDebug() << "Asynchronous mode must be enabled before saving messages";
+        return;
+    }
+    m_options = options;
+    m_queue.reset(new BoundedQueue<std::string*>(options.queueCapacity));
+    m_buffers.reset(new BoundedQueue<std::string*>(options.queueCapacity));
+    m_async = true;
+}
+
 void ProtobufFileSaver::open()
 {
     if (m_file.isOpen()) {
@@ -46,18 +92,204 @@ void ProtobufFileSaver::open()
 
     m_stream << QString(m_filePrefix);
     m_stream << (int) 0; // file version
+
+    if (m_async) {
+        // the writer thread owns the file from now on
+        m_file.flush();
+        m_nextOffset = m_file.pos();
+        m_writer = std::thread(&ProtobufFileSaver::runWriter, this);
+    }
 }
 
-void ProtobufFileSaver::saveMessage(const google::protobuf::Message &message)
+void ProtobufFileSaver::close()
+{
+    {
+        // taken by synchronous saves as well, none of them can write after this
+        QMutexLocker locker(&m_mutex);
+        m_closed.store(true);
+    }
+    // asynchronous saves which passed the check before must be queued before the writer drains
+    while (m_producers.load() != 0) {
+        std::this_thread::yield();
+    }
+
+    if (m_writer.joinable()) {
+        m_stopWriter.store(true, std::memory_order_release);
+        m_wakeup.notify_one();
+        m_writer.join();
+        m_stopWriter.store(false, std::memory_order_relaxed);
+    }
+
+    QMutexLocker locker(&m_mutex);
+    if (m_file.isOpen() && m_options.fsync != FsyncPolicy::Never) {
+        sync();
+    }
+    m_file.close();
+    m_opened.store(false, std::memory_order_release);
+}
+
+void ProtobufFileSaver::sync()
+{
+    m_file.flush();
+#if defined(Q_OS_UNIX)
+    ::fsync(m_file.handle());
+#elif defined(Q_OS_WIN)
+    ::_commit(m_file.handle());
+#endif
+}
+
+qint64 ProtobufFileSaver::saveMessage(const google::protobuf::Message &message)
 {   
+    if (m_async) {
+        return enqueue(message);
+    }
+
     QByteArray data;
     data.resize(message.ByteSize());
     if (!message.IsInitialized() || !message.SerializeToArray(data.data(), data.size())) {
-        return;
+        return -1;
     }
 
     QMutexLocker locker(&m_mutex);
+    if (m_closed.load()) {
+        return -1;
+    }
     open();
+    if (!m_file.isOpen()) {
+        return -1;
+    }
 
+    const qint64 offset = m_file.pos();
     m_stream << data;
+    if (m_options.fsync == FsyncPolicy::EveryWrite) {
+        sync();
+    }
+    return offset;
+}
+
+qint64 ProtobufFileSaver::enqueue(const google::protobuf::Message &message)
+{
+    if (!message.IsInitialized()) {
+        return -1;
+    }
+    // close() sets the flag before it waits for the count, so either the flag is seen here
+    // or close() waits until this message is queued
+    ProducerGuard guard(m_producers);
+    if (m_closed.load()) {
+        return -1;
+    }
+    if (!m_opened.load(std::memory_order_acquire)) {
+        QMutexLocker locker(&m_mutex);
+        open();
+        if (!m_file.isOpen()) {
+            return -1;
+        }
+        m_opened.store(true, std::memory_order_release);
+    }
+
+    std::string *buffer = nullptr;
+    if (!m_buffers->pop(buffer)) {
+        buffer = new std::string;
+    }
+    // same layout as QDataStream uses for a QByteArray: big endian length, then the data
+    const int size = int(message.ByteSizeLong());
+    buffer->resize(sizeof(quint32) + size);
+    char *data = &(*buffer)[0];
+    qToBigEndian<quint32>(size, data);
+    if (!message.SerializeToArray(data + sizeof(quint32), size)) {
+        recycle(buffer);
+        return -1;
+    }
+
+    std::size_t position;
+    bool blocked = false;
+    while (!m_queue->push(buffer, &position)) {
+        if (m_options.queueFull == QueueFullPolicy::Drop) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            recycle(buffer);
+            return -1;
+        }
+        if (!blocked) {
+            m_blocked.fetch_add(1, std::memory_order_relaxed);
+            blocked = true;
+        }
+        wakeWriter();
+        std::this_thread::yield();
+    }
+    // the buffer may already be written and recycled at this point, don't touch it
+
+    // offsets are handed out in queue order, which is also the order in the file
+    while (m_offsetTicket.load(std::memory_order_acquire) != position) {
+        std::this_thread::yield();
+    }
+    const qint64 offset = m_nextOffset;
+    m_nextOffset += sizeof(quint32) + size;
+    m_offsetTicket.store(position + 1, std::memory_order_release);
+
+    wakeWriter();
+    return offset;
+}
+
+void ProtobufFileSaver::recycle(std::string *buffer)
+{
+    if (!m_buffers->push(buffer)) {
+        delete buffer;
+    }
+}
+
+void ProtobufFileSaver::wakeWriter()
+{
+    if (m_writerIdle.load(std::memory_order_relaxed)) {
+        m_wakeup.notify_one();
+    }
+}
+
+void ProtobufFileSaver::runWriter()
+{
+    std::string data;
+    data.reserve(m_options.maxWriteSize);
+    auto lastSync = std::chrono::steady_clock::now();
+    const auto syncInterval = std::chrono::milliseconds(m_options.fsyncInterval);
+
+    for (;;) {
+        // everything pushed before close() is visible once the stop flag is
+        const bool stopping = m_stopWriter.load(std::memory_order_acquire);
+
+        std::string *buffer;
+        while (data.size() < std::size_t(m_options.maxWriteSize) && m_queue->pop(buffer)) {
+            data.append(*buffer);
+            recycle(buffer);
+        }
+
+        if (!data.empty()) {
+            writeCoalesced(data);
+            const auto now = std::chrono::steady_clock::now();
+            if (m_options.fsync == FsyncPolicy::Periodic && now - lastSync >= syncInterval) {
+                sync();
+                lastSync = now;
+            }
+            continue;
+        }
+        if (stopping) {
+            break;
+        }
+
+        std::unique_lock<std::mutex> lock(m_wakeupMutex);
+        m_writerIdle.store(true, std::memory_order_relaxed);
+        // producers only notify an idle writer, the timeout covers a missed wakeup
+        m_wakeup.wait_for(lock, std::chrono::milliseconds(5));
+        m_writerIdle.store(false, std::memory_order_relaxed);
+    }
+}
+
+void ProtobufFileSaver::writeCoalesced(std::string &data)
+{
+    if (m_file.write(data.data(), data.size()) != qint64(data.size())) {
+        qDebug() << "Could not write to" << m_filename;
+    }
+    m_file.flush();
+    if (m_options.fsync == FsyncPolicy::EveryWrite) {
+        sync();
+    }
+    data.clear();
 }
@@ -0,0 +1,169 @@
+/***************************************************************************
+ *   Copyright 2026 Kuruk contributors                                     *
+ *                                                                         *
+ *   This program is free software: you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation, either version 3 of the License, or     *
+ *   any later version.                                                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#include "simulationrecorder.h"
+#include "timer.h"
+
+#include <QDebug>
+#include <QUuid>
+#include <algorithm>
+#include <array>
+
+const QString SimulationRecorder::FILE_PREFIX = QStringLiteral("KURUK SIMULATION RECORDING");
+
+static std::array<quint32, 256> createCrcTable()
+{
+    std::array<quint32, 256> table;
+    for (quint32 i = 0; i < 256; i++) {
+        quint32 c = i;
+        for (int k = 0; k < 8; k++) {
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+        table[i] = c;
+    }
+    return table;
+}
+
+quint32 SimulationRecorder::checksum(const std::string &data)
+{
+    static const std::array<quint32, 256> table = createCrcTable();
+    quint32 crc = 0xFFFFFFFFu;
+    for (unsigned char c : data) {
+        crc = table[(crc ^ c) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+SimulationRecorder::SimulationRecorder(QString filename, const Timer *timer, QObject *parent) :
+    QObject(parent),
+    m_saver(filename, FILE_PREFIX),
+    m_timer(timer),
+    m_maxChunkDuration(1000 * 1000 * 1000LL), // 1 second
+    m_maxChunkBytes(256 * 1024)
+{
+    auto *frames = m_index.mutable_frames();
+    frames->set_base_hash(QUuid::createUuid().toString(QUuid::WithoutBraces).toStdString());
+    frames->set_base_frame_number(0);
+
+    // keep disk latency away from the simulator thread
+    m_saver.enableAsync();
+}
+
+SimulationRecorder::~SimulationRecorder()
+{
+    close();
+}
+
+void SimulationRecorder::setChunkLimits(qint64 duration, int bytes)
+{
+    m_maxChunkDuration = duration;
+    m_maxChunkBytes = bytes;
+}
+
+void SimulationRecorder::recordVisionPacket(const QByteArray &data, qint64 time, QString)
+{
+    addRecord(recording::VISION, time, data.data(), data.size());
+}
+
+void SimulationRecorder::recordSimulatorState(const QByteArray &data)
+{
+    addRecord(recording::SIMULATOR_STATE, m_timer->currentTime(), data.data(), data.size());
+}
+
+void SimulationRecorder::recordRadioCommands(const SSLSimRobotControl &control, bool isBlue, qint64 processingStart)
+{
+    const std::string data = control->SerializeAsString();
+    addRecord(isBlue ? recording::RADIO_BLUE : recording::RADIO_YELLOW, processingStart, data.data(), data.size());
+}
+
+void SimulationRecorder::addRecord(recording::RecordType type, qint64 time, const char *data, int size)
+{
+    if (m_closed) {
+        return;
+    }
+
+    if (m_batch.records_size() == 0) {
+        m_chunkStart = time;
+        m_chunkEnd = time;
+        m_chunkFirstFrame = m_frameNumber;
+    }
+    m_chunkStart = std::min(m_chunkStart, time);
+    m_chunkEnd = std::max(m_chunkEnd, time);
+
+    recording::Record *record = m_batch.add_records();
+    record->set_type(type);
+    record->set_time(time);
+    record->set_data(data, size);
+    m_batchBytes += size;
+    m_frameNumber++;
+
+    if (m_batchBytes >= m_maxChunkBytes || m_chunkEnd - m_chunkStart >= m_maxChunkDuration) {
+        flushChunk();
+    }
+}
+
+void SimulationRecorder::flushChunk()
+{
+    if (m_batch.records_size() == 0) {
+        return;
+    }
+
+    recording::Entry entry;
+    recording::Chunk *chunk = entry.mutable_chunk();
+    chunk->set_start_time(m_chunkStart);
+    chunk->set_end_time(m_chunkEnd);
+    chunk->set_first_frame_number(m_chunkFirstFrame);
+    chunk->set_record_count(m_batch.records_size());
+    m_batch.SerializeToString(chunk->mutable_payload());
+    chunk->set_checksum(checksum(chunk->payload()));
+
+    const qint64 offset = m_saver.saveMessage(entry);
+    if (offset < 0) {
+        qDebug() << "Could not write recording chunk";
+    } else {
+        recording::ChunkIndexEntry *indexEntry = m_index.add_chunks();
+        indexEntry->set_start_time(m_chunkStart);
+        indexEntry->set_end_time(m_chunkEnd);
+        indexEntry->set_offset(offset);
+
+        timeline::FrameLookup *lookup = m_index.mutable_frames()->add_frame_infos();
+        lookup->mutable_uid()->set_hash(m_index.frames().base_hash());
+        lookup->set_frame_number(m_chunkFirstFrame);
+    }
+
+    m_batch.Clear();
+    m_batchBytes = 0;
+}
+
+void SimulationRecorder::close()
+{
+    if (m_closed) {
+        return;
+    }
+    flushChunk();
+    m_closed = true;
+
+    recording::Entry entry;
+    entry.mutable_index()->Swap(&m_index);
+    const qint64 indexOffset = m_saver.saveMessage(entry);
+    if (indexOffset >= 0) {
+        recording::Trailer trailer;
+        trailer.set_index_offset(indexOffset);
+        m_saver.saveMessage(trailer);
+    }
+    m_saver.close();
+}
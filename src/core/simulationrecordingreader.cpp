@@ -0,0 +1,214 @@
+/***************************************************************************
+ *   Copyright 2026 Kuruk contributors                                     *
+ *                                                                         *
+ *   This program is free software: you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation, either version 3 of the License, or     *
+ *   any later version.                                                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#include "simulationrecordingreader.h"
+#include "simulationrecorder.h"
+
+#include <algorithm>
+
+// QDataStream length prefix followed by the fixed size serialized recording::Trailer
+static const int TRAILER_RECORD_SIZE = 4 + 9;
+
+SimulationRecordingReader::SimulationRecordingReader() :
+    m_stream(&m_file)
+{ }
+
+bool SimulationRecordingReader::open(QString filename)
+{
+    // forget the previously opened recording, also if this one fails to open
+    m_file.close();
+    m_stream.resetStatus();
+    m_index.Clear();
+    m_hasStoredIndex = false;
+    m_sorted = false;
+    m_batch.Clear();
+    m_chunk = -1;
+    m_record = 0;
+
+    m_file.setFileName(filename);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    // ensure compatibility across qt versions
+    m_stream.setVersion(QDataStream::Qt_4_6);
+
+    QString fileType;
+    int version;
+    m_stream >> fileType >> version;
+    if (fileType != SimulationRecorder::FILE_PREFIX || version != 0) {
+        return false;
+    }
+
+    const qint64 dataStart = m_file.pos();
+    // the recorder writes chunks in order, an unsorted stored index is corrupt
+    m_hasStoredIndex = readStoredIndex() && isSorted();
+    if (!m_hasStoredIndex) {
+        rebuildIndex(dataStart);
+    }
+    // a rebuilt index keeps the file order, which is unsorted if the clock jumped while recording
+    m_sorted = isSorted();
+
+    // skip corrupted chunks at the start
+    for (int chunk = 0; chunk < m_index.chunks_size(); chunk++) {
+        if (loadChunk(chunk)) {
+            return true;
+        }
+    }
+    m_chunk = -1;
+    return false;
+}
+
+bool SimulationRecordingReader::readEntry(qint64 offset, recording::Entry &entry)
+{
+    if (!m_file.seek(offset)) {
+        return false;
+    }
+    m_stream.resetStatus();
+    QByteArray data;
+    m_stream >> data;
+    return m_stream.status() == QDataStream::Ok && entry.ParseFromArray(data.data(), data.size());
+}
+
+bool SimulationRecordingReader::readStoredIndex()
+{
+    if (m_file.size() < TRAILER_RECORD_SIZE || !m_file.seek(m_file.size() - TRAILER_RECORD_SIZE)) {
+        return false;
+    }
+    m_stream.resetStatus();
+    QByteArray data;
+    m_stream >> data;
+    recording::Trailer trailer;
+    if (m_stream.status() != QDataStream::Ok || !trailer.ParseFromArray(data.data(), data.size())) {
+        return false;
+    }
+
+    recording::Entry entry;
+    if (!readEntry(trailer.index_offset(), entry) || !entry.has_index()) {
+        return false;
+    }
+    m_index.Swap(entry.mutable_index());
+    return true;
+}
+
+void SimulationRecordingReader::rebuildIndex(qint64 dataStart)
+{
+    m_index.Clear();
+    m_index.mutable_frames()->set_base_hash("");
+    m_index.mutable_frames()->set_base_frame_number(0);
+
+    if (!m_file.seek(dataStart)) {
+        return;
+    }
+    m_stream.resetStatus();
+    recording::Entry entry;
+    while (!m_stream.atEnd()) {
+        const qint64 offset = m_file.pos();
+        QByteArray data;
+        m_stream >> data;
+        // a truncated last record ends the usable part of the file
+        if (m_stream.status() != QDataStream::Ok || !entry.ParseFromArray(data.data(), data.size())) {
+            break;
+        }
+        if (!entry.has_chunk()) {
+            continue;
+        }
+        const recording::Chunk &chunk = entry.chunk();
+        recording::ChunkIndexEntry *indexEntry = m_index.add_chunks();
+        indexEntry->set_start_time(chunk.start_time());
+        indexEntry->set_end_time(chunk.end_time());
+        indexEntry->set_offset(offset);
+        timeline::FrameLookup *lookup = m_index.mutable_frames()->add_frame_infos();
+        lookup->mutable_uid()->set_hash("");
+        lookup->set_frame_number(chunk.first_frame_number());
+    }
+}
+
+bool SimulationRecordingReader::isSorted() const
+{
+    const auto &chunks = m_index.chunks();
+    return std::is_sorted(chunks.begin(), chunks.end(), [](const recording::ChunkIndexEntry &a, const recording::ChunkIndexEntry &b) {
+        return a.end_time() < b.end_time();
+    });
+}
+
+bool SimulationRecordingReader::loadChunk(int chunk)
+{
+    m_batch.Clear();
+    m_chunk = chunk;
+    m_record = 0;
+
+    recording::Entry entry;
+    if (!readEntry(m_index.chunks(chunk).offset(), entry) || !entry.has_chunk()) {
+        return false;
+    }
+    const recording::Chunk &c = entry.chunk();
+    if (SimulationRecorder::checksum(c.payload()) != c.checksum()) {
+        return false;
+    }
+    return m_batch.ParseFromString(c.payload());
+}
+
+qint64 SimulationRecordingReader::startTime() const
+{
+    return m_index.chunks_size() > 0 ? m_index.chunks(0).start_time() : 0;
+}
+
+qint64 SimulationRecordingReader::endTime() const
+{
+    return m_index.chunks_size() > 0 ? m_index.chunks(m_index.chunks_size() - 1).end_time() : 0;
+}
+
+bool SimulationRecordingReader::seek(qint64 time)
+{
+    const auto &chunks = m_index.chunks();
+    int first = 0;
+    if (m_sorted) {
+        first = std::partition_point(chunks.begin(), chunks.end(), [time](const recording::ChunkIndexEntry &c) {
+            return c.end_time() < time;
+        }) - chunks.begin();
+    }
+    // without a sorted index this is a linear scan over the chunk time ranges
+    for (int chunk = first; chunk < chunks.size(); chunk++) {
+        if (chunks.Get(chunk).end_time() < time || !loadChunk(chunk)) {
+            continue;
+        }
+        while (m_record < m_batch.records_size()) {
+            if (m_batch.records(m_record).time() >= time) {
+                return true;
+            }
+            m_record++;
+        }
+    }
+    return false;
+}
+
+bool SimulationRecordingReader::readNext(recording::Record &record)
+{
+    while (m_chunk >= 0 && m_record >= m_batch.records_size()) {
+        if (m_chunk + 1 >= m_index.chunks_size()) {
+            return false;
+        }
+        // skip corrupted chunks
+        loadChunk(m_chunk + 1);
+    }
+    if (m_chunk < 0) {
+        return false;
+    }
+    record.CopyFrom(m_batch.records(m_record++));
+    return true;
+}
@@ -0,0 +1,65 @@
+/***************************************************************************
+ *   Copyright 2026 Kuruk contributors                                     *
+ *                                                                         *
+ *   This program is free software: you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation, either version 3 of the License, or     *
+ *   any later version.                                                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#include "worldsnapshot.h"
+#include "protobuf/ssl_wrapper.pb.h"
+#include <algorithm>
+
+WorldSnapshotPtr WorldSnapshotBuilder::addPacket(const char *data, int size, qint64 receiveTime)
+{
+    auto packet = std::make_shared<SSL_WrapperPacket>();
+    if (!packet->ParseFromArray(data, size)) {
+        return nullptr;
+    }
+
+    auto snapshot = std::make_shared<WorldSnapshot>();
+    snapshot->sequence = ++m_sequence;
+    snapshot->receiveTime = receiveTime;
+    if (m_snapshot) {
+        snapshot->geometry = m_snapshot->geometry;
+        // cameras that went silent would otherwise show their last frame forever
+        for (const WorldSnapshot::Camera &camera : m_snapshot->cameras) {
+            if (receiveTime - camera.receiveTime <= m_cameraTimeout) {
+                snapshot->cameras.push_back(camera);
+            }
+        }
+    }
+
+    // the messages keep the packet alive, nothing is copied
+    if (packet->has_geometry()) {
+        snapshot->geometry = std::shared_ptr<const SSL_GeometryData>(packet, &packet->geometry());
+    }
+    if (packet->has_detection()) {
+        const WorldSnapshot::Camera camera{std::shared_ptr<const SSL_DetectionFrame>(packet, &packet->detection()), receiveTime};
+        const quint32 id = camera.frame->camera_id();
+        auto it = std::lower_bound(snapshot->cameras.begin(), snapshot->cameras.end(), id,
+                                   [](const WorldSnapshot::Camera &c, quint32 id) { return c.frame->camera_id() < id; });
+        if (it != snapshot->cameras.end() && it->frame->camera_id() == id) {
+            *it = camera;
+        } else {
+            snapshot->cameras.insert(it, camera);
+        }
+    }
+
+    m_snapshot = snapshot;
+    return m_snapshot;
+}
+
+void WorldSnapshotBuilder::clear()
+{
+    m_snapshot.reset();
+}
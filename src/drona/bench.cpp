@@ -0,0 +1,107 @@
+#include "drona/fieldevaluator.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <vector>
+
+/**
+ * Offline benchmark of the FieldEvaluator which scores the hotmap
+ *
+ * Evaluates a grid the size of the hotmap on a full size field with random opponents
+ * and reports the cost of a full update, of an update where two opponents moved
+ * and of an update where nothing changed.
+ */
+
+// same cells as the hotmap of Kshetra, 10 cm on a 12 m x 9 m field
+static const int COLUMNS = 121;
+static const int ROWS = 91;
+static const float CELL = 100;
+static const float HALF_LENGTH = 6000;
+static const float HALF_WIDTH = 4500;
+static const float GOAL_WIDTH = 1000;
+// far enough that every opponent leaves the move tolerance
+static const float STEP = 300;
+
+// mean time per call in milliseconds
+static double measure(int iterations, const std::function<void(int)> &update)
+{
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        update(i);
+    }
+    const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / iterations;
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("Field evaluator benchmark");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Measures the cost of scoring the hotmap cells");
+    parser.addHelpOption();
+
+    QCommandLineOption threadsConfig("threads", "Threads per update, 0 chooses from the number of cores", "count", "0");
+    QCommandLineOption opponentsConfig("opponents", "Number of opponents", "count", "11");
+    QCommandLineOption iterationsConfig("iterations", "Updates per measurement", "count", "500");
+    QCommandLineOption seedConfig("seed", "Seed of the opponent positions", "seed", "1");
+    parser.addOption(threadsConfig);
+    parser.addOption(opponentsConfig);
+    parser.addOption(iterationsConfig);
+    parser.addOption(seedConfig);
+
+    parser.process(app);
+
+    const int threads = parser.value(threadsConfig).toInt();
+    const int iterations = std::max(1, parser.value(iterationsConfig).toInt());
+
+    FieldEvaluator evaluator(threads);
+    evaluator.setGrid(COLUMNS, ROWS, -HALF_LENGTH, -HALF_WIDTH, CELL);
+    evaluator.setGoal(HALF_LENGTH, GOAL_WIDTH);
+
+    std::mt19937 rng(parser.value(seedConfig).toUInt());
+    std::uniform_real_distribution<float> x(-HALF_LENGTH, HALF_LENGTH);
+    std::uniform_real_distribution<float> y(-HALF_WIDTH, HALF_WIDTH);
+    std::vector<FieldEvaluator::Point> opponents(std::max(2, parser.value(opponentsConfig).toInt()));
+    for (FieldEvaluator::Point &opponent : opponents) {
+        opponent = {x(rng), y(rng)};
+    }
+    FieldEvaluator::Point ball = {0, 0};
+
+    // the first update computes every layer and starts the helper threads
+    evaluator.evaluate(opponents, &ball);
+
+    const double full = measure(iterations, [&](int i) {
+        const float step = i % 2 ? STEP : -STEP;
+        ball.x += step;
+        for (FieldEvaluator::Point &opponent : opponents) {
+            opponent.x += step;
+        }
+        evaluator.evaluate(opponents, &ball);
+    });
+    const int full_layers = evaluator.updatedLayers();
+    const double two = measure(iterations, [&](int i) {
+        const float step = i % 2 ? STEP : -STEP;
+        opponents[0].x += step;
+        opponents[1].y += step;
+        evaluator.evaluate(opponents, &ball);
+    });
+    const int two_layers = evaluator.updatedLayers();
+    const double none = measure(iterations, [&](int) {
+        evaluator.evaluate(opponents, &ball);
+    });
+
+    std::printf("%d x %d cells, %d opponents, times per update in milliseconds\n",
+                COLUMNS, ROWS, int(opponents.size()));
+    std::printf("%-24s %10s %8s\n", "update", "time", "layers");
+    std::printf("%-24s %10.3f %8d\n", "ball and all opponents", full, full_layers);
+    std::printf("%-24s %10.3f %8d\n", "two opponents", two, two_layers);
+    std::printf("%-24s %10.4f %8d\n", "nothing moved", none, 0);
+    return EXIT_SUCCESS;
+}
@@ -12,22 +12,27 @@
 
 #include "protobuf/ssl_simulation_robot_control.pb.h"
 #include <QObject>
+#include <QMetaType>
 #include <QUdpSocket>
 #include <QString>
 #include <QNetworkDatagram>
 #include <google/protobuf/repeated_field.h>
+#include <array>
+
+// TODO: Replace hardcoded TEAM_BOTS with dynamic data from the simulator
+
+/// Number of bots of one team, every packet array sent through Dhanush has this many entries
+#define TEAM_BOTS 6
 
 /**
  * @brief Represents a single robot's motion command and identity.
  *
  * This class contains data like linear/angular velocities, kick speed,
- * team color, and ID. It inherits from QObject so it can be used with
- * Qt’s signal-slot mechanism if needed in the future.
+ * team color, and ID. It is a plain value, so whole sets of commands can be
+ * copied through queued signals to the sender thread.
  */
-class BotPacket : public QObject
+class BotPacket
 {
-    Q_OBJECT
-
 public:
     ///default constructor. Initializes all values to zero.
     BotPacket()
@@ -39,9 +44,6 @@ public:
         : vel_x(0.0f), vel_y(0.0f), vel_angular(0.0f),
           kick_speed(0.0f), id(id), is_blue(is_blue) {}
 
-    ///default destructor. Safe due to QObject parenting.
-    ~BotPacket() = default;
-
     //motion control data
     float vel_x;       ///< Velocity in the x-direction (forward)
     float vel_y;       ///< Velocity in the y-direction (left)
@@ -53,6 +55,10 @@ public:
     float kick_speed;  ///< Kick strength
 };
 
+/// Commands for all bots of one team, sent as one RobotControl message
+typedef std::array<BotPacket, TEAM_BOTS> BotPackets;
+Q_DECLARE_METATYPE(BotPackets)
+
 
 /**
  * @brief Sends velocity commands to bots via UDP using protobuf.
@@ -72,9 +78,9 @@ public:
 public slots:
     /**
      * @brief Sends velocity commands using protobuf and UDP.
-     * @param packet Pointer to an array of BotPacket objects.
+     * @param packets Commands of all bots of one team, a copy owned by the sender thread.
      */
-    void send_velocity(BotPacket* packet);
+    void send_velocity(const BotPackets &packets);
 
 private:
     /**
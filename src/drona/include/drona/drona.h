@@ -14,12 +14,16 @@
 
 /// Include necessary headers for bot control, simulator components, protobuf message formats, and Qt networking/threading.
 #include "dhanush.h"
-#include "yodha/yodha.h"
-#include "yodha/mantri.h"
+#include "sanjaya/sanjaya.h"
+#include "sanjaya/predictor.h"
 #include "protobuf/ssl_wrapper.pb.h"
 #include "protobuf/ssl_geometry.pb.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
 #include <vector>
 #include <QObject>
+#include <QPointF>
 #include <QUdpSocket>
 #include <QString>
 #include <QThread>
@@ -31,8 +35,7 @@ enum Team {
     YELLOW = 1  ///< Yellow team
 };
 
-/// Forward declaration of BotPacket class
-class BotPacket;
+Q_DECLARE_METATYPE(std::vector<QPointF>)
 
 /**
  * @class Drona
@@ -40,6 +43,11 @@ class BotPacket;
  *
  * Drona coordinates the motion of bots by communicating with Dhanush.
  * It stores the game state information and determines the next actions for the bots.
+ *
+ * The decisions are made on a strategy thread of their own, at a fixed rate which does not depend on
+ * when vision frames arrive or on the GUI. Every tick takes the latest fused state and sends one set
+ * of commands. Ticks which do not finish before the next deadline are counted as overruns, the
+ * deadlines they ran into are skipped instead of being caught up.
  */
 class Drona : public QObject
 {
@@ -54,31 +62,70 @@ public:
      */
     explicit Drona(QObject *parent = 0);
 
+    /**
+     * @brief Tick statistics of the strategy thread, collected over a few seconds
+     */
+    struct TickStats {
+        int ticks = 0;          ///< number of ticks
+        int overruns = 0;       ///< ticks which ended after the deadline of the next one
+        int skipped = 0;        ///< deadlines which passed during an overrun and got no tick
+        double mean_ms = 0;     ///< mean time spent per tick
+        double max_ms = 0;      ///< longest tick
+        double max_late_ms = 0; ///< latest start of a tick after its deadline
+    };
+
     /**
      * @brief Moves the specified bot to the given position.
      * 
-     * @param id The ID of the bot to be moved.
-     * @param x The target x-coordinate.
-     * @param y The target y-coordinate.
+     * @param id The ID of the bot to be moved, nothing happens if it has no packet or is not seen.
+     * @param x The target x-coordinate, in planner coordinates.
+     * @param y The target y-coordinate, in planner coordinates.
      * @param team The team to which the bot belongs (BLUE or YELLOW).
-     * @param packet The BotPacket that holds velocity information.
+     * @param packets The BotPackets that hold velocity information.
      */
-    void moveToPosition(int id, float x, float y, int team, BotPacket *packet);
+    void moveToPosition(int id, float x, float y, int team, BotPackets &packets);
 
     /**
-     * @brief Sets the blue and yellow bot teams.
-     * 
-     * @param pandav A shared pointer to the list of blue team bots.
-     * @param kaurav A shared pointer to the list of yellow team bots.
+     * @brief Sets where the ticks take the fused world state from.
+     *
+     * @param source State slot of Sanjaya, must outlive Drona.
      */
-    void setPlayers(std::shared_ptr<std::vector<BlueBot>> pandav, std::shared_ptr<std::vector<YellowBot>> kaurav);
+    void setSource(const WorldStateSlot *source);
 
     /**
-     * @brief Sets the ball's location.
-     * 
-     * @param ball A shared pointer to the ball object.
+     * @brief Sets how often the strategy thread ticks, may be changed while it runs.
+     *
+     * @param rate Ticks per second, 100 by default. 0 runs the ticks back to back without deadlines,
+     * to measure how many decisions per second can be made.
      */
-    void setBall(std::shared_ptr<Ball> ball);
+    void setRate(double rate);
+
+    /**
+     * @brief Makes the ticks decide on commands without sending them.
+     *
+     * @param dry_run Whether to drop the commands, false by default.
+     */
+    void setDryRun(bool dry_run);
+
+    /**
+     * @brief Number of ticks which decided on a set of commands since start, may be called from any thread.
+     */
+    qint64 decisionCount() const { return decisions; }
+
+    /**
+     * @brief Starts the strategy thread, the source should be set before.
+     */
+    void start();
+
+    /**
+     * @brief Stops the strategy thread after its current tick.
+     */
+    void stop();
+
+    /**
+     * @brief Statistics of the last completed measuring window, may be called from any thread.
+     */
+    TickStats tickStats() const;
 
     /**
      * @brief Destructor for Drona class.
@@ -108,82 +155,86 @@ private:
             : x(x), y(y), is_blue(is_blue), id(id) {}
     };
 
+    /**
+     * @brief Tells the predictor which commands were just sent.
+     *
+     * @param packets Commands which were sent.
+     */
+    void recordCommands(const BotPackets &packets);
+
+    /**
+     * @brief Runs tick at every deadline until stop is called, runs on the strategy thread.
+     */
+    void run();
+
+    /**
+     * @brief Plans on the fused state predicted to the time at which the commands reach the robots
+     * and sends one set of commands.
+     */
+    void tick();
+
+    /**
+     * @brief Accumulates the timing of a tick and logs the statistics every few seconds.
+     *
+     * @param now End of the tick, ns since the strategy thread started.
+     * @param late Time between the deadline and the start of the tick, ns.
+     * @param duration Time spent in the tick, ns.
+     * @param skipped Deadlines which passed while the tick ran.
+     */
+    void recordTick(qint64 now, qint64 late, qint64 duration, int skipped);
+
     QThread sender_thread;  ///< Thread to handle Dhanush communication.
     Dhanush *sender;  ///< Pointer to Dhanush instance for sending bot control data.
-    BotPacket *m_packet; ///< Bot packet containing velocity information.
+    // written by the strategy thread only, send hands a copy to the sender thread
+    BotPackets m_packet; ///< Bot packet containing velocity information.
 
 #if defined SIMULATOR_MODE
-    BotPacket *m_blue_packet;  ///< Blue team packet (used only in simulator mode).
-    BotPacket *m_yellow_packet;  ///< Yellow team packet (used only in simulator mode).
+    BotPackets m_blue_packet;  ///< Blue team packet (used only in simulator mode).
+    BotPackets m_yellow_packet;  ///< Yellow team packet (used only in simulator mode).
 #endif
 
-    std::shared_ptr<std::vector<BlueBot>> pandav;  ///< Shared pointer to the list of blue team bots.
-    std::shared_ptr<std::vector<YellowBot>> kaurav; ///< Shared pointer to the list of yellow team bots.
-    std::shared_ptr<Ball> ball; ///< Shared pointer to the ball object.
+    const WorldStateSlot *source = nullptr; ///< Fused world state of Sanjaya.
+    Predictor predictor; ///< Predicts the state at which the next commands take effect.
+    world::State predicted; ///< Predicted state the current decisions are based on, reused for every frame.
     std::vector<QPointF> vertices;  ///< A list of vertices representing the formation or paths of bots.
+    int plan_counter = 0; ///< Ticks since the path was last planned.
 
     bool has_state_; ///< Flag indicating if the game state has been initialized.
 
+    std::thread strategy_thread; ///< Thread which runs the ticks.
+    std::atomic<bool> running{false}; ///< Cleared to stop the strategy thread.
+    std::atomic<qint64> tick_period; ///< Time between two deadlines, ns, 0 to tick back to back.
+    std::atomic<bool> dry_run{false}; ///< Set to decide without sending.
+    std::atomic<qint64> decisions{0}; ///< Ticks which decided on a set of commands.
+
+    // current measuring window of the statistics, only used by the strategy thread
+    int window_ticks = 0;
+    int window_overruns = 0;
+    int window_skipped = 0;
+    qint64 window_start = 0;
+    qint64 window_total = 0;
+    qint64 window_max = 0;
+    qint64 window_max_late = 0;
+    mutable std::mutex stats_mutex; ///< Guards tick_stats.
+    TickStats tick_stats;
+
 signals:
     /**
      * @brief Signal to send velocity command to bots.
      * 
-     * @param packet The BotPacket containing velocity data.
+     * Emitted on the strategy thread, the queued connection copies the packets, so the
+     * next tick can rewrite them while Dhanush sends.
+     *
+     * @param packets The BotPackets containing velocity data.
      */
-    void send(BotPacket* packet);
+    void send(const BotPackets &packets);
 
     /**
-     * @brief Signal to draw the current formation or state on the UI.
+     * @brief Signal to draw the current formation or state on the UI, emitted on the strategy thread after each planning.
      * 
      * @param vertices A list of points representing the formation.
      */
-    void draw_graph(std::vector<QPointF> *vertices);
-
-public slots:
-    /**
-     * @brief Slot to handle game state data.
-     * 
-     * @param buffer A pointer to a QByteArray containing the state data.
-     */
-    void handleState(QByteArray *buffer);
-};
-
-/**
- * @class HotMap
- * @brief Visualizes the formations involving all bots and the ball based on the current state.
- *
- * HotMap stores all relevant shared pointers (bots, ball, etc.) and provides functionality to reset the visual map.
- */
-class HotMap
-{
-public:
-    std::shared_ptr<std::vector<BlueBot>> scene_pandav;  ///< Blue team bots for the scene.
-    std::shared_ptr<std::vector<YellowBot>> scene_kaurav; ///< Yellow team bots for the scene.
-    std::shared_ptr<Ball> scene_ball; ///< The ball in the scene.
-    std::shared_ptr<std::vector<Mantri>> scene_mantri; ///< The Mantri (strategists) in the scene.
-    SSL_WrapperPacket state; ///< The current state of the game.
-
-    /**
-     * @brief HotMap constructor initializes all scene elements and the state.
-     * 
-     * @param scene_pandav Shared pointer to blue team bots.
-     * @param scene_kaurav Shared pointer to yellow team bots.
-     * @param scene_ball Shared pointer to the ball.
-     * @param scene_mantri Shared pointer to the strategists (Mantri).
-     * @param state The current game state.
-     */
-    HotMap(std::shared_ptr<std::vector<BlueBot>> scene_pandav,
-           std::shared_ptr<std::vector<YellowBot>> scene_kaurav,
-           std::shared_ptr<Ball> scene_ball,
-           std::shared_ptr<std::vector<Mantri>> scene_mantri,
-           SSL_WrapperPacket state)
-        : scene_pandav(scene_pandav), scene_kaurav(scene_kaurav),
-          scene_ball(scene_ball), scene_mantri(scene_mantri), state(state) {}
-
-    /**
-     * @brief Resets the HotMap to a new state.
-     */
-    void setHotMap();
+    void draw_graph(const std::vector<QPointF> &vertices);
 };
 
 #endif // DRONA_H
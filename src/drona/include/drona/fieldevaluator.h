@@ -0,0 +1,149 @@
+#ifndef FIELDEVALUATOR_H
+#define FIELDEVALUATOR_H
+/**
+ * @file fieldevaluator.h
+ * @brief Defines the engine which scores the cells of the field for the HotMap
+ */
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @class FieldEvaluator
+ * @brief Scores every cell of a grid over the field from the view of the yellow team
+ *
+ * The score of a cell lies in [-1, 1] and is combined from three terms:
+ *  - pass: how well a pass from the ball is received there. The lane from the ball must not run
+ *    close to an opponent and long passes are worth less.
+ *  - shot: the angle under which the opponent goal is seen from the cell.
+ *  - pressure: how close the opponents are, subtracted from the other two.
+ *
+ * The terms are kept in separate layers, one pressure and one lane layer per opponent. evaluate only
+ * recomputes the layers of opponents which moved, and the lane layers if the ball moved, then combines
+ * all layers. Rows are computed as Eigen arrays, which are evaluated with SIMD instructions,
+ * and large updates are split into tiles of rows which are handled by several threads. The helper
+ * threads are started with the first large update and wait for the next one, they live as long as the evaluator.
+ *
+ * All positions are in vision coordinates, in mm.
+ */
+class FieldEvaluator {
+public:
+    struct Point {
+        float x, y;
+    };
+
+    /// Weights of the terms in the score
+    struct Weights {
+        float pass = 0.6f;
+        float shot = 0.6f;
+        float pressure = 1.0f;
+    };
+
+    /**
+     * @brief Creates an evaluator without grid
+     * @param threads Maximal number of threads per update, 0 chooses from the number of cores
+     */
+    explicit FieldEvaluator(int threads = 0);
+    /// Stops the helper threads
+    ~FieldEvaluator();
+    FieldEvaluator(const FieldEvaluator&) = delete;
+    FieldEvaluator& operator=(const FieldEvaluator&) = delete;
+
+    /**
+     * @brief Sets the cells to evaluate, does nothing if they are unchanged
+     * @param columns Number of cells along x
+     * @param rows Number of cells along y
+     * @param origin_x x of the center of the first cell
+     * @param origin_y y of the center of the first cell
+     * @param cell Distance between the centers of two cells
+     */
+    void setGrid(int columns, int rows, float origin_x, float origin_y, float cell);
+    /**
+     * @brief Sets the goal the yellow team attacks, does nothing if it is unchanged
+     * @param x Position of the goal line
+     * @param width Distance between the posts
+     */
+    void setGoal(float x, float width);
+    void setWeights(const Weights &weights);
+
+    /**
+     * @brief Updates the scores to the given positions
+     *
+     * Opponents are matched to those of the last call by their index, so they must be passed in the same order.
+     * Positions which differ less than a tenth of a cell from the last evaluated ones are treated as unchanged.
+     *
+     * @param opponents Positions of the blue robots
+     * @param ball Position of the ball, nullptr if it is not seen
+     */
+    void evaluate(const std::vector<Point> &opponents, const Point *ball);
+
+    int columns() const { return columns_; }
+    int rows() const { return rows_; }
+    /// Scores of all cells, row by row
+    const float *values() const { return score.data(); }
+    const float *pass() const { return pass_.data(); }
+    const float *shot() const { return shot_.data(); }
+    const float *pressure() const { return pressure_.data(); }
+    /// Number of layers recomputed by the last evaluate, 0 if nothing changed
+    int updatedLayers() const { return updated_layers; }
+
+private:
+    // pressure and lane layer of one opponent
+    struct Opponent {
+        Point position;
+        std::vector<float> pressure;
+        std::vector<float> lane;
+        bool moved;
+    };
+
+    void invalidate();
+    bool hasMoved(const Point &from, const Point &to) const;
+    /**
+     * @brief Runs function on tiles of rows, in parallel if work is large enough
+     * @param work Number of cells which are computed
+     * @param function Called with the first and the past the end row of each tile
+     */
+    void forEachTile(long work, const std::function<void(int, int)> &function);
+    /// Calls the function of the current job on tiles until none are left
+    void visitTiles(const std::function<void(int, int)> &function);
+    /// Loop of a helper thread, index is its position in helpers, it runs the jobs after generation
+    void runHelper(int index, unsigned generation);
+    void updateRows(int from, int to, bool shot_dirty, bool ball_dirty);
+
+    int threads;
+    int columns_ = 0, rows_ = 0;
+    float origin_x = 0, origin_y = 0, cell = 0;
+    float goal_x = 0, goal_width = 0;
+    Weights weights;
+
+    std::vector<float> xs; // x of the cell centers of a row
+    std::vector<Opponent> opponents;
+    Point ball_position;
+    bool has_ball = false;
+    bool valid = false; // false until all layers were computed for the current grid and goal
+    int updated_layers = 0;
+
+    std::vector<float> shot_;
+    std::vector<float> reach; // falloff with the pass length
+    std::vector<float> pass_;
+    std::vector<float> pressure_;
+    std::vector<float> score;
+
+    // helper threads of forEachTile, a job is published by incrementing job_generation
+    std::vector<std::thread> helpers;
+    std::mutex job_mutex;
+    std::condition_variable job_started;
+    std::condition_variable job_finished;
+    const std::function<void(int, int)> *job = nullptr;
+    unsigned job_generation = 0;
+    int job_helpers = 0;     // helpers which take part in the current job, the others skip it
+    int busy_helpers = 0;    // helpers still working on the current job
+    bool stopping = false;
+    int job_tiles = 0;
+    std::atomic<int> next_tile{0};
+};
+
+#endif // FIELDEVALUATOR_H
@@ -4,11 +4,6 @@
 /// Macro for logging with a consistent tag
 #define LOG qDebug() << "[dhanush] : "
 
-// TODO: Replace hardcoded TOTAL_BOTS with dynamic data from the simulator
-
-/// Defines the total number of bots in the simulation
-#define TOTAL_BOTS 10
-
 using namespace sslsim;
 
 /// Constructor for the Dhanush class
@@ -37,18 +32,19 @@ Dhanush::~Dhanush() {
  * After construction, the message is serialized and sent to the appropriate simulator port
  * using a QUdpSocket.
  *
- * @param packet Pointer to an array of BotPacket objects, containing velocity and kick data for each bot.
+ * @param packets Velocity and kick data for each bot of one team.
  *
  * @see https://protobuf.dev/getting-started/cpptutorial/
  * @see ssl_simulation_robot_control.proto
  */
-void Dhanush::send_velocity(BotPacket* packet)
+void Dhanush::send_velocity(const BotPackets &packets)
 {
+    const BotPacket *packet = packets.data();
     // Create a RobotControl message that will contain commands for multiple bots
     RobotControl robot_control;
 
-    //loops through half of the bots i.e one team
-    for (int i = 0; i < TOTAL_BOTS / 2; ++i) {
+    //loops through the bots of one team
+    for (int i = 0; i < TEAM_BOTS; ++i) {
         //adds a new RobotCommand to the robot_control message
         command = robot_control.add_robot_commands();
 
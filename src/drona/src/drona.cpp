@@ -1,13 +1,19 @@
 #include "drona.h"
 #include "planner.h"
+#include "core/coordinates.h"
+#include "core/timer.h"
 #include <QString>
+#include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <QtMath>
 #include <QNetworkDatagram>
 
 #define LOG qDebug() << "[drona] :" ///< Debug macro for logging messages
-#define BLUE_BOTS 6                 ///< Total number of blue bots
-#define YELLOW_BOTS 6               ///< Total number of yellow bots
+#define BLUE_BOTS TEAM_BOTS         ///< Total number of blue bots, the packets Dhanush sends per team
+#define YELLOW_BOTS TEAM_BOTS       ///< Total number of yellow bots, the packets Dhanush sends per team
+#define STATS_WINDOW 5000000000LL   ///< Tick statistics are logged every 5 s
+#define PLAN_INTERVAL 100           ///< Ticks between two plannings of the path
 
 // Test stuff (remove this if you want)
 
@@ -17,69 +23,206 @@ using namespace sslsim;
  * @brief Constructor for the Drona class.
  *
  * Initializes the velocity sender (Dhanush), assigns it to a separate thread,
- * and sets up BotPacket memory for controlling the bots.
+ * and registers the types which are queued to other threads.
  *
  * @param parent Parent QObject
  */
 Drona::Drona(QObject* parent)
     : QObject(parent), sender(new Dhanush()) {
 
+    // draw_graph is emitted on the strategy thread and queued to the GUI
+    qRegisterMetaType<std::vector<QPointF>>();
+    // the commands are copied to the sender thread
+    qRegisterMetaType<BotPackets>();
+    setRate(100);
+
     sender->moveToThread(&sender_thread);
     connect(this, &Drona::send, sender, &Dhanush::send_velocity);
     sender_thread.setObjectName("sender");
     sender_thread.start();
 
-    m_packet = new BotPacket[BLUE_BOTS];
+}
 
-#if defined(SIMULATOR_MODE)
-    m_blue_packet = new BotPacket[BLUE_BOTS];
-    m_yellow_packet = new BotPacket[YELLOW_BOTS];
-#endif
+/**
+ * @brief Sets the fused world state to plan on.
+ *
+ * @param source State slot of Sanjaya
+ */
+void Drona::setSource(const WorldStateSlot* source) {
+    this->source = source;
+}
+
+/**
+ * @brief Sets how often the strategy thread ticks.
+ *
+ * @param rate Ticks per second, 0 to tick back to back
+ */
+void Drona::setRate(double rate) {
+    tick_period = rate <= 0 ? 0 : qint64(1E9 / std::max(rate, 1.0));
+}
+
+/**
+ * @brief Makes the ticks decide on commands without sending them.
+ *
+ * @param dry_run Whether to drop the commands
+ */
+void Drona::setDryRun(bool dry_run) {
+    this->dry_run = dry_run;
+}
+
+/**
+ * @brief Starts the strategy thread, does nothing if it already runs.
+ */
+void Drona::start() {
+    if (running.exchange(true)) return;
+    strategy_thread = std::thread(&Drona::run, this);
+}
+
+/**
+ * @brief Stops the strategy thread and waits for its current tick to finish.
+ */
+void Drona::stop() {
+    running = false;
+    if (strategy_thread.joinable()) strategy_thread.join();
+}
+
+Drona::TickStats Drona::tickStats() const {
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    return tick_stats;
+}
+
+/**
+ * @brief Fixed rate loop of the strategy thread.
+ *
+ * The deadlines lie on a fixed grid of tick_period, so the rate does not drift with the
+ * duration of the ticks. A tick which ends after the next deadline is an overrun, the
+ * next tick then starts at the first deadline which is still ahead.
+ * Without a period the ticks run back to back and are never late.
+ */
+void Drona::run() {
+    using Clock = std::chrono::steady_clock;
+    const Clock::time_point epoch = Clock::now();
+    auto elapsed = [&epoch]() {
+        return qint64(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - epoch).count());
+    };
+
+    window_start = 0;
+    qint64 deadline = tick_period;
+    while (running) {
+        if (tick_period > 0) {
+            std::this_thread::sleep_until(epoch + std::chrono::nanoseconds(deadline));
+            if (!running) break;
+        }
+
+        const qint64 start = elapsed();
+        tick();
+        const qint64 end = elapsed();
+
+        const qint64 period = tick_period;
+        if (period <= 0) {
+            recordTick(end, 0, end - start, 0);
+            deadline = end;
+            continue;
+        }
+        const qint64 due = deadline;
+        deadline += period;
+        int skipped = 0;
+        if (end > deadline) {
+            skipped = int((end - deadline) / period) + 1;
+            deadline += skipped * period;
+        }
+        recordTick(end, start - due, end - start, skipped);
+    }
 }
 
 /**
- * @brief Sets the players on both teams.
+ * @brief Accumulates the timing of a tick and logs the statistics every few seconds.
  *
- * @param pandav Shared pointer to the vector of blue bots
- * @param kaurav Shared pointer to the vector of yellow bots
+ * @param now End of the tick, ns since the strategy thread started
+ * @param late Time between the deadline and the start of the tick, ns
+ * @param duration Time spent in the tick, ns
+ * @param skipped Deadlines which passed while the tick ran
  */
-void Drona::setPlayers(std::shared_ptr<std::vector<BlueBot>> pandav,
-                       std::shared_ptr<std::vector<YellowBot>> kaurav) {
-    this->pandav = pandav;
-    this->kaurav = kaurav;
+void Drona::recordTick(qint64 now, qint64 late, qint64 duration, int skipped) {
+    window_ticks++;
+    window_total += duration;
+    window_max = std::max(window_max, duration);
+    window_max_late = std::max(window_max_late, late);
+    if (skipped > 0) {
+        // one message per window is enough to notice
+        if (window_overruns == 0) {
+            LOG << "tick took" << duration / 1E6 << "ms, skipping" << skipped << "ticks";
+        }
+        window_overruns++;
+        window_skipped += skipped;
+    }
+
+    if (now - window_start < STATS_WINDOW) return;
+    TickStats stats;
+    stats.ticks = window_ticks;
+    stats.overruns = window_overruns;
+    stats.skipped = window_skipped;
+    stats.mean_ms = window_total / 1E6 / window_ticks;
+    stats.max_ms = window_max / 1E6;
+    stats.max_late_ms = window_max_late / 1E6;
+    LOG << "ticks" << stats.ticks << "overruns" << stats.overruns << "skipped" << stats.skipped
+        << "mean" << stats.mean_ms << "ms max" << stats.max_ms << "ms late" << stats.max_late_ms << "ms";
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex);
+        tick_stats = stats;
+    }
+
+    window_start = now;
+    window_ticks = 0;
+    window_overruns = 0;
+    window_skipped = 0;
+    window_total = 0;
+    window_max = 0;
+    window_max_late = 0;
 }
 
 /**
- * @brief Sets the ball object.
+ * @brief Converts a position from internal coordinates to those of the planner.
  *
- * @param ball Shared pointer to the Ball object
+ * The planner works in cm, within a 900 x 600 box starting at the corner of the field.
  */
-void Drona::setBall(std::shared_ptr<Ball> ball) {
-    this->ball = ball;
+static QPointF toPlanner(float x, float y) {
+    QPointF vision;
+    coordinates::toVision(std::make_pair(x, y), vision);
+    return QPointF(vision.x() / 10 + 450, vision.y() / 10 + 300);
 }
 
 /**
  * @brief Commands a bot to move to a specific (x, y) location using proportional control.
  *
- * Converts the target world coordinates into bot-relative coordinates and calculates
- * appropriate velocities. Populates the BotPacket with these values.
+ * Converts the target planner coordinates into coordinates relative to the predicted pose
+ * of the bot and calculates appropriate velocities. Populates the BotPacket with these values.
  *
  * @param id ID of the bot
  * @param x Target X coordinate
  * @param y Target Y coordinate
  * @param team Team identifier (BLUE or YELLOW)
- * @param packet Pointer to array of BotPacket to populate
+ * @param packets BotPackets to populate
  */
-void Drona::moveToPosition(int id, float x, float y, int team, BotPacket *packet) {
-    QPointF relative_pos;
-
-    if (team == Team::BLUE) {
-        relative_pos = pandav->at(id).mapFromScene(x, y);
-        packet[id].is_blue = true;
-    } else {
-        relative_pos = kaurav->at(id).mapFromScene(x, y);
-        packet[id].is_blue = false;
+void Drona::moveToPosition(int id, float x, float y, int team, BotPackets &packets) {
+    // vision ids go up to 15, but there is only a packet for the first bots of a team
+    if (id < 0 || id >= (team == Team::BLUE ? BLUE_BOTS : YELLOW_BOTS)) {
+        return;
     }
+    const auto &robots = team == Team::BLUE ? predicted.blue() : predicted.yellow();
+    auto robot = std::find_if(robots.begin(), robots.end(), [id](const world::Robot &r) { return int(r.id()) == id; });
+    if (robot == robots.end()) {
+        return;
+    }
+    packets[id].is_blue = team == Team::BLUE;
+
+    // target relative to the bot, x points forward
+    const QPointF position = toPlanner(robot->p_x(), robot->p_y());
+    const float orientation = coordinates::toVisionRotation(robot->phi());
+    const float dx = x - position.x();
+    const float dy = y - position.y();
+    const QPointF relative_pos(dx * std::cos(orientation) + dy * std::sin(orientation),
+                               -dx * std::sin(orientation) + dy * std::cos(orientation));
 
     QPointF err = relative_pos;
     float orientation_err = qAtan2(relative_pos.y(), relative_pos.x());
@@ -91,39 +234,40 @@ void Drona::moveToPosition(int id, float x, float y, int team, BotPacket *packet
     float vel_for = dist_err * kp;
     float vel_th = 2 * orientation_err;
 
-    packet[id].id = id;
-    packet[id].vel_angular = vel_th;
-    packet[id].vel_x = vel_for;
-    packet[id].vel_y = 0.0f;
-    packet[id].kick_speed = 5.0f;
+    packets[id].id = id;
+    packets[id].vel_angular = vel_th;
+    packets[id].vel_x = vel_for;
+    packets[id].vel_y = 0.0f;
+    packets[id].kick_speed = 5.0f;
 }
 
 /**
- * @brief Responds to new world state and sends updated velocity packets to bots.
+ * @brief Takes the latest world state and sends updated velocity packets to bots.
  *
- * This function is triggered by the Vyasa::receivedState signal. It plans paths and
- * uses moveToPosition to generate commands, resets packets, and emits the send signal
- * to Dhanush.
- *
- * @param buffer Unused buffer from world state (placeholder)
+ * This function runs once per tick on the strategy thread. It predicts where the bots will be
+ * when the commands arrive, plans paths on that state and uses moveToPosition to generate
+ * commands, resets packets, and emits the send signal to Dhanush.
  */
-void Drona::handleState(QByteArray* buffer) {
-    static int counter = 0;
+void Drona::tick() {
+    if (source == nullptr) return;
+    const WorldStatePtr state = source->load();
+    if (!state) return;
+    predictor.predict(*state, Timer::systemTime(), &predicted);
 
     std::vector<std::pair<double, double>> bot_pos;
-    for (int i = 0; i < kaurav->size(); ++i) {
-        bot_pos.push_back({kaurav->at(i).getx(), kaurav->at(i).gety()});
+    for (const world::Robot &robot : predicted.yellow()) {
+        const QPointF position = toPlanner(robot.p_x(), robot.p_y());
+        bot_pos.push_back({position.x(), position.y()});
     }
 
     std::pair<double, double> endpt = {0.0f, 100.0f};
 
-    if (counter == 100) {
+    if (plan_counter >= PLAN_INTERVAL && !bot_pos.empty()) {
         vertices = plan_path(bot_pos, endpt, 0);
-        counter = 0;
+        plan_counter = 0;
+        emit draw_graph(vertices);
     }
 
-    emit draw_graph(&vertices);
-
 #if defined(SIMULATOR_MODE)
     for (int i = 0; i < BLUE_BOTS; ++i) {
         m_blue_packet[i].id = i;
@@ -139,10 +283,17 @@ void Drona::handleState(QByteArray* buffer) {
         m_yellow_packet[i].vel_y = 0.0f;
     }
 
-    moveToPosition(10, ball->getPosition().x(), ball->getPosition().y(), Team::YELLOW, m_yellow_packet);
+    if (predicted.has_ball()) {
+        const QPointF ball = toPlanner(predicted.ball().p_x(), predicted.ball().p_y());
+        moveToPosition(10, ball.x(), ball.y(), Team::YELLOW, m_yellow_packet);
+    }
 
-    emit send(m_blue_packet);
-    emit send(m_yellow_packet);
+    if (!dry_run) {
+        emit send(m_blue_packet);
+        emit send(m_yellow_packet);
+        recordCommands(m_blue_packet);
+        recordCommands(m_yellow_packet);
+    }
 #else
     for (int i = 0; i < YELLOW_BOTS; ++i) {
         m_packet[i].id = i;
@@ -152,37 +303,39 @@ void Drona::handleState(QByteArray* buffer) {
         m_packet[i].vel_angular = 0.0f;
     }
 
-    if (!vertices.empty()) {
-        moveToPosition(kaurav->front().id, vertices.back().x(), vertices.back().y(), Team::YELLOW, m_packet);
+    if (!vertices.empty() && predicted.yellow_size() > 0) {
+        moveToPosition(predicted.yellow(0).id(), vertices.back().x(), vertices.back().y(), Team::YELLOW, m_packet);
     }
 
-    emit send(m_packet);
+    if (!dry_run) {
+        emit send(m_packet);
+        recordCommands(m_packet);
+    }
 #endif
-    counter++;
+    plan_counter++;
+    decisions++;
 }
 
 /**
- * @brief Destructor for Drona. Cleans up the thread and memory.
+ * @brief Tells the predictor which commands were just sent.
+ *
+ * @param packets Commands which were sent
  */
-Drona::~Drona() {
-    delete sender;
-    sender_thread.quit();
-    sender_thread.wait();
+void Drona::recordCommands(const BotPackets &packets) {
+    const qint64 now = Timer::systemTime();
+    for (const BotPacket &packet : packets) {
+        predictor.addCommand(packet.is_blue, packet.id, packet.vel_x, packet.vel_y, packet.vel_angular, now);
+    }
 }
 
 /**
- * @brief Sets color values for each HotMap scene element.
- *
- * This is a placeholder for hot map logic. Currently, it sets all color values to 0.
+ * @brief Destructor for Drona. Cleans up the thread and memory.
  */
-void HotMap::setHotMap() {
-    for (int i = 0; i < scene_mantri->size(); ++i) {
-        float color_value = 0;
-
-        // Strategy logic for hotmap could be added here
-
-        if (color_value <= 0) color_value = 0;
-        scene_mantri->at(i).updateColor(color_value, true);
-    }
+Drona::~Drona() {
+    // the strategy thread sends through the sender
+    stop();
+    // queued sends may still run on the sender thread, it must end before the sender is gone
+    sender_thread.quit();
+    sender_thread.wait();
+    delete sender;
 }
-
@@ -0,0 +1,277 @@
+#include "fieldevaluator.h"
+#include <Eigen/Core>
+#include <algorithm>
+
+namespace {
+    using Row = Eigen::Map<Eigen::ArrayXf>;
+    using ConstRow = Eigen::Map<const Eigen::ArrayXf>;
+
+    const float PRESSURE_SIGMA = 600;   // mm, distance at which an opponent still presses
+    const float LANE_SIGMA = 250;       // mm, distance at which an opponent blocks a pass lane
+    const float PASS_LENGTH = 3000;     // mm, longer passes are worth less
+    const float MOVE_TOLERANCE = 0.1f;  // cells, smaller moves keep the cached layers
+    // the kernels are 0 below, exponents far below it produce denormals which are very slow
+    const float MIN_EXPONENT = -20;
+
+    const int TILE_ROWS = 8;            // rows handled by a thread at once
+    const long PARALLEL_WORK = 20000;   // cells worth starting another thread for
+    const unsigned MAX_THREADS = 4;
+}
+
+FieldEvaluator::FieldEvaluator(int threads)
+    : threads(threads > 0 ? threads : int(std::max(1u, std::min(MAX_THREADS, std::thread::hardware_concurrency())))),
+      ball_position{0, 0}
+{
+}
+
+FieldEvaluator::~FieldEvaluator()
+{
+    {
+        std::lock_guard<std::mutex> lock(job_mutex);
+        stopping = true;
+    }
+    job_started.notify_all();
+    for (std::thread &helper : helpers) {
+        helper.join();
+    }
+}
+
+void FieldEvaluator::setGrid(int columns, int rows, float origin_x, float origin_y, float cell)
+{
+    if (columns == columns_ && rows == rows_ && origin_x == this->origin_x && origin_y == this->origin_y && cell == this->cell) {
+        return;
+    }
+    columns_ = std::max(0, columns);
+    rows_ = std::max(0, rows);
+    this->origin_x = origin_x;
+    this->origin_y = origin_y;
+    this->cell = cell;
+
+    xs.resize(columns_);
+    for (int c = 0; c < columns_; ++c) {
+        xs[c] = origin_x + c * cell;
+    }
+    const std::size_t cells = std::size_t(columns_) * rows_;
+    for (std::vector<float> *layer : {&shot_, &reach, &pass_, &pressure_, &score}) {
+        layer->assign(cells, 0);
+    }
+    for (Opponent &opponent : opponents) {
+        opponent.pressure.assign(cells, 0);
+        opponent.lane.assign(cells, 1);
+    }
+    invalidate();
+}
+
+void FieldEvaluator::setGoal(float x, float width)
+{
+    if (x == goal_x && width == goal_width) {
+        return;
+    }
+    goal_x = x;
+    goal_width = width;
+    invalidate();
+}
+
+void FieldEvaluator::setWeights(const Weights &weights)
+{
+    this->weights = weights;
+    invalidate();
+}
+
+void FieldEvaluator::invalidate()
+{
+    valid = false;
+}
+
+bool FieldEvaluator::hasMoved(const Point &from, const Point &to) const
+{
+    const float dx = to.x - from.x;
+    const float dy = to.y - from.y;
+    const float tolerance = MOVE_TOLERANCE * cell;
+    return dx * dx + dy * dy > tolerance * tolerance;
+}
+
+void FieldEvaluator::evaluate(const std::vector<Point> &positions, const Point *ball)
+{
+    updated_layers = 0;
+    if (columns_ == 0 || rows_ == 0) {
+        return;
+    }
+
+    const bool shot_dirty = !valid;
+    const bool ball_dirty = !valid || has_ball != (ball != nullptr) || (ball != nullptr && hasMoved(ball_position, *ball));
+    if (ball_dirty) {
+        has_ball = ball != nullptr;
+        if (ball != nullptr) {
+            ball_position = *ball;
+        }
+    }
+
+    bool changed = shot_dirty || ball_dirty || positions.size() != opponents.size();
+    const std::size_t cells = std::size_t(columns_) * rows_;
+    const std::size_t known = std::min(positions.size(), opponents.size());
+    opponents.resize(positions.size());
+    for (std::size_t i = 0; i < opponents.size(); ++i) {
+        Opponent &opponent = opponents[i];
+        opponent.moved = !valid || i >= known || hasMoved(opponent.position, positions[i]);
+        if (i >= known) {
+            opponent.pressure.assign(cells, 0);
+            opponent.lane.assign(cells, 1);
+        }
+        if (opponent.moved) {
+            opponent.position = positions[i];
+            updated_layers++;
+            // the pass lanes are only computed with a ball
+            if (has_ball) updated_layers++;
+        } else if (ball_dirty && has_ball) {
+            updated_layers++;
+        }
+        changed = changed || opponent.moved;
+    }
+    if (!changed) {
+        return;
+    }
+    updated_layers += (shot_dirty ? 1 : 0) + (ball_dirty ? 1 : 0);
+
+    // the layers are combined in any case, that counts as one more layer of work
+    forEachTile(long(cells) * (updated_layers + 1), [&](int from, int to) {
+        updateRows(from, to, shot_dirty, ball_dirty);
+    });
+    valid = true;
+}
+
+void FieldEvaluator::forEachTile(long work, const std::function<void(int, int)> &function)
+{
+    const int tiles = (rows_ + TILE_ROWS - 1) / TILE_ROWS;
+    const int workers = int(std::max(1L, std::min({long(threads), long(tiles), work / PARALLEL_WORK})));
+    job_tiles = tiles;
+    next_tile = 0;
+    if (workers == 1) {
+        visitTiles(function);
+        return;
+    }
+
+    // starting threads costs about as much as a small update, they are kept for the next ones
+    while (int(helpers.size()) < threads - 1) {
+        // only this thread publishes jobs, the new helper waits for the next one
+        helpers.emplace_back(&FieldEvaluator::runHelper, this, int(helpers.size()), job_generation);
+    }
+    {
+        std::lock_guard<std::mutex> lock(job_mutex);
+        job = &function;
+        job_helpers = workers - 1;
+        busy_helpers = workers - 1;
+        job_generation++;
+    }
+    job_started.notify_all();
+    // the calling thread takes tiles as well
+    visitTiles(function);
+
+    std::unique_lock<std::mutex> lock(job_mutex);
+    job_finished.wait(lock, [this]() { return busy_helpers == 0; });
+    job = nullptr;
+}
+
+void FieldEvaluator::visitTiles(const std::function<void(int, int)> &function)
+{
+    for (int tile = next_tile++; tile < job_tiles; tile = next_tile++) {
+        function(tile * TILE_ROWS, std::min(rows_, (tile + 1) * TILE_ROWS));
+    }
+}
+
+void FieldEvaluator::runHelper(int index, unsigned generation)
+{
+    for (;;) {
+        const std::function<void(int, int)> *function;
+        {
+            std::unique_lock<std::mutex> lock(job_mutex);
+            job_started.wait(lock, [this, generation]() { return stopping || job_generation != generation; });
+            if (stopping) {
+                return;
+            }
+            generation = job_generation;
+            // small jobs are not worth waking every helper for
+            if (index >= job_helpers) {
+                continue;
+            }
+            function = job;
+        }
+        visitTiles(*function);
+        {
+            std::lock_guard<std::mutex> lock(job_mutex);
+            busy_helpers--;
+        }
+        job_finished.notify_one();
+    }
+}
+
+void FieldEvaluator::updateRows(int from, int to, bool shot_dirty, bool ball_dirty)
+{
+    const ConstRow x(xs.data(), columns_);
+    const float pressure_scale = -1 / (2 * PRESSURE_SIGMA * PRESSURE_SIGMA);
+    const float lane_scale = -1 / (2 * LANE_SIGMA * LANE_SIGMA);
+    const float reach_scale = -1 / (2 * PASS_LENGTH * PASS_LENGTH);
+    const float post_left = -goal_width / 2;
+    const float post_right = goal_width / 2;
+
+    for (int r = from; r < to; ++r) {
+        const float y = origin_y + r * cell;
+        const std::size_t offset = std::size_t(r) * columns_;
+
+        if (shot_dirty) {
+            // sine of half the angle between the posts, 1 on the goal line and 0 behind it
+            Row shot(shot_.data() + offset, columns_);
+            const float left = post_left - y;
+            const float right = post_right - y;
+            const auto ax = goal_x - x;
+            const auto cosine = (ax.square() + left * right)
+                    / ((ax.square() + left * left) * (ax.square() + right * right)).sqrt().max(1.f);
+            shot = (x < goal_x).select(((1 - cosine) / 2).max(0.f).sqrt(), 0.f);
+        }
+
+        if (ball_dirty) {
+            Row row(reach.data() + offset, columns_);
+            if (has_ball) {
+                const float dy = y - ball_position.y;
+                row = (((x - ball_position.x).square() + dy * dy) * reach_scale).max(MIN_EXPONENT).exp();
+            } else {
+                row.setZero();
+            }
+        }
+
+        for (Opponent &opponent : opponents) {
+            if (opponent.moved) {
+                Row pressure(opponent.pressure.data() + offset, columns_);
+                const float dy = y - opponent.position.y;
+                pressure = (((x - opponent.position.x).square() + dy * dy) * pressure_scale).max(MIN_EXPONENT).exp();
+            }
+            if ((opponent.moved || ball_dirty) && has_ball) {
+                // distance of the opponent to the lane from the ball to the cell
+                Row lane(opponent.lane.data() + offset, columns_);
+                const auto vx = x - ball_position.x;
+                const float vy = y - ball_position.y;
+                const float wx = opponent.position.x - ball_position.x;
+                const float wy = opponent.position.y - ball_position.y;
+                // position of the closest point along the lane, the row holds it until the next line
+                lane = ((wx * vx + wy * vy) / (vx.square() + vy * vy).max(1.f)).max(0.f).min(1.f);
+                lane = 1 - (((wx - lane * vx).square() + (wy - lane * vy).square()) * lane_scale).max(MIN_EXPONENT).exp();
+            }
+        }
+
+        Row pressure(pressure_.data() + offset, columns_);
+        Row pass(pass_.data() + offset, columns_);
+        pressure.setZero();
+        pass = ConstRow(reach.data() + offset, columns_);
+        for (const Opponent &opponent : opponents) {
+            pressure += ConstRow(opponent.pressure.data() + offset, columns_);
+            if (has_ball) {
+                pass *= ConstRow(opponent.lane.data() + offset, columns_);
+            }
+        }
+        pressure = pressure.min(1.f);
+
+        Row row(score.data() + offset, columns_);
+        row = (weights.pass * pass + weights.shot * ConstRow(shot_.data() + offset, columns_)
+               - weights.pressure * pressure).max(-1.f).min(1.f);
+    }
+}
@@ -0,0 +1,57 @@
+/**
+ * @file hotmap.h
+ * @brief Defines the HotMap, which fills the heatmap of Kshetra with the scores of the FieldEvaluator of Drona
+ */
+#ifndef HOTMAP_H
+#define HOTMAP_H
+
+#include "yodha/yodha.h"
+#include "yodha/mantrimap.h"
+#include "drona/fieldevaluator.h"
+#include "core/worldsnapshot.h"
+#include <memory>
+#include <vector>
+
+/**
+ * @class HotMap
+ * @brief Visualizes how good each cell of the field is for the yellow team based on the current state.
+ *
+ * HotMap stores all relevant shared pointers (bots, ball, etc.), scores the cells with a FieldEvaluator
+ * and fills the heatmap with the scores.
+ */
+class HotMap
+{
+public:
+    std::shared_ptr<std::vector<BlueBot>> scene_pandav;  ///< Blue team bots for the scene.
+    std::shared_ptr<std::vector<YellowBot>> scene_kaurav; ///< Yellow team bots for the scene.
+    std::shared_ptr<Ball> scene_ball; ///< The ball in the scene.
+    MantriMap *scene_map; ///< The heatmap of the Mantri (strategists) in the scene.
+    FieldEvaluator *evaluator; ///< Scores the cells, kept between frames so only what moved is recomputed.
+    WorldSnapshotPtr state; ///< The current state of the game.
+
+    /**
+     * @brief HotMap constructor initializes all scene elements and the state.
+     * 
+     * @param scene_pandav Shared pointer to blue team bots.
+     * @param scene_kaurav Shared pointer to yellow team bots.
+     * @param scene_ball Shared pointer to the ball, nullptr if it was not seen yet.
+     * @param scene_map The heatmap to fill.
+     * @param evaluator The evaluator used for all frames.
+     * @param state The current game state.
+     */
+    HotMap(std::shared_ptr<std::vector<BlueBot>> scene_pandav,
+           std::shared_ptr<std::vector<YellowBot>> scene_kaurav,
+           std::shared_ptr<Ball> scene_ball,
+           MantriMap *scene_map,
+           FieldEvaluator *evaluator,
+           WorldSnapshotPtr state)
+        : scene_pandav(scene_pandav), scene_kaurav(scene_kaurav),
+          scene_ball(scene_ball), scene_map(scene_map), evaluator(evaluator), state(state) {}
+
+    /**
+     * @brief Scores the cells for the current positions of the bots and the ball and refreshes the heatmap.
+     */
+    void setHotMap();
+};
+
+#endif // HOTMAP_H
@@ -15,14 +15,20 @@
 #include <QObject>
 #include <QWidget>
 #include <QTimer>
+#include <QElapsedTimer>
 #include <QGraphicsView>
 #include <QGraphicsEllipseItem>
+#include <QGraphicsItemGroup>
+#include <QPixmap>
 #include "yodha/yodha.h"
-#include "yodha/mantri.h"
-#include "drona/drona.h"
+#include "yodha/mantrimap.h"
+#include "hotmap.h"
+#include "core/worldsnapshot.h"
+#include "sanjaya/sanjaya.h"
 #include "protobuf/ssl_wrapper.pb.h"
 #include "protobuf/ssl_geometry.pb.h"
 #include <google/protobuf/repeated_field.h>
+#include <unordered_map>
 
 //primitive graphics function for later use
 // convenience functions that draw some basic stuff
@@ -73,12 +79,34 @@ inline QGraphicsEllipseItem* addArc_(QGraphicsScene *scene, const QPointF center
  * @brief The Kshetra class represents the battlefield where the simulation takes place, ie the football
  * 
  * It draws the field, places the ball and the players on the field accroding to the messages received trhough ProtoBuff
- * It can optionally show the heatmap, that also gets updated every 10 frames.
+ * Everything is in one scene, the heatmap and the voronoi graph are overlay layers on top of the field which can be
+ * shown and hidden without touching the robots.
+ *
+ * Updates are coalesced, however often handleState is called the scene is redrawn at most once per display refresh.
+ * Ball and robots are drawn from the latest state of Sanjaya, which is what Drona plans on, the field from the
+ * geometry of the latest vision snapshot.
  */
 class Kshetra : public QGraphicsView
 {
     Q_OBJECT
 public:
+    /**
+    * @brief Frame time statistics of the renderer, collected over a few seconds
+    */
+    struct RenderStats {
+        int frames = 0;        ///< number of redraws
+        int coalesced = 0;     ///< updates which were merged into another redraw
+        double mean_ms = 0;    ///< mean time spent updating the scene per redraw
+        double max_ms = 0;     ///< longest time spent updating the scene
+    };
+
+    /**
+    * @brief Layers drawn over the field, see setOverlay
+    */
+    enum class Overlay {
+        HotMap,  ///< the heatmap of the FieldEvaluator, under the robots
+        Graph    ///< the voronoi graph of Drona
+    };
 
     explicit Kshetra( QWidget *parent=0);
     /**
@@ -104,7 +132,20 @@ public:
     void setBall(std::shared_ptr<Ball> ball);
 
     /**
-    * @brief sets up the scene and the scene_hotmap to a normal foorball field
+    * @brief Sets where handleState takes the geometry and the fused world state from
+    * @param source Slot of Vyasa or Smriti, the field is drawn from its geometry, must outlive Kshetra
+    * @param tracked_source Slot of the Sanjaya tracking source, ball and robots are drawn from it, must outlive Kshetra
+    */
+    void setSource(const WorldSnapshotSlot *source, const WorldStateSlot *tracked_source);
+
+    /**
+    * @brief Draws through a QOpenGLWidget instead of the raster engine
+    * @param enabled Whether to use OpenGL, off by default
+    */
+    void setOpenGL(bool enabled);
+
+    /**
+    * @brief sets up the scene to a normal foorball field
     * 
     * @param length takes the length in mm
     * @param width takes the width of the filed in mm
@@ -112,8 +153,10 @@ public:
     void setGround(qint32 length, qint32 width);
 
     /**
-    * @brief draws all the lines and arcs on to the scene
+    * @brief draws the ground, all the lines and arcs and the walls into the cached field layer
     * @param field_info The path of a protobuf object that contains the field lines and arcs
+    *
+    * The layer is only rebuilt when the geometry changes, it is drawn as the background of the scene
     */
     void setFieldLines(const SSL_GeometryFieldSize &field_info);
 
@@ -129,27 +172,29 @@ public:
 
      /**
     * @brief a toggle like function used to set the hotMap on and off.
+    *
+    * The heatmap replaces the voronoi graph while it is shown
     */
     void viewHotMap();
-    const QGraphicsScene *getScene(){
-        if(!see_hotmap_) return scene;
-        else return scene_hotmap;
-    }
+    /**
+    * @brief Shows or hides an overlay layer, takes effect right away
+    */
+    void setOverlay(Overlay overlay, bool visible);
+    bool overlayShown(Overlay overlay) const { return overlayLayer(overlay)->isVisible(); }
+    /**
+    * @brief Statistics of the last completed measuring window
+    */
+    const RenderStats &renderStats() const { return render_stats; }
+    const QGraphicsScene *getScene(){ return scene; }
     ~Kshetra();
 
 public slots:
     /**
-    * @brief Draws field and ball as received from vyasa in protobuff format, initializes the field only once and then if sethotmap is true, draws the hotmap
-    *
-    * @param buffer
-    *
-    * Called when Vyasa::receivedState signal is emitted
-    *
-    * Initializes ball if it doesn't exist, or updates position
+    * @brief Schedules a redraw from the latest snapshot and state of the sources
     *
-    * Sets scene if not set
+    * Called once per period of Sanjaya, calls before the next display refresh are merged into one redraw
     */
-    void handleState(QByteArray *buffer);
+    void handleState();
 
     /**
     * @brief This function deletes any existing linesa and draws lines connecting aadjacent vertices in the vector vertices.
@@ -157,35 +202,76 @@ public slots:
     * @param vertices A vector of QPointF objects representing the vertices of the graph
     * @return QGraphicsEllipseItem* A pointer to the created circle
     */
-    void handleGraph(std::vector<QPointF> *vertices);
+    void handleGraph(const std::vector<QPointF> &vertices);
 
     /**
-    * @brief Initializes the hotmap if not done already and updates it every 10 frames
+    * @brief Initializes the hotmap if not done already or the field size changed and scores the cells while it is shown
     */
     void setHotMap();
     void onRobotRightClicked(int id, QPointF position, float orientation);
 
+protected:
+    /**
+    * @brief Draws the cached field layer, the scenes only hold the moving items
+    */
+    void drawBackground(QPainter *painter, const QRectF &rect) override;
+
+private slots:
+    /**
+    * @brief Draws the field of the latest snapshot and ball and robots of the latest fused state, then scores the hotmap
+    *
+    * The field is only redrawn if the geometry changed, ball and robots only if the tracker published a new state
+    */
+    void render();
+
 private:
+    /**
+    * @brief Accumulates the frame time of a redraw and logs the statistics every few seconds
+    */
+    void recordFrame(qint64 start);
+    QPointF stateToScene(float x, float y);
+    QGraphicsItemGroup *overlayLayer(Overlay overlay) const;
+
     QGraphicsScene *scene;
-    QGraphicsScene *scene_hotmap;
-    QGraphicsScene *scene_hotmap_future;
+    // parents of the items of each overlay, hiding one hides all of its items
+    QGraphicsItemGroup *hotmap_layer;
+    QGraphicsItemGroup *graph_layer;
     QPainter *painter;
     std::shared_ptr<std::vector<BlueBot>> scene_pandav;
     std::shared_ptr<std::vector<YellowBot>> scene_kaurav;
     std::shared_ptr<Ball> scene_ball;
-    std::shared_ptr<std::vector<Mantri>> scene_mantri;
-    QVector<QGraphicsLineItem*> lines;
+    MantriMap *mantri_map = nullptr; // owned by hotmap_layer
+    FieldEvaluator field_evaluator; // scores the cells of mantri_map
+    QVector<QGraphicsLineItem*> lines; // lines of the voronoi graph, owned by graph_layer
+    QPixmap field_layer; // ground, field lines and walls, rendered once per geometry
+    QRectF field_layer_rect; // scene area covered by field_layer
     float color_value;
 
-    int frame;
-
-    SSL_WrapperPacket state;
+    const WorldSnapshotSlot *source = nullptr;
+    WorldSnapshotPtr state; // snapshot the field was last updated from
+    const WorldStateSlot *tracked_source = nullptr;
+    WorldStatePtr tracked; // fused state last drawn
     SSL_GeometryData field_geometry;
-    bool see_hotmap_;
+    std::string field_geometry_data; // serialized field_geometry, to detect changes
 
     bool has_state_;
     bool ball_init_ = false;
     bool bots_init_ = false;
+    // index of each robot id in scene_pandav and scene_kaurav
+    std::unordered_map<quint32, std::size_t> pandav_index;
+    std::unordered_map<quint32, std::size_t> kaurav_index;
+
+    QTimer render_timer;
+    QElapsedTimer clock;
+    qint64 frame_interval;   // ns between two redraws, one display refresh
+    qint64 last_render = 0;  // clock time of the last redraw, ns
+    // current measuring window of the statistics
+    int window_frames = 0;
+    int window_requests = 0;
+    qint64 window_start = 0;
+    qint64 window_total = 0;
+    qint64 window_max = 0;
+    RenderStats render_stats;
 public:
     signals:
     void robotSelected(int id, QPointF position, float orientation);
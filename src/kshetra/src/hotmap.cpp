@@ -0,0 +1,40 @@
+#include "hotmap.h"
+#include "protobuf/ssl_geometry.pb.h"
+
+/**
+ * @brief Sets the intensity of each cell of the heatmap.
+ *
+ * The heatmap cells lie on a 10 cm grid in scene coordinates, the evaluator works in vision coordinates
+ * whose origin is the center of the field. The yellow team attacks the goal at positive x.
+ */
+void HotMap::setHotMap() {
+    const int columns = scene_map->columns();
+    const int rows = scene_map->rows();
+    const QPointF center = scene_map->boundingRect().center();
+    const float cell = 10 * scene_map->boundingRect().width() / columns;
+    auto toVision = [&center](float x, float y) {
+        return FieldEvaluator::Point{float(10 * (x - center.x())), float(10 * (y - center.y()))};
+    };
+
+    evaluator->setGrid(columns, rows, -cell * (columns - 1) / 2, -cell * (rows - 1) / 2, cell);
+    const float goal_width = state && state->geometry ? state->geometry->field().goal_width() : 1000;
+    evaluator->setGoal(cell * (columns - 1) / 2, goal_width);
+
+    std::vector<FieldEvaluator::Point> opponents;
+    opponents.reserve(scene_pandav->size());
+    for (BlueBot &bot : *scene_pandav) {
+        opponents.push_back(toVision(bot.getx(), bot.gety()));
+    }
+    FieldEvaluator::Point ball;
+    if (scene_ball) ball = toVision(scene_ball->getx(), scene_ball->gety());
+    evaluator->evaluate(opponents, scene_ball ? &ball : nullptr);
+    if (evaluator->updatedLayers() == 0) return;
+
+    // the map shows the scores from -200 to 200
+    float *values = scene_map->values();
+    const float *scores = evaluator->values();
+    for (int i = 0; i < columns * rows; ++i) {
+        values[i] = 200 * scores[i];
+    }
+    scene_map->refresh();
+}
@@ -1,11 +1,20 @@
 #include "kshetra.h"
+#include "core/coordinates.h"
 #include <google/protobuf/repeated_field.h>
-#include <QNetworkDatagram>
+#include <algorithm>
 #include <cmath>
 #include <QString>
+#include <QGuiApplication>
+#include <QScreen>
+#include <QOpenGLWidget>
+#include <QSurfaceFormat>
 #define BALL_RADIUS 5
 #define ROBOT_RADIUS 10
 #define LOG qDebug() << "[kshetra] : "
+#define STATS_WINDOW 5000000000LL // statistics are logged every 5 s
+#define FIELD_LAYER_SCALE 2 // pixels per cm of the cached field layer
+#define GROUND_COLOR QColor(0,100,50)
+#define HOTMAP_CELL 10 // size of a hotmap cell in cm
 
 inline QGraphicsEllipseItem* addCircle_(QGraphicsScene *scene, const QPointF &center, int radius, QColor color)
 {
@@ -38,22 +47,37 @@ inline QPointF Kshetra::transformToScene(QPointF &&point)
 Kshetra::Kshetra(QWidget *parent):
     QGraphicsView(parent),
     painter(new QPainter()),
-    frame(0),
     scene(new QGraphicsScene(this)),
-    scene_hotmap(new QGraphicsScene(this))
+    hotmap_layer(new QGraphicsItemGroup()),
+    graph_layer(new QGraphicsItemGroup())
 {
-    scene_mantri = std::make_shared<std::vector<Mantri>>();
-    see_hotmap_ = false;
+    // the heatmap lies under the robots and the ball, the graph over them
+    hotmap_layer->setZValue(-1);
+    hotmap_layer->setVisible(false);
+    graph_layer->setZValue(1);
+    scene->addItem(hotmap_layer);
+    scene->addItem(graph_layer);
+    setScene(scene);
+
+    // redraw at most once per display refresh
+    qreal refresh_rate = QGuiApplication::primaryScreen() ? QGuiApplication::primaryScreen()->refreshRate() : 0;
+    if(refresh_rate <= 0) refresh_rate = 60;
+    frame_interval = qint64(1E9 / refresh_rate);
+    render_timer.setSingleShot(true);
+    render_timer.setTimerType(Qt::PreciseTimer);
+    connect(&render_timer, &QTimer::timeout, this, &Kshetra::render);
+    clock.start();
+
+    // the background only changes with the geometry, no need to draw it on every frame
+    setCacheMode(QGraphicsView::CacheBackground);
 }
 
 Kshetra::~Kshetra()
 {
     delete painter;
     delete scene;
-    delete scene_hotmap;
     painter = nullptr;
     scene = nullptr;
-    scene_hotmap = nullptr;
 }
 
 inline QPointF vecToPoint(const Vector2f &v){
@@ -79,46 +103,122 @@ void Kshetra::setBall(std::shared_ptr<Ball> ball)
 
 void Kshetra::viewHotMap()
 {
-    if (see_hotmap_ == true) {
-        see_hotmap_ = false;
-    } else {
-        see_hotmap_ = true;
-    }
+    const bool see_hotmap = !overlayShown(Overlay::HotMap);
+    setOverlay(Overlay::HotMap, see_hotmap);
+    setOverlay(Overlay::Graph, !see_hotmap);
+    // the map was not scored while it was hidden
+    if(see_hotmap && mantri_map != nullptr) setHotMap();
+
+    LOG << "VIEW CHANGED " << see_hotmap;
+}
 
-    LOG << "VIEW CHANGED " << see_hotmap_;
+QGraphicsItemGroup *Kshetra::overlayLayer(Overlay overlay) const
+{
+    return overlay == Overlay::HotMap ? hotmap_layer : graph_layer;
+}
+
+void Kshetra::setOverlay(Overlay overlay, bool visible)
+{
+    overlayLayer(overlay)->setVisible(visible);
 }
 // void Kshetra::setGrid(std::shared_ptr<Mantri> grid)
 // {
 //     scene_mantri = grid;
 // }
 
-void Kshetra::handleGraph(std::vector<QPointF> *vertices){
-    if(vertices->size() == 0)return;
-    for(auto line: lines){scene->removeItem(line);}
+void Kshetra::handleGraph(const std::vector<QPointF> &vertices){
+    if(vertices.size() == 0)return;
+    qDeleteAll(lines);
     lines.clear();
-    for(int i=0;i < vertices->size() - 1; ++i){
-        lines.append(addLine_(this->scene, vertices->at(i), vertices->at(i+1), 1));
+    for(std::size_t i=0;i < vertices.size() - 1; ++i){
+        QGraphicsLineItem *line = addLine_(this->scene, vertices[i], vertices[i+1], 1);
+        graph_layer->addToGroup(line);
+        lines.append(line);
     }
 }
 
+void Kshetra::setOpenGL(bool enabled)
+{
+    if(enabled){
+        QOpenGLWidget *gl = new QOpenGLWidget();
+        QSurfaceFormat format;
+        format.setSamples(4);
+        gl->setFormat(format);
+        setViewport(gl);
+        // partial updates are not cheaper with opengl, the whole frame is drawn anyway
+        setViewportUpdateMode(QGraphicsView::FullViewportUpdate);
+    }else{
+        setViewport(new QWidget());
+        setViewportUpdateMode(QGraphicsView::MinimalViewportUpdate);
+    }
+    LOG << "opengl" << enabled;
+}
+
+void Kshetra::drawBackground(QPainter *painter, const QRectF &rect)
+{
+    painter->fillRect(rect, GROUND_COLOR);
+    if(!field_layer.isNull()){
+        painter->drawPixmap(field_layer_rect, field_layer, QRectF(field_layer.rect()));
+    }
+}
+
+void Kshetra::setSource(const WorldSnapshotSlot *source, const WorldStateSlot *tracked_source)
+{
+    this->source = source;
+    this->tracked_source = tracked_source;
+}
+
 /**
- * @brief Draws field and ball as received from Vyasa
- *
- * @param buffer
+ * @brief converts a position of the fused state, in internal coordinates, to the scene
+ */
+QPointF Kshetra::stateToScene(float x, float y)
+{
+    std::pair<float, float> vision;
+    coordinates::toVision(std::make_pair(x, y), vision);
+    return transformToScene(QPointF(vision.first, vision.second));
+}
+
+/**
+ * @brief Schedules a redraw from the latest snapshot
  *
- * Called when Vyasa::receivedState signal is emitted
+ * Called once per period of Sanjaya, the redraw waits until a display refresh
+ * has passed since the last one, calls in between are merged into it
+ */
+void Kshetra::handleState()
+{
+    window_requests++;
+    if(render_timer.isActive()) return;
+    const qint64 wait = last_render + frame_interval - clock.nsecsElapsed();
+    render_timer.start(int(std::max<qint64>(0, (wait + 999999) / 1000000)));
+}
+
+/**
+ * @brief Draws field, ball and robots of the latest snapshot
  *
  * Initializes ball if it doesn't exist, or updates position
  *
  * Sets scene if not set
  */
-void Kshetra::handleState(QByteArray *buffer)
+void Kshetra::render()
 {
-    static bool scene_set = false;
-    //slot when message received by vyasa, draws the robots
-    if(state.ParseFromArray(buffer->data(), buffer->size())){
-        if(state.has_geometry()){
-            field_geometry = state.geometry();
+    if(source == nullptr || tracked_source == nullptr) return;
+    WorldSnapshotPtr snapshot = source->load();
+    WorldStatePtr fused = tracked_source->load();
+    const qint64 start = clock.nsecsElapsed();
+
+    // the field comes from the geometry of the snapshots, the tracker only fuses detections
+    if(snapshot && snapshot != state){
+        // vision repeats the geometry every few frames, the field is only redrawn if it differs
+        bool geometry_changed = snapshot->geometry && (!state || snapshot->geometry != state->geometry);
+        if(geometry_changed){
+            std::string geometry_data = snapshot->geometry->SerializeAsString();
+            geometry_changed = geometry_data != field_geometry_data;
+            field_geometry_data = std::move(geometry_data);
+        }
+        state = snapshot;
+
+        if(geometry_changed){
+            field_geometry = *state->geometry;
             qint32 field_width = field_geometry.field().field_length(); //refers to x axis
             qint32 field_height = field_geometry.field().field_width(); //refers to y axis
 
@@ -126,167 +226,150 @@ void Kshetra::handleState(QByteArray *buffer)
             setGround(field_width, field_height);
             setFieldLines(field_geometry.field());
         }
-        if(state.has_detection()){
-
-            if(state.detection().robots_yellow_size() != 0 && state.detection().robots_blue_size() != 0) setHotMap();
-
-            //drawing ball
-            if(state.detection().balls_size() != 0){
-                auto ball = state.detection().balls(0);
-                if(!ball_init_){
-                    *scene_ball = Ball(transformToScene(QPointF(ball.x(), ball.y())), scene, scene_hotmap);
-                    ball_init_ = true;
-                }else{
-                    scene_ball->updatePosition(transformToScene(QPointF(ball.x(), ball.y())));
-                }
-            }else{
-            }
-
-            //drawing robots
-            //blue bots
-            if(state.detection().robots_blue_size() != 0){
-                auto pandav = state.detection().robots_blue();
-                for(auto itr=pandav.begin(); itr != pandav.end(); ++itr){
-                    auto bot = std::find_if(scene_pandav->begin(), scene_pandav->end(), [&](BlueBot &b){return b.id == itr->robot_id();});
-                    if(bot == scene_pandav->end()){
-                        LOG << "adding robot " << itr->robot_id();
-                        scene_pandav->push_back(BlueBot(scene, scene_hotmap, transformToScene(QPointF(itr->x(), itr->y())), itr->orientation(), itr->robot_id()));
-                        continue;
-                    }
-                    bot->updatePosition(transformToScene(QPointF(itr->x(), itr->y())), itr->orientation());
-                }
-            }else{
-                LOG << "blue bots not there! paying respects";
-            }
-
-            //yellow bots
-            if(state.detection().robots_yellow_size() != 0){
-                auto kaurav = state.detection().robots_yellow();
-                for(auto itr=kaurav.begin(); itr != kaurav.end(); ++itr){
-                    auto bot = std::find_if(scene_kaurav->begin(), scene_kaurav->end(), [&](YellowBot &b){return b.id == itr->robot_id();});
-                    if(bot == scene_kaurav->end()){
-                        LOG << "adding robot " << itr->robot_id();
-                        scene_kaurav->push_back(YellowBot(scene, scene_hotmap, transformToScene(QPoint(itr->x(), itr->y())), itr->orientation(), itr->robot_id()));
-                        YellowBot &new_bot = scene_kaurav->back();
-                        connect(new_bot.getSignalEmitter(), &RobotSignalEmitter::robotRightClicked,this, &Kshetra::onRobotRightClicked);
-                        continue;
-                    }
-                    bot->updatePosition(transformToScene(QPoint(itr->x(), itr->y())), itr->orientation());
-                }
-                
-                
-            }else{
-                LOG << "yellow bots not there! paying respects";
-            }
-
-            if(see_hotmap_ == false) setScene(scene);
-            else setScene(scene_hotmap);
-
-            if(!scene_set){
-                setScene(scene);
-                scene_set = true;
-            }
+    }
+    // the tracker published nothing new since the last redraw
+    if(!fused || fused == tracked) return;
+    tracked = fused;
+
+    //drawing ball
+    if(tracked->has_ball()){
+        const QPointF position = stateToScene(tracked->ball().p_x(), tracked->ball().p_y());
+        if(!ball_init_){
+            *scene_ball = Ball(position, scene);
+            ball_init_ = true;
+        }else{
+            scene_ball->updatePosition(position);
+        }
+    }
+
+    //blue bots
+    for(const world::Robot &robot : tracked->blue()){
+        const QPointF position = stateToScene(robot.p_x(), robot.p_y());
+        const float orientation = coordinates::toVisionRotation(robot.phi());
+        auto index = pandav_index.find(robot.id());
+        if(index == pandav_index.end()){
+            LOG << "adding robot " << robot.id();
+            pandav_index[robot.id()] = scene_pandav->size();
+            scene_pandav->push_back(BlueBot(scene, position, orientation, robot.id()));
+            continue;
+        }
+        (*scene_pandav)[index->second].updatePosition(position, orientation);
+    }
+
+    //yellow bots
+    for(const world::Robot &robot : tracked->yellow()){
+        const QPointF position = stateToScene(robot.p_x(), robot.p_y());
+        const float orientation = coordinates::toVisionRotation(robot.phi());
+        auto index = kaurav_index.find(robot.id());
+        if(index == kaurav_index.end()){
+            LOG << "adding robot " << robot.id();
+            kaurav_index[robot.id()] = scene_kaurav->size();
+            scene_kaurav->push_back(YellowBot(scene, position, orientation, robot.id()));
+            YellowBot &new_bot = scene_kaurav->back();
+            connect(new_bot.getSignalEmitter(), &RobotSignalEmitter::robotRightClicked,this, &Kshetra::onRobotRightClicked);
+            continue;
         }
+        (*scene_kaurav)[index->second].updatePosition(position, orientation);
     }
+    if(tracked->yellow_size() > 0 && tracked->blue_size() > 0) setHotMap();
+    if(tracked->blue_size() == 0) LOG << "blue bots not there! paying respects";
+    if(tracked->yellow_size() == 0) LOG << "yellow bots not there! paying respects";
+
+    recordFrame(start);
+}
+
+void Kshetra::recordFrame(qint64 start)
+{
+    const qint64 now = clock.nsecsElapsed();
+    const qint64 frame_time = now - start;
+    last_render = now;
+    window_frames++;
+    window_total += frame_time;
+    window_max = std::max(window_max, frame_time);
+
+    if(now - window_start < STATS_WINDOW) return;
+    render_stats.frames = window_frames;
+    render_stats.coalesced = std::max(0, window_requests - window_frames);
+    render_stats.mean_ms = window_total / 1E6 / window_frames;
+    render_stats.max_ms = window_max / 1E6;
+    LOG << "frames" << render_stats.frames << "coalesced" << render_stats.coalesced
+        << "mean" << render_stats.mean_ms << "ms max" << render_stats.max_ms << "ms";
+
+    window_start = now;
+    window_frames = 0;
+    window_requests = 0;
+    window_total = 0;
+    window_max = 0;
 }
 
 
 void Kshetra::setGround(qint32 width, qint32 height)
 {
-    //sets the ground and field color with dimensions, the length received should be in mm
+    //sets the dimensions of the scene, the length received should be in mm
     // backend uses mm in protobuf messages while QGraphicsScene uses cm.
-    static bool background_init_ = false;
-    if(background_init_) return;
     scene->setSceneRect(QRectF(0,0,width/10, height/10));
-    scene->setBackgroundBrush(QColor(0,100,50));
-    scene->addRect(QRectF(0,0,width/10, height/10), QPen(), Qt::darkGreen);
-
-    scene_hotmap->setSceneRect(QRectF(0,0,width/10, height/10));
-    scene_hotmap->setBackgroundBrush(QColor(0,100,50));
-    scene_hotmap->addRect(QRectF(0,0,width/10, height/10), QPen(), Qt::darkGreen);
-
-    background_init_ = true;
 }
 
 
 void Kshetra::setFieldLines(const SSL_GeometryFieldSize &field_info)
 {
     // All the white lines are actually defined in protobuf/geometry.cpp
-    // and are drawn here in kshetra.cpp
-    // just above this comment block.
-
-    // The black lines are both defined here and are drawn here itself in kshetra.cpp
-    // The wall_offset and te
-
-    // Get field geometry from the protobuf
-    const auto& field = field_geometry.field();  // SSL_GeometryFieldSize
-    float fieldLengthHalf = field.field_length() / 2.0f;
-    float fieldWidthHalf  = field.field_width()  / 2.0f;
-    float wallOffset      = field.boundary_width();  // all in mm
-
-    auto drawWallLine = [&](float x1, float y1, float x2, float y2) {
-        QGraphicsLineItem* wall = scene->addLine(
-            QLineF(transformToScene(QPointF(x1, y1)), transformToScene(QPointF(x2, y2))),
-            QPen(QBrush(Qt::black), 2)
-            );
-        this->lines.append(wall);
-    };
-
-
-    // Top wall (make left/right longer by wallOffset)
-    drawWallLine(-fieldLengthHalf - wallOffset,  fieldWidthHalf + wallOffset,
-                 fieldLengthHalf + wallOffset,  fieldWidthHalf + wallOffset);
-
-    // Bottom wall
-    drawWallLine(-fieldLengthHalf - wallOffset, -fieldWidthHalf - wallOffset,
-                 fieldLengthHalf + wallOffset, -fieldWidthHalf - wallOffset);
-
-    // Left wall (make top/bottom longer)
-    drawWallLine(-fieldLengthHalf - wallOffset, -fieldWidthHalf - wallOffset,
-                 -fieldLengthHalf - wallOffset,  fieldWidthHalf + wallOffset);
-
-    // Right wall
-    drawWallLine(fieldLengthHalf + wallOffset, -fieldWidthHalf - wallOffset,
-                 fieldLengthHalf + wallOffset,  fieldWidthHalf + wallOffset);
-
-
-    //not storing the field lines since they are static
-    static bool lines_init_ = false;
-    if(lines_init_) return;
-    auto lines = field_info.field_lines();
-    for(auto itr=lines.begin(); itr != lines.end(); ++itr){
-        addLine_(scene, transformToScene(vecToPoint(itr->p1())), transformToScene(vecToPoint(itr->p2())), itr->thickness());
+    // and are painted here together with the ground and the black walls.
+    // Nothing of this is a scene item, the whole layer is drawn by drawBackground.
+    const float wall_offset = field_info.boundary_width() / 10.0f;  // in cm
+    const float wall_width = 2;
+    const QRectF ground(0, 0, scene->width(), scene->height());
+    field_layer_rect = ground.adjusted(-wall_offset - wall_width, -wall_offset - wall_width,
+                                       wall_offset + wall_width, wall_offset + wall_width);
+
+    QPixmap layer((field_layer_rect.size() * FIELD_LAYER_SCALE).toSize());
+    layer.fill(GROUND_COLOR);
+    QPainter layer_painter(&layer);
+    layer_painter.setRenderHint(QPainter::Antialiasing);
+    layer_painter.scale(FIELD_LAYER_SCALE, FIELD_LAYER_SCALE);
+    layer_painter.translate(-field_layer_rect.topLeft());
+
+    layer_painter.setPen(QPen());
+    layer_painter.setBrush(Qt::darkGreen);
+    layer_painter.drawRect(ground);
+
+    layer_painter.setBrush(Qt::NoBrush);
+    for(const auto &line : field_info.field_lines()){
+        layer_painter.setPen(QPen(QBrush(Qt::white), line.thickness()));
+        layer_painter.drawLine(QLineF(transformToScene(vecToPoint(line.p1())), transformToScene(vecToPoint(line.p2()))));
     }
-
-    auto arcs = field_info.field_arcs();
-    for(auto itr=arcs.begin(); itr != arcs.end(); ++itr){
-        addArc_(scene, transformToScene(vecToPoint(itr->center())), itr->radius()/10, itr->thickness());
+    for(const auto &arc : field_info.field_arcs()){
+        const int radius = arc.radius()/10;
+        layer_painter.setPen(QPen(QBrush(Qt::white), arc.thickness()));
+        layer_painter.drawEllipse(transformToScene(vecToPoint(arc.center())), radius, radius);
     }
 
-    lines_init_ = true;
+    // walls around the boundary
+    layer_painter.setPen(QPen(QBrush(Qt::black), wall_width));
+    layer_painter.drawRect(ground.adjusted(-wall_offset, -wall_offset, wall_offset, wall_offset));
+    layer_painter.end();
+
+    field_layer = layer;
+    resetCachedContent();
 }
 
 
 void Kshetra::setHotMap()
 {
-    static bool map_init_ = false;
-    frame++;
-
-    HotMap HP(scene_pandav, scene_kaurav, scene_ball, scene_mantri, state);
-
-    if(map_init_ == false)
+    // one cell every HOTMAP_CELL cm, centered on the field lines
+    const int columns = int(scene->width() / HOTMAP_CELL) + 1;
+    const int rows = int(scene->height() / HOTMAP_CELL) + 1;
+    if(mantri_map == nullptr || mantri_map->columns() != columns || mantri_map->rows() != rows)
     {
-        for(int i = -4500; i <= 4500; i+=100){
-            for(int j = -3000; j<= 3000; j+=100){
-                scene_mantri->push_back(Mantri(scene_hotmap,transformToScene(QPointF(i, j)), 0, 5, 5));
-            }
-        }
-
-        map_init_ = true;
+        delete mantri_map;
+        mantri_map = new MantriMap(columns, rows, QRectF(-HOTMAP_CELL/2.0, -HOTMAP_CELL/2.0, columns*HOTMAP_CELL, rows*HOTMAP_CELL));
+        hotmap_layer->addToGroup(mantri_map);
         return;
     }
 
-    if(frame%10 == 0){
+    // the evaluator only recomputes what moved, but nothing has to be computed while the map is hidden
+    if(overlayShown(Overlay::HotMap)){
+        HotMap HP(scene_pandav, scene_kaurav, ball_init_ ? scene_ball : nullptr, mantri_map, &field_evaluator, state);
         HP.setHotMap();
     }
 }
@@ -0,0 +1,109 @@
+/*
+ * The simulator is divided into various components.
+ * If you are versed with mythology, you may be able to
+ * guess each component's purpose.
+ *
+ * Kuruk headless: the war without the battlefield.
+ *  Runs Vyasa (or Smriti), Sanjaya and Drona from the command line. There are
+ *  no widgets, no scene and no SDL, so many instances can run on a server.
+ */
+
+#include "vyasa/vyasa.h"
+#include "smriti/smriti.h"
+#include "sanjaya/sanjaya.h"
+#include "drona/drona.h"
+#include "core/sslprotocols.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <csignal>
+#include <cstdio>
+
+namespace {
+    volatile std::sig_atomic_t interrupted = 0;
+
+    void interrupt(int)
+    {
+        interrupted = 1;
+    }
+}
+
+int main(int argc, char **argv){
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("kuruk-headless");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Runs tracking and strategy against vision without a GUI and reports the decisions per second");
+    parser.addHelpOption();
+    QCommandLineOption replayOption("replay", "Replay a recording instead of listening to vision", "file");
+    QCommandLineOption speedOption("replay-speed", "Replay speed, 0 replays as fast as possible", "factor", "1");
+    QCommandLineOption addressOption("vision-address", "Address to listen to for vision", "address", SSL_VISION_ADDRESS_LOCALHOST);
+    QCommandLineOption portOption("vision-port", "Port to listen to for vision", "port", QString::number(SSL_SIMULATED_VISION_PORT));
+    QCommandLineOption rateOption("rate", "Decisions per second, 0 decides as fast as possible and implies --dry-run", "hz", "100");
+    QCommandLineOption dryRunOption("dry-run", "Decide without sending commands to the simulator");
+    QCommandLineOption durationOption("duration", "Stop after this many seconds, 0 runs until interrupted", "seconds", "0");
+    parser.addOption(replayOption);
+    parser.addOption(speedOption);
+    parser.addOption(addressOption);
+    parser.addOption(portOption);
+    parser.addOption(rateOption);
+    parser.addOption(dryRunOption);
+    parser.addOption(durationOption);
+    parser.process(app);
+
+    const double rate = parser.value(rateOption).toDouble();
+    const double duration = parser.value(durationOption).toDouble();
+
+    Sanjaya sanjaya;
+    if (parser.isSet(replayOption)) {
+        Smriti *smriti = new Smriti(&app);
+        if (!smriti->open(parser.value(replayOption))) {
+            std::fprintf(stderr, "Could not open %s\n", qPrintable(parser.value(replayOption)));
+            return 1;
+        }
+        smriti->setSpeed(parser.value(speedOption).toDouble());
+        sanjaya.setSource(&smriti->snapshots());
+        QObject::connect(smriti, &Smriti::finished, &app, &QCoreApplication::quit);
+        smriti->play();
+    } else {
+        Vyasa *vyasa = new Vyasa(&app);
+        vyasa->setPortAndAddress(parser.value(portOption).toInt(), parser.value(addressOption));
+        sanjaya.setSource(&vyasa->snapshots());
+    }
+
+    // drona is destroyed before sanjaya, whose states it reads
+    Drona drona;
+    drona.setSource(&sanjaya.states());
+    drona.setRate(rate);
+    // back to back ticks would flood the simulator with commands
+    drona.setDryRun(parser.isSet(dryRunOption) || rate <= 0);
+
+    // QCoreApplication::quit is not safe to call in a signal handler, the flag is polled instead
+    std::signal(SIGINT, interrupt);
+    std::signal(SIGTERM, interrupt);
+    QTimer poll;
+    QObject::connect(&poll, &QTimer::timeout, &app, []() {
+        if (interrupted) QCoreApplication::quit();
+    });
+    poll.start(100);
+    if (duration > 0) {
+        QTimer::singleShot(qRound(duration * 1000), &app, &QCoreApplication::quit);
+    }
+
+    QElapsedTimer clock;
+    clock.start();
+    drona.start();
+    const int result = app.exec();
+    drona.stop();
+
+    const double seconds = clock.nsecsElapsed() / 1E9;
+    const qint64 decisions = drona.decisionCount();
+    const Drona::TickStats stats = drona.tickStats();
+    std::printf("%lld decisions in %.1f s, %.1f decisions per second\n", (long long)decisions, seconds, decisions / seconds);
+    if (stats.ticks > 0) {
+        std::printf("last window: %d ticks, %d overruns, %d skipped, mean %.3f ms, max %.3f ms, late %.3f ms\n",
+                    stats.ticks, stats.overruns, stats.skipped, stats.mean_ms, stats.max_ms, stats.max_late_ms);
+    }
+    return result;
+}
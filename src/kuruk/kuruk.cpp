@@ -5,6 +5,7 @@
 #include <QLabel>
 #include <QDebug>
 #include <QDockWidget> 
+#include <QMenuBar>
 #define LOG qDebug() << "[kuruk] : "
 
 QLabel* Kuruk::robotIdLabel = nullptr;
@@ -22,6 +23,7 @@ Kuruk::Kuruk(QWidget *parent)
     ui(new Ui::kuruk), ///new ui element
     vyasa(new Vyasa(this)), ///new vyasa instance
     shunya(new Shunya(this)),///new shunya instance
+    sanjaya(new Sanjaya(this)),///new sanjaya instance
     drona(new Drona(this)),///new drona instance
     vishnu(new Vishnu(this)) ///new vishnu instance
 {
@@ -51,20 +53,22 @@ Kuruk::Kuruk(QWidget *parent)
     kaurav = std::make_shared<std::vector<YellowBot>>();
     ball = std::make_shared<Ball>(Qt::black, 5);
 
-    /// giving ownership of players and ball to kshetra and drona
+    /// giving ownership of players and ball to kshetra
     ui->kshetra->setPlayers(pandav, kaurav);
     ui->kshetra->setBall(ball);
     ui->kshetra->setFixedSize(1280, 720);  // hardcoded override
-    drona->setPlayers(pandav, kaurav);
-    drona->setBall(ball);
 
-    connect(vyasa, &Vyasa::recievedState, ui->kshetra, &Kshetra::handleState);
+    // sanjaya fuses the cameras, kshetra and drona run once per tracker period
+    // instead of once per camera frame, and both see the same fused state
+    ui->kshetra->setSource(&vyasa->snapshots(), &sanjaya->states());
+    sanjaya->setSource(&vyasa->snapshots());
+    connect(sanjaya, &Sanjaya::updatedState, ui->kshetra, &Kshetra::handleState);
     // voronoi graph
     // connect(drona, &Drona::draw_graph, ui->kshetra, &Kshetra::handleGraph);
-    // make sure vyasa is connected to drona AFTER kshetra, since kshetra updates
-    // the bot position, and the new bot positions are used by drona
-    // forums online say not to rely on the ordering of slots but, idgaf
-    connect(vyasa, &Vyasa::recievedState, drona, &Drona::handleState);
+    // drona plans on the fused state, predicted to the time its commands arrive,
+    // on its own thread at a fixed rate which does not wait for the gui or for vision
+    drona->setSource(&sanjaya->states());
+    drona->start();
     connect(ui->actionreset, &QAction::triggered, shunya, &Shunya::setup);
     connect(ui->actionHotMap, &QAction::triggered, ui->kshetra, &Kshetra::viewHotMap);
     connect(ui->actionAttack, &QAction::triggered, shunya, &Shunya::attack_setup);
@@ -86,6 +90,34 @@ Kuruk::~Kuruk(){
     drona = nullptr;
 }
 
+bool Kuruk::startReplay(const QString& filename, double speed)
+{
+    smriti = new Smriti(this);
+    if (!smriti->open(filename)) {
+        return false;
+    }
+    smriti->setSpeed(speed);
+
+    // the replay takes the place of vyasa, sanjaya keeps driving kshetra and drona
+    ui->kshetra->setSource(&smriti->snapshots(), &sanjaya->states());
+    sanjaya->setSource(&smriti->snapshots());
+    connect(smriti, &Smriti::finished, this, []() { LOG << "replay finished"; });
+
+    QMenu* replayMenu = menuBar()->addMenu("Replay");
+    replayMenu->addAction("Play / Pause", smriti, &Smriti::togglePause, QKeySequence(Qt::Key_Space));
+    replayMenu->addAction("Step frame", smriti, &Smriti::stepFrame, QKeySequence(Qt::Key_Period));
+    replayMenu->addAction("Back 5 s", this, [this]() { smriti->skip(-5000000000LL); }, QKeySequence(Qt::Key_Left));
+    replayMenu->addAction("Forward 5 s", this, [this]() { smriti->skip(5000000000LL); }, QKeySequence(Qt::Key_Right));
+
+    smriti->play();
+    return true;
+}
+
+void Kuruk::setOpenGL(bool enabled)
+{
+    ui->kshetra->setOpenGL(enabled);
+}
+
 void Kuruk::updateSidebar(int id, QPointF position, float orientation) {
 
     // Assuming your sidebar is in a QWidget or custom widget:
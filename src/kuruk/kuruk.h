@@ -18,6 +18,8 @@
 #include <QLabel>
 #include "ui_kuruk.h"
 #include "vyasa/vyasa.h"
+#include "smriti/smriti.h"
+#include "sanjaya/sanjaya.h"
 #include "shunya/shunya.h"
 #include "drona/drona.h"
 #include "yodha/yodha.h"
@@ -40,11 +42,27 @@ public:
     QDockWidget* sidebarDockWidget;
     ~Kuruk();
 
+    /**
+     * @brief Replays a recording instead of listening to live vision
+     * @param filename recording written by the simulator's --record option
+     * @param speed replay speed, 0 replays as fast as possible
+     * @return false if the recording could not be opened
+     */
+    bool startReplay(const QString& filename, double speed);
+
+    /**
+     * @brief Draws the field through OpenGL instead of the raster engine
+     * @param enabled Whether to use OpenGL
+     */
+    void setOpenGL(bool enabled);
+
 private:
     Ui::kuruk *ui;
     Shunya *shunya;
+    Sanjaya *sanjaya;
     Drona *drona;
     Vishnu *vishnu;
+    Smriti *smriti = nullptr;
     std::shared_ptr<std::vector<BlueBot>> pandav;
     std::shared_ptr<std::vector<YellowBot>> kaurav;
     std::shared_ptr<Ball> ball;
@@ -1,5 +1,6 @@
 #include "kuruk.h"
 #include <QApplication>
+#include <QCommandLineParser>
 
 int main(int argc, char **argv){
     QApplication a(argc, argv);
@@ -13,7 +14,23 @@ int main(int argc, char **argv){
     // When the application closes:
     SDL_Quit();
 
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption replayOption("replay", "Replay a recording instead of listening to vision", "file");
+    QCommandLineOption speedOption("replay-speed", "Replay speed, 0 replays as fast as possible", "factor", "1");
+    QCommandLineOption openGLOption("opengl", "Draw the field through OpenGL");
+    parser.addOption(replayOption);
+    parser.addOption(speedOption);
+    parser.addOption(openGLOption);
+    parser.process(a);
+
     Kuruk shetra; ///creates object shetra of type kuruk
+    if (parser.isSet(openGLOption)) {
+        shetra.setOpenGL(true);
+    }
+    if (parser.isSet(replayOption) && !shetra.startReplay(parser.value(replayOption), parser.value(speedOption).toDouble())) {
+        return 1;
+    }
     shetra.show(); //show shetra
 
     qDebug() << "executing...";
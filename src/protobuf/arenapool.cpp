@@ -0,0 +1,90 @@
+/***************************************************************************
+ *   Copyright 2026 Kuruk contributors                                     *
+ *                                                                         *
+ *   This program is free software: you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation, either version 3 of the License, or     *
+ *   any later version.                                                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#include "arenapool.h"
+#include <cstddef>
+
+struct ArenaPool::Entry
+{
+    static const std::size_t INITIAL_BLOCK_SIZE = 4096;
+
+    Entry() : arena(options(block)) {}
+
+    static google::protobuf::ArenaOptions options(char *block)
+    {
+        google::protobuf::ArenaOptions options;
+        options.initial_block = block;
+        options.initial_block_size = INITIAL_BLOCK_SIZE;
+        options.max_block_size = 32 * 1024;
+        return options;
+    }
+
+    alignas(std::max_align_t) char block[INITIAL_BLOCK_SIZE];
+    google::protobuf::Arena arena;
+};
+
+ArenaPool &ArenaPool::instance()
+{
+    // intentionally leaked, arenas may still be released during static destruction
+    static ArenaPool *pool = new ArenaPool;
+    return *pool;
+}
+
+ArenaPool::~ArenaPool()
+{
+    for (Entry *entry : m_free) {
+        delete entry;
+    }
+}
+
+QSharedPointer<google::protobuf::Arena> ArenaPool::acquire()
+{
+    Entry *entry = nullptr;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_free.empty()) {
+            entry = m_free.back();
+            m_free.pop_back();
+        }
+    }
+    if (!entry) {
+        entry = new Entry;
+    }
+    return QSharedPointer<google::protobuf::Arena>(&entry->arena, [this, entry](google::protobuf::Arena *) {
+        release(entry);
+    });
+}
+
+int ArenaPool::available() const
+{
+    QMutexLocker locker(&m_mutex);
+    return static_cast<int>(m_free.size());
+}
+
+void ArenaPool::release(Entry *entry)
+{
+    // frees every block except the initial one
+    entry->arena.Reset();
+
+    QMutexLocker locker(&m_mutex);
+    if (m_free.size() < MAX_POOLED_ARENAS) {
+        m_free.push_back(entry);
+        return;
+    }
+    locker.unlock();
+    delete entry;
+}
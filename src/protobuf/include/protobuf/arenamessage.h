@@ -0,0 +1,88 @@
+/***************************************************************************
+ *   Copyright 2026 Kuruk contributors                                     *
+ *                                                                         *
+ *   This program is free software: you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation, either version 3 of the License, or     *
+ *   any later version.                                                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#ifndef ARENAMESSAGE_H
+#define ARENAMESSAGE_H
+
+#include "protobuf/arenapool.h"
+#include <QSharedPointer>
+
+//! @file arenamessage.h
+//! @addtogroup protobuf
+//! @{
+
+/*!
+ * \brief Reference counted protobuf message wrapper
+ *
+ * Behaves like a QSharedPointer to the message. Messages created with createArena()
+ * live on an arena taken from the ArenaPool, which is recycled once the last copy of
+ * the wrapper is gone.
+ */
+template<typename Message>
+class ArenaMessage {
+public:
+    ArenaMessage() {}
+
+    ArenaMessage(Message *message) {
+        m_message = QSharedPointer<Message>(message);
+    }
+
+    void clear() {
+        m_message.clear();
+        m_arenaMessage = nullptr;
+        m_arena.clear();
+    }
+
+    bool isNull() const {
+        return m_arena.isNull() && m_message.isNull();
+    }
+
+    Message * data() const {
+        if (m_arena.isNull())
+            return m_message.data();
+        else
+            return m_arenaMessage;
+    }
+
+    Message & operator*() const {
+        return *data();
+    }
+
+    Message * operator->() const {
+        return data();
+    }
+
+    static ArenaMessage createArena() {
+        QSharedPointer<google::protobuf::Arena> arena = ArenaPool::instance().acquire();
+        Message *m = google::protobuf::Arena::CreateMessage<Message>(arena.data());
+        return ArenaMessage(m, arena);
+    }
+
+private:
+    ArenaMessage(Message *message, const QSharedPointer<google::protobuf::Arena> &arena) {
+        m_arenaMessage = message;
+        m_arena = arena;
+    }
+
+    QSharedPointer<Message> m_message;
+    Message *m_arenaMessage = nullptr;
+    QSharedPointer<google::protobuf::Arena> m_arena;
+};
+
+//! @}
+
+#endif // ARENAMESSAGE_H
@@ -0,0 +1,65 @@
+/***************************************************************************
+ *   Copyright 2026 Kuruk contributors                                     *
+ *                                                                         *
+ *   This program is free software: you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation, either version 3 of the License, or     *
+ *   any later version.                                                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#ifndef ARENAPOOL_H
+#define ARENAPOOL_H
+
+#include <google/protobuf/arena.h>
+#include <QMutex>
+#include <QSharedPointer>
+#include <vector>
+
+//! @file arenapool.h
+//! @addtogroup protobuf
+//! @{
+
+/*!
+ * \brief Process wide pool of recycled protobuf arenas
+ *
+ * Every arena owns a fixed initial block which survives google::protobuf::Arena::Reset.
+ * Small messages like commands or simulator errors therefore never touch the heap
+ * once the pool is warmed up. Arenas are handed out as shared pointers which reset
+ * the arena and return it to the pool when the last reference is dropped, which
+ * may happen on any thread.
+ */
+class ArenaPool
+{
+public:
+    static ArenaPool &instance();
+
+    ArenaPool(const ArenaPool&) = delete;
+    ArenaPool& operator=(const ArenaPool&) = delete;
+
+    QSharedPointer<google::protobuf::Arena> acquire();
+    int available() const;
+
+private:
+    struct Entry;
+
+    ArenaPool() = default;
+    ~ArenaPool();
+    void release(Entry *entry);
+
+    static const int MAX_POOLED_ARENAS = 64;
+
+    mutable QMutex m_mutex;
+    std::vector<Entry*> m_free;
+};
+
+//! @}
+
+#endif // ARENAPOOL_H
@@ -22,14 +22,14 @@
 #define COMMAND_H
 
 #include "protobuf/command.pb.h"
-#include <QSharedPointer>
+#include "protobuf/arenamessage.h"
 
 //! @file command.h
 //! @addtogroup protobuf
 //! @{
 
 //! Protobuf command wrapper with reference counting
-typedef QSharedPointer<amun::Command> Command;
+typedef ArenaMessage<amun::Command> Command;
 
 void simulatorSetupSetDefault(amun::SimulatorSetup &setup);
 
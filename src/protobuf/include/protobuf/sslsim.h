@@ -23,8 +23,8 @@
 
 #include "protobuf/ssl_simulation_robot_control.pb.h"
 #include "protobuf/ssl_simulation_error.pb.h"
-#include <QSharedPointer>
+#include "protobuf/arenamessage.h"
 
-typedef QSharedPointer<sslsim::RobotControl> SSLSimRobotControl;
-typedef QSharedPointer<sslsim::SimulatorError> SSLSimError;
+typedef ArenaMessage<sslsim::RobotControl> SSLSimRobotControl;
+typedef ArenaMessage<sslsim::SimulatorError> SSLSimError;
 #endif
@@ -0,0 +1,74 @@
+#ifndef KALMANFILTER_H
+#define KALMANFILTER_H
+
+#include <Eigen/Dense>
+
+/**
+ * @class KalmanFilter
+ * @brief Linear Kalman filter with N state and M measurement dimensions.
+ * The models are passed in on every step, so one filter type serves
+ * the ball and the robots. The innovation is computed by the caller,
+ * which allows wrapping angles before the update.
+ */
+
+template<int N, int M>
+class KalmanFilter {
+    public:
+        typedef Eigen::Matrix<double, N, 1> Vector;
+        typedef Eigen::Matrix<double, N, N> Matrix;
+        typedef Eigen::Matrix<double, M, 1> Measurement;
+        typedef Eigen::Matrix<double, M, N> Observation;
+        typedef Eigen::Matrix<double, M, M> MeasurementCovariance;
+
+        KalmanFilter() : _x(Vector::Zero()), _p(Matrix::Identity()) {}
+
+        void reset(const Vector& x, const Matrix& p)
+        {
+            _x = x;
+            _p = p;
+        }
+
+        /**
+        * @brief Advances the state with the process model
+        * @param f State transition matrix
+        * @param q Process noise covariance
+        */
+        void predict(const Matrix& f, const Matrix& q)
+        {
+            _x = f * _x;
+            _p = f * _p * f.transpose() + q;
+        }
+
+        /**
+        * @brief Squared mahalanobis distance of an innovation, used to gate measurements
+        */
+        double distance(const Measurement& innovation, const Observation& h, const MeasurementCovariance& r) const
+        {
+            const MeasurementCovariance s = h * _p * h.transpose() + r;
+            return innovation.dot(s.ldlt().solve(innovation));
+        }
+
+        /**
+        * @brief Corrects the state with a measurement
+        * @param innovation Measurement minus predicted measurement
+        * @param h Observation matrix
+        * @param r Measurement noise covariance
+        */
+        void update(const Measurement& innovation, const Observation& h, const MeasurementCovariance& r)
+        {
+            const MeasurementCovariance s = h * _p * h.transpose() + r;
+            const Eigen::Matrix<double, N, M> k = _p * h.transpose() * s.inverse();
+            _x += k * innovation;
+            // joseph form, keeps the covariance symmetric and positive definite
+            const Matrix a = Matrix::Identity() - k * h;
+            _p = a * _p * a.transpose() + k * r * k.transpose();
+        }
+
+        const Vector& state() const { return _x; }
+        const Matrix& covariance() const { return _p; }
+
+    private:
+        Vector _x;
+        Matrix _p;
+};
+#endif // KALMANFILTER_H
@@ -0,0 +1,80 @@
+#ifndef PREDICTOR_H
+#define PREDICTOR_H
+
+#include "protobuf/world.pb.h"
+#include <QtGlobal>
+#include <deque>
+#include <map>
+#include <utility>
+
+/**
+ * @class Predictor
+ * @brief Compensates the latency between seeing the world and acting on it.
+ * A fused state shows the robots as they were when the camera captured them, and a command
+ * sent now only takes effect when the simulator receives it. The predictor integrates every
+ * robot from its fused pose over that gap, driven by the commands that were sent in the meantime.
+ * The robot model mirrors the velocity controller of the simulator (SimRobot::begin): a
+ * proportional correction of half the error per step, bounded by the speedup and brake limits,
+ * followed by the damping of the rigid body.
+ * All times are Timer::systemTime, in nanoseconds. Values are in internal coordinates.
+ */
+
+class Predictor {
+    public:
+        /// @brief Acceleration limits of the robots, the defaults are those the simulator applies
+        struct Limits {
+            float a_speedup_f = 8;
+            float a_brake_f = 6;
+            float a_speedup_s = 6;
+            float a_brake_s = 6;
+            float a_speedup_phi = 90;
+            float a_brake_phi = 90;
+        };
+
+        Predictor();
+
+        void setLimits(const Limits& limits) { _limits = limits; }
+        /**
+        * @brief Sets the latencies of the loop
+        * @param vision Time from capture to the arrival of a vision packet, 35 ms by default
+        * @param command Time from sending a command until the simulator applies it, 5 ms by default
+        */
+        void setLatency(qint64 vision, qint64 command);
+
+        /**
+        * @brief Remembers a command which was sent to a robot
+        * @param forward Local velocity in m/s, as in sslsim::MoveLocalVelocity
+        * @param left Local velocity in m/s
+        * @param angular Angular velocity in rad/s
+        * @param time Time at which the command was sent
+        */
+        void addCommand(bool is_blue, quint32 id, float forward, float left, float angular, qint64 time);
+        /// @brief Forgets all commands
+        void clear() { _commands.clear(); }
+
+        /**
+        * @brief Predicts the state at which a command sent at time will arrive
+        * @param state Fused state, vision_frame_times must hold the arrival times of its frames
+        * @param time Current time
+        * @param predicted Is overwritten with the robots and the ball at the predicted time
+        */
+        void predict(const world::State& state, qint64 time, world::State* predicted);
+
+    private:
+        struct Command {
+            qint64 time; // time at which the command takes effect
+            float forward;
+            float left;
+            float angular;
+        };
+        typedef std::deque<Command> Commands;
+
+        void predictRobot(const world::Robot& robot, const Commands* commands,
+                          qint64 start, qint64 end, world::Robot* predicted) const;
+
+        Limits _limits;
+        qint64 _vision_latency;
+        qint64 _command_latency;
+        std::map<std::pair<bool, quint32>, Commands> _commands;
+};
+#endif // PREDICTOR_H
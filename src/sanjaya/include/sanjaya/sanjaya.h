@@ -0,0 +1,88 @@
+/*
+ * The simulator is divided into various components.
+ * If you are versed with mythology you may be able to
+ * guess each components purpose.
+ *
+ * Sanjaya: sees the whole battlefield at once.
+ * fuses the views of all cameras into one world state.
+ */
+
+#ifndef SANJAYA_H
+#define SANJAYA_H
+
+#include "tracks.h"
+#include "core/latestvalue.h"
+#include "core/worldsnapshot.h"
+#include "protobuf/world.pb.h"
+#include <QObject>
+#include <QTimer>
+#include <map>
+#include <memory>
+#include <vector>
+
+typedef std::shared_ptr<const world::State> WorldStatePtr;
+typedef LatestValue<world::State> WorldStateSlot;
+
+/**
+ * @class Sanjaya
+ * @brief Multi camera tracker, fuses the detection frames of a WorldSnapshot source into one world::State.
+ * Every ball and robot is followed by its own Kalman filter which is fed with the detections
+ * of all cameras in the order they were captured. The fused state is published at a fixed rate,
+ * so consumers run once per period instead of once per camera frame.
+ * The state is in internal coordinates, see core/coordinates.h, its time is the capture time of
+ * the newest detection in nanoseconds. vision_frame_times holds the arrival times of the frames
+ * which were fused into it, in the clock of the source.
+ */
+
+class Sanjaya: public QObject {
+    Q_OBJECT
+    public:
+        explicit Sanjaya(QObject* parent = nullptr);
+
+        /**
+        * @brief Sets the snapshots to track, e.g. of Vyasa or Smriti. Forgets all tracks.
+        * @param source Must outlive the tracker
+        */
+        void setSource(const WorldSnapshotSlot* source);
+
+        /**
+        * @brief Sets how often the fused state is published
+        * @param rate Publish rate in Hz, 100 by default
+        */
+        void setRate(double rate);
+
+        /// @brief Latest fused state, may be read from any thread
+        const WorldStateSlot& states() const { return _states; }
+
+    signals:
+        /// @brief Emitted at most once per period, only if new detections or a new geometry arrived
+        void updatedState();
+
+    public slots:
+        /// @brief Drops all tracks
+        void reset();
+
+    private slots:
+        void tick();
+
+    private:
+        void addFrame(const SSL_DetectionFrame& frame);
+        void updateBall(const SSL_DetectionFrame& frame, qint64 time);
+        void updateRobots(std::map<quint32, RobotTrack>& tracks,
+                          const google::protobuf::RepeatedPtrField<SSL_DetectionRobot>& robots, qint64 time);
+        void dropLostTracks();
+        WorldStatePtr buildState(const std::vector<qint64>& receive_times) const;
+
+        const WorldSnapshotSlot* _source = nullptr;
+        quint64 _source_version = 0;
+        WorldStateSlot _states;
+        QTimer _timer;
+
+        std::map<quint32, double> _camera_captures; // capture time of the last frame of each camera
+        std::shared_ptr<const SSL_GeometryData> _geometry; // geometry of the last snapshot
+        qint64 _time = 0; // capture time of the newest detection, in nanoseconds
+        std::unique_ptr<BallTrack> _ball;
+        std::map<quint32, RobotTrack> _blue;
+        std::map<quint32, RobotTrack> _yellow;
+};
+#endif // SANJAYA_H
@@ -0,0 +1,61 @@
+#ifndef TRACKS_H
+#define TRACKS_H
+
+#include "kalmanfilter.h"
+#include "protobuf/world.pb.h"
+#include <QtGlobal>
+
+/**
+ * @class BallTrack
+ * @brief Constant velocity model of the ball, measured by its position.
+ * All values are in internal coordinates (meters), times in nanoseconds.
+ */
+
+class BallTrack {
+    public:
+        BallTrack(const Eigen::Vector2d& position, qint64 time);
+
+        /// @brief Advances the filter to time, earlier times are ignored
+        void predict(qint64 time);
+        /// @brief Squared mahalanobis distance of a detection to the predicted position
+        double distance(const Eigen::Vector2d& position) const;
+        void update(const Eigen::Vector2d& position);
+
+        qint64 time() const { return _time; }
+        qint64 lastUpdate() const { return _last_update; }
+
+        /// @brief Writes the state extrapolated to time, without changing the filter
+        void write(world::Ball* ball, qint64 time) const;
+
+    private:
+        KalmanFilter<4, 2> _filter;
+        qint64 _time;
+        qint64 _last_update;
+};
+
+/**
+ * @class RobotTrack
+ * @brief Constant velocity model of a robot, measured by its position and orientation.
+ * All values are in internal coordinates (meters, radians), times in nanoseconds.
+ */
+
+class RobotTrack {
+    public:
+        RobotTrack(const Eigen::Vector3d& pose, qint64 time);
+
+        /// @brief Advances the filter to time, earlier times are ignored
+        void predict(qint64 time);
+        void update(const Eigen::Vector3d& pose);
+
+        qint64 time() const { return _time; }
+        qint64 lastUpdate() const { return _last_update; }
+
+        /// @brief Writes the state extrapolated to time, without changing the filter
+        void write(world::Robot* robot, quint32 id, qint64 time) const;
+
+    private:
+        KalmanFilter<6, 3> _filter;
+        qint64 _time;
+        qint64 _last_update;
+};
+#endif // TRACKS_H
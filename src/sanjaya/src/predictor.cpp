@@ -0,0 +1,147 @@
+#include "predictor.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    // constants of the simulated robot, see SimRobot::begin
+    const float STEP = 1 / 200.f;          // the controller runs once per physics substep
+    const float GAIN = 0.5f / STEP;        // corrects half the error during each substep
+    const float V = 1.2f;                  // keeps the current speed against the damping
+    const float V_PHI = 1.603f;
+    const float LINEAR_DAMPING = 0.7f;
+    const float ANGULAR_DAMPING = 0.8f;
+    const qint64 STANDBY_TIME = 100000000; // commands are dropped after 0.1 s
+
+    const qint64 MAX_AGE = 200000000;      // older states are assumed to come from another clock
+
+    float bound(float acceleration, float speed, float speedup, float brake)
+    {
+        if (std::signbit(acceleration) == std::signbit(speed) || speed == 0) {
+            return std::max(-speedup, std::min(acceleration, speedup));
+        }
+        return std::max(-brake, std::min(acceleration, brake));
+    }
+}
+
+Predictor::Predictor()
+    : _vision_latency(35000000), _command_latency(5000000)
+{
+}
+
+void Predictor::setLatency(qint64 vision, qint64 command)
+{
+    _vision_latency = std::max<qint64>(0, vision);
+    _command_latency = std::max<qint64>(0, command);
+}
+
+void Predictor::addCommand(bool is_blue, quint32 id, float forward, float left, float angular, qint64 time)
+{
+    Commands& commands = _commands[std::make_pair(is_blue, id)];
+    commands.push_back(Command{time + _command_latency, forward, left, angular});
+}
+
+void Predictor::predict(const world::State& state, qint64 time, world::State* predicted)
+{
+    // the state shows the world as it was one vision latency before its newest frame arrived
+    qint64 start = time - _vision_latency;
+    if (state.vision_frame_times_size() > 0) {
+        const qint64 arrival = *std::max_element(state.vision_frame_times().begin(), state.vision_frame_times().end());
+        if (arrival <= time && time - arrival <= MAX_AGE) {
+            start = arrival - _vision_latency;
+        }
+    }
+    const qint64 end = time + _command_latency;
+
+    // only the command which was active at start and those after it are needed
+    for (auto& robot : _commands) {
+        Commands& commands = robot.second;
+        while (commands.size() > 1 && commands[1].time <= start) {
+            commands.pop_front();
+        }
+    }
+
+    predicted->Clear();
+    predicted->set_time(state.time() + (end - start));
+    predicted->set_has_vision_data(state.has_vision_data());
+
+    if (state.has_ball()) {
+        const world::Ball& ball = state.ball();
+        const float dt = (end - start) * 1E-9f;
+        world::Ball* predicted_ball = predicted->mutable_ball();
+        predicted_ball->set_p_x(ball.p_x() + ball.v_x() * dt);
+        predicted_ball->set_p_y(ball.p_y() + ball.v_y() * dt);
+        predicted_ball->set_v_x(ball.v_x());
+        predicted_ball->set_v_y(ball.v_y());
+    }
+
+    for (const world::Robot& robot : state.blue()) {
+        auto it = _commands.find(std::make_pair(true, robot.id()));
+        predictRobot(robot, it == _commands.end() ? nullptr : &it->second, start, end, predicted->add_blue());
+    }
+    for (const world::Robot& robot : state.yellow()) {
+        auto it = _commands.find(std::make_pair(false, robot.id()));
+        predictRobot(robot, it == _commands.end() ? nullptr : &it->second, start, end, predicted->add_yellow());
+    }
+}
+
+void Predictor::predictRobot(const world::Robot& robot, const Commands* commands,
+                             qint64 start, qint64 end, world::Robot* predicted) const
+{
+    float x = robot.p_x();
+    float y = robot.p_y();
+    float phi = robot.phi();
+    float v_x = robot.v_x();
+    float v_y = robot.v_y();
+    float omega = robot.omega();
+
+    const float linear_damping = std::pow(1 - LINEAR_DAMPING, STEP);
+    const float angular_damping = std::pow(1 - ANGULAR_DAMPING, STEP);
+
+    std::size_t next = 0;
+    const Command* active = nullptr;
+    for (qint64 t = start; t < end;) {
+        const qint64 step_end = std::min(end, t + qint64(STEP * 1E9f));
+        const float dt = (step_end - t) * 1E-9f;
+
+        while (commands && next < commands->size() && (*commands)[next].time <= t) {
+            active = &(*commands)[next++];
+        }
+
+        // local frame, forward is along phi
+        const float c = std::cos(phi);
+        const float s = std::sin(phi);
+        float v_f = v_x * c + v_y * s;
+        float v_l = -v_x * s + v_y * c;
+
+        if (active && t - active->time < STANDBY_TIME) {
+            const float a_f = bound(V * v_f + GAIN * (active->forward - v_f), v_f, _limits.a_speedup_f, _limits.a_brake_f);
+            const float a_l = bound(V * v_l + GAIN * (active->left - v_l), v_l, _limits.a_speedup_s, _limits.a_brake_s);
+            const float a_phi = bound(V_PHI * omega + GAIN * (active->angular - omega), omega,
+                                      _limits.a_speedup_phi, _limits.a_brake_phi);
+            v_f += a_f * dt;
+            v_l += a_l * dt;
+            omega += a_phi * dt;
+        }
+
+        const bool full_step = step_end - t == qint64(STEP * 1E9f);
+        const float damping = full_step ? linear_damping : std::pow(1 - LINEAR_DAMPING, dt);
+        v_f *= damping;
+        v_l *= damping;
+        omega *= full_step ? angular_damping : std::pow(1 - ANGULAR_DAMPING, dt);
+
+        v_x = v_f * c - v_l * s;
+        v_y = v_f * s + v_l * c;
+        x += v_x * dt;
+        y += v_y * dt;
+        phi += omega * dt;
+        t = step_end;
+    }
+
+    predicted->set_id(robot.id());
+    predicted->set_p_x(x);
+    predicted->set_p_y(y);
+    predicted->set_phi(std::remainder(phi, 2 * float(M_PI)));
+    predicted->set_v_x(v_x);
+    predicted->set_v_y(v_y);
+    predicted->set_omega(omega);
+}
@@ -0,0 +1,223 @@
+#include "sanjaya.h"
+#include "core/coordinates.h"
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#define LOG qDebug() << "[sanjaya] : "
+
+namespace {
+    const qint64 ROBOT_TIMEOUT = 500000000;   // robots which were not seen for 0.5 s are dropped
+    const qint64 BALL_TIMEOUT = 1000000000;   // the ball may be hidden by a dribbling robot for longer
+    const qint64 BALL_REINIT_TIME = 100000000; // after 0.1 s without a matching detection the ball jumps
+    const qint64 TIME_JUMP = 1000000000;      // the vision clock went back, e.g. seek in a replay
+    const double BALL_GATE = 13.8;            // chi-square, 2 degrees of freedom, 99.9 %
+}
+
+Sanjaya::Sanjaya(QObject* parent) : QObject(parent)
+{
+    _timer.setTimerType(Qt::PreciseTimer);
+    connect(&_timer, &QTimer::timeout, this, &Sanjaya::tick);
+    setRate(100);
+}
+
+void Sanjaya::setSource(const WorldSnapshotSlot* source)
+{
+    _source = source;
+    reset();
+    if (_source) {
+        _timer.start();
+    } else {
+        _timer.stop();
+    }
+}
+
+void Sanjaya::setRate(double rate)
+{
+    _timer.setInterval(std::max(1, qRound(1000 / std::max(rate, 1.0))));
+}
+
+void Sanjaya::reset()
+{
+    _source_version = 0;
+    _camera_captures.clear();
+    _geometry.reset();
+    _time = 0;
+    _ball.reset();
+    _blue.clear();
+    _yellow.clear();
+}
+
+void Sanjaya::tick()
+{
+    if (!_source || _source->version() == _source_version) {
+        return;
+    }
+    _source_version = _source->version();
+    const WorldSnapshotPtr snapshot = _source->load();
+    if (!snapshot) {
+        return;
+    }
+
+    // a snapshot holds the last frame of every camera, only those not seen yet are new.
+    // cameras are faster than the tick at most by a few frames, which are skipped
+    std::vector<const SSL_DetectionFrame*> frames;
+    std::vector<qint64> receive_times;
+    for (const WorldSnapshot::Camera& camera : snapshot->cameras) {
+        const SSL_DetectionFrame& frame = *camera.frame;
+        auto it = _camera_captures.find(frame.camera_id());
+        if (it != _camera_captures.end() && it->second == frame.t_capture()) {
+            continue;
+        }
+        _camera_captures[frame.camera_id()] = frame.t_capture();
+        frames.push_back(&frame);
+        receive_times.push_back(camera.receiveTime);
+    }
+    // consumers draw the field from the geometry of the source, it may arrive before any detection
+    const bool geometry_changed = snapshot->geometry != _geometry;
+    _geometry = snapshot->geometry;
+    if (frames.empty()) {
+        if (geometry_changed) {
+            emit updatedState();
+        }
+        return;
+    }
+
+    // the filters must see the detections in the order they were captured
+    std::sort(frames.begin(), frames.end(), [](const SSL_DetectionFrame* a, const SSL_DetectionFrame* b) {
+        return a->t_capture() < b->t_capture();
+    });
+    if (qint64(frames.front()->t_capture() * 1E9) < _time - TIME_JUMP) {
+        LOG << "vision time jumped back, dropping all tracks";
+        _time = 0;
+        _ball.reset();
+        _blue.clear();
+        _yellow.clear();
+    }
+
+    for (const SSL_DetectionFrame* frame : frames) {
+        addFrame(*frame);
+    }
+    dropLostTracks();
+
+    _states.store(buildState(receive_times));
+    emit updatedState();
+}
+
+void Sanjaya::addFrame(const SSL_DetectionFrame& frame)
+{
+    const qint64 time = qint64(frame.t_capture() * 1E9);
+    _time = std::max(_time, time);
+    updateBall(frame, time);
+    updateRobots(_blue, frame.robots_blue(), time);
+    updateRobots(_yellow, frame.robots_yellow(), time);
+}
+
+void Sanjaya::updateBall(const SSL_DetectionFrame& frame, qint64 time)
+{
+    if (frame.balls_size() == 0) {
+        return;
+    }
+
+    std::vector<Eigen::Vector2d> positions;
+    positions.reserve(frame.balls_size());
+    int best = 0;
+    for (int i = 0; i < frame.balls_size(); ++i) {
+        std::pair<float, float> position;
+        coordinates::fromVision(frame.balls(i), position);
+        positions.emplace_back(position.first, position.second);
+        if (frame.balls(i).confidence() > frame.balls(best).confidence()) {
+            best = i;
+        }
+    }
+
+    if (_ball) {
+        _ball->predict(time);
+        int closest = -1;
+        double closest_distance = BALL_GATE;
+        for (std::size_t i = 0; i < positions.size(); ++i) {
+            const double distance = _ball->distance(positions[i]);
+            if (distance < closest_distance) {
+                closest = int(i);
+                closest_distance = distance;
+            }
+        }
+        if (closest >= 0) {
+            _ball->update(positions[closest]);
+            return;
+        }
+        // a single outlier must not move the ball
+        if (time - _ball->lastUpdate() < BALL_REINIT_TIME) {
+            return;
+        }
+    }
+    // no track yet or lost it, start at the most confident detection
+    _ball.reset(new BallTrack(positions[best], time));
+}
+
+void Sanjaya::updateRobots(std::map<quint32, RobotTrack>& tracks,
+                           const google::protobuf::RepeatedPtrField<SSL_DetectionRobot>& robots, qint64 time)
+{
+    // a camera may report an id twice, only its most confident detection is used
+    std::map<quint32, const SSL_DetectionRobot*> detections;
+    for (const SSL_DetectionRobot& robot : robots) {
+        if (!robot.has_robot_id() || !robot.has_orientation()) {
+            continue;
+        }
+        const SSL_DetectionRobot*& best = detections[robot.robot_id()];
+        if (!best || robot.confidence() > best->confidence()) {
+            best = &robot;
+        }
+    }
+
+    for (const auto& detection : detections) {
+        std::pair<float, float> position;
+        coordinates::fromVision(*detection.second, position);
+        const Eigen::Vector3d pose(position.first, position.second,
+                                   coordinates::fromVisionRotation(detection.second->orientation()));
+
+        auto it = tracks.find(detection.first);
+        if (it == tracks.end()) {
+            tracks.emplace(detection.first, RobotTrack(pose, time));
+        } else {
+            it->second.predict(time);
+            it->second.update(pose);
+        }
+    }
+}
+
+void Sanjaya::dropLostTracks()
+{
+    for (std::map<quint32, RobotTrack>* tracks : {&_blue, &_yellow}) {
+        for (auto it = tracks->begin(); it != tracks->end();) {
+            if (_time - it->second.lastUpdate() > ROBOT_TIMEOUT) {
+                it = tracks->erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    if (_ball && _time - _ball->lastUpdate() > BALL_TIMEOUT) {
+        _ball.reset();
+    }
+}
+
+WorldStatePtr Sanjaya::buildState(const std::vector<qint64>& receive_times) const
+{
+    std::shared_ptr<world::State> state = std::make_shared<world::State>();
+    state->set_time(_time);
+    state->set_has_vision_data(true);
+    for (qint64 time : receive_times) {
+        state->add_vision_frame_times(time);
+    }
+    if (_ball) {
+        _ball->write(state->mutable_ball(), _time);
+    }
+    for (const auto& track : _blue) {
+        track.second.write(state->add_blue(), track.first, _time);
+    }
+    for (const auto& track : _yellow) {
+        track.second.write(state->add_yellow(), track.first, _time);
+    }
+    return state;
+}
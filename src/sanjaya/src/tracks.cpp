@@ -0,0 +1,161 @@
+#include "tracks.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    // standard deviations of the models, tuned for ssl-vision at 60 Hz
+    const double BALL_POSITION_NOISE = 0.005;     // m
+    const double BALL_ACCELERATION_NOISE = 8.0;   // m/s^2, high enough to follow kicks
+    const double ROBOT_POSITION_NOISE = 0.003;    // m
+    const double ROBOT_ANGLE_NOISE = 0.02;        // rad
+    const double ROBOT_ACCELERATION_NOISE = 4.0;  // m/s^2
+    const double ROBOT_ANGULAR_NOISE = 30.0;      // rad/s^2
+
+    const double INITIAL_VELOCITY_NOISE = 2.0;    // m/s or rad/s
+
+    double wrapAngle(double angle)
+    {
+        return std::remainder(angle, 2 * M_PI);
+    }
+
+    /// @brief Adds the transition and white acceleration noise of one position/velocity pair
+    template<typename F, typename Q>
+    void addAxis(F& f, Q& q, int pos, int vel, double dt, double sigma)
+    {
+        const double var = sigma * sigma;
+        f(pos, vel) = dt;
+        q(pos, pos) = var * dt * dt * dt * dt / 4;
+        q(pos, vel) = q(vel, pos) = var * dt * dt * dt / 2;
+        q(vel, vel) = var * dt * dt;
+    }
+
+    Eigen::Matrix<double, 2, 4> ballObservation()
+    {
+        Eigen::Matrix<double, 2, 4> h = Eigen::Matrix<double, 2, 4>::Zero();
+        h(0, 0) = h(1, 1) = 1;
+        return h;
+    }
+
+    Eigen::Matrix2d ballNoise()
+    {
+        return Eigen::Matrix2d::Identity() * BALL_POSITION_NOISE * BALL_POSITION_NOISE;
+    }
+}
+
+// filter state is [x, y, v_x, v_y]
+
+BallTrack::BallTrack(const Eigen::Vector2d& position, qint64 time)
+    : _time(time), _last_update(time)
+{
+    KalmanFilter<4, 2>::Vector x;
+    x << position, 0, 0;
+    KalmanFilter<4, 2>::Matrix p = KalmanFilter<4, 2>::Matrix::Zero();
+    p.diagonal() << Eigen::Vector2d::Constant(BALL_POSITION_NOISE * BALL_POSITION_NOISE),
+                    Eigen::Vector2d::Constant(INITIAL_VELOCITY_NOISE * INITIAL_VELOCITY_NOISE);
+    _filter.reset(x, p);
+}
+
+void BallTrack::predict(qint64 time)
+{
+    if (time <= _time) {
+        return;
+    }
+    const double dt = (time - _time) * 1E-9;
+    KalmanFilter<4, 2>::Matrix f = KalmanFilter<4, 2>::Matrix::Identity();
+    KalmanFilter<4, 2>::Matrix q = KalmanFilter<4, 2>::Matrix::Zero();
+    addAxis(f, q, 0, 2, dt, BALL_ACCELERATION_NOISE);
+    addAxis(f, q, 1, 3, dt, BALL_ACCELERATION_NOISE);
+    _filter.predict(f, q);
+    _time = time;
+}
+
+double BallTrack::distance(const Eigen::Vector2d& position) const
+{
+    const Eigen::Vector2d innovation = position - _filter.state().head<2>();
+    return _filter.distance(innovation, ballObservation(), ballNoise());
+}
+
+void BallTrack::update(const Eigen::Vector2d& position)
+{
+    const Eigen::Vector2d innovation = position - _filter.state().head<2>();
+    _filter.update(innovation, ballObservation(), ballNoise());
+    _last_update = _time;
+}
+
+void BallTrack::write(world::Ball* ball, qint64 time) const
+{
+    const KalmanFilter<4, 2>::Vector& x = _filter.state();
+    const double dt = std::max<qint64>(0, time - _time) * 1E-9;
+    ball->set_p_x(x(0) + x(2) * dt);
+    ball->set_p_y(x(1) + x(3) * dt);
+    ball->set_p_z(0);
+    ball->set_v_x(x(2));
+    ball->set_v_y(x(3));
+    ball->set_v_z(0);
+}
+
+// filter state is [x, y, phi, v_x, v_y, omega], phi is kept within [-pi, pi]
+
+RobotTrack::RobotTrack(const Eigen::Vector3d& pose, qint64 time)
+    : _time(time), _last_update(time)
+{
+    KalmanFilter<6, 3>::Vector x;
+    x << pose.head<2>(), wrapAngle(pose(2)), 0, 0, 0;
+    KalmanFilter<6, 3>::Matrix p = KalmanFilter<6, 3>::Matrix::Zero();
+    p.diagonal() << ROBOT_POSITION_NOISE * ROBOT_POSITION_NOISE,
+                    ROBOT_POSITION_NOISE * ROBOT_POSITION_NOISE,
+                    ROBOT_ANGLE_NOISE * ROBOT_ANGLE_NOISE,
+                    Eigen::Vector3d::Constant(INITIAL_VELOCITY_NOISE * INITIAL_VELOCITY_NOISE);
+    _filter.reset(x, p);
+}
+
+void RobotTrack::predict(qint64 time)
+{
+    if (time <= _time) {
+        return;
+    }
+    const double dt = (time - _time) * 1E-9;
+    KalmanFilter<6, 3>::Matrix f = KalmanFilter<6, 3>::Matrix::Identity();
+    KalmanFilter<6, 3>::Matrix q = KalmanFilter<6, 3>::Matrix::Zero();
+    addAxis(f, q, 0, 3, dt, ROBOT_ACCELERATION_NOISE);
+    addAxis(f, q, 1, 4, dt, ROBOT_ACCELERATION_NOISE);
+    addAxis(f, q, 2, 5, dt, ROBOT_ANGULAR_NOISE);
+    _filter.predict(f, q);
+
+    KalmanFilter<6, 3>::Vector x = _filter.state();
+    x(2) = wrapAngle(x(2));
+    _filter.reset(x, _filter.covariance());
+    _time = time;
+}
+
+void RobotTrack::update(const Eigen::Vector3d& pose)
+{
+    Eigen::Matrix<double, 3, 6> h = Eigen::Matrix<double, 3, 6>::Zero();
+    h(0, 0) = h(1, 1) = h(2, 2) = 1;
+    Eigen::Matrix3d r = Eigen::Matrix3d::Zero();
+    r.diagonal() << ROBOT_POSITION_NOISE * ROBOT_POSITION_NOISE,
+                    ROBOT_POSITION_NOISE * ROBOT_POSITION_NOISE,
+                    ROBOT_ANGLE_NOISE * ROBOT_ANGLE_NOISE;
+
+    Eigen::Vector3d innovation = pose - _filter.state().head<3>();
+    innovation(2) = wrapAngle(innovation(2));
+    _filter.update(innovation, h, r);
+
+    KalmanFilter<6, 3>::Vector x = _filter.state();
+    x(2) = wrapAngle(x(2));
+    _filter.reset(x, _filter.covariance());
+    _last_update = _time;
+}
+
+void RobotTrack::write(world::Robot* robot, quint32 id, qint64 time) const
+{
+    const KalmanFilter<6, 3>::Vector& x = _filter.state();
+    const double dt = std::max<qint64>(0, time - _time) * 1E-9;
+    robot->set_id(id);
+    robot->set_p_x(x(0) + x(3) * dt);
+    robot->set_p_y(x(1) + x(4) * dt);
+    robot->set_phi(wrapAngle(x(2) + x(5) * dt));
+    robot->set_v_x(x(3));
+    robot->set_v_y(x(4));
+    robot->set_omega(x(5));
+}
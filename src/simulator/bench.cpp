@@ -0,0 +1,369 @@
+/***************************************************************************
+ *   Copyright 2026 Kuruk contributors                                     *
+ *                                                                         *
+ *   This program is free software: you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation, either version 3 of the License, or     *
+ *   any later version.                                                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#include <algorithm>
+#include <clocale>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QList>
+
+#include "protobuf/command.pb.h"
+#include "protobuf/robot.h"
+#include "protobuf/world.pb.h"
+#include "simulator/simulatorcore.h"
+#include "simulator/vectorenv.h"
+#include "simulator/worldtemplate.h"
+
+#include "core/configuration.h"
+#include "core/counterrng.h"
+#include "core/timer.h"
+
+/**
+ * Offline benchmark of the simulator physics
+ *
+ * Runs a crowded, reproducible scenario as fast as possible on the simulator core
+ * and reports the cost per physics step for every selected configuration.
+ */
+
+using camun::simulator::SimulatorCore;
+using camun::simulator::SimulatorOutput;
+using camun::simulator::CollisionStats;
+using camun::simulator::VectorEnv;
+using camun::simulator::WorldTemplate;
+
+// the simulator takes positions and velocities in millimeters
+static const float MM = 1000.0f;
+
+struct BenchConfig {
+    const char *name;
+    amun::SimulatorSetup setup;
+};
+
+struct BenchResult {
+    qint64 wallTime;
+    CollisionStats collision;
+    // true state at every vision frame
+    QList<world::SimulatorState> trajectory;
+};
+
+struct TrajectoryDiff {
+    double robotMean = 0;
+    double robotMax = 0;
+    double ballMean = 0;
+    double ballMax = 0;
+};
+
+static void addTeam(amun::Command *command, bool isBlue, int robots)
+{
+    robot::Specs specs;
+    robotSetDefault(&specs);
+    robot::Team *team = isBlue ? command->mutable_set_team_blue() : command->mutable_set_team_yellow();
+    for (int i = 0; i < robots; ++i) {
+        robot::Specs *robot = team->add_robot();
+        robot->CopyFrom(specs);
+        robot->set_id(i);
+    }
+}
+
+// places the robots on a grid in their half, close enough to bump into each other
+static void placeRobots(sslsim::SimulatorControl *control, const world::Geometry &geometry, bool isBlue, int robots)
+{
+    // x is along the field length in the ssl coordinate system
+    const int columns = 4;
+    const float side = isBlue ? 1.0f : -1.0f;
+    const float spacingX = geometry.field_height() / 2 / (columns + 1);
+    const float spacingY = geometry.field_width() / ((robots + columns - 1) / columns + 1);
+    for (int i = 0; i < robots; ++i) {
+        sslsim::TeleportRobot *robot = control->add_teleport_robot();
+        robot->mutable_id()->set_id(i);
+        robot->mutable_id()->set_team(isBlue ? gameController::BLUE : gameController::YELLOW);
+        robot->set_x(side * spacingX * (i % columns + 1) * MM);
+        robot->set_y((-geometry.field_width() / 2 + spacingY * (i / columns + 1)) * MM);
+        robot->set_orientation(isBlue ? M_PI : 0);
+        robot->set_present(true);
+    }
+}
+
+// random local velocities, all robots keep pushing around
+static sslsim::RobotControl driveCommands(CounterRNG &rng, int robots)
+{
+    sslsim::RobotControl control;
+    for (int i = 0; i < robots; ++i) {
+        sslsim::RobotCommand *command = control.add_robot_commands();
+        command->set_id(i);
+        sslsim::MoveLocalVelocity *velocity = command->mutable_move_command()->mutable_local_velocity();
+        velocity->set_forward(rng.uniformFloat(-2.0f, 2.0f));
+        velocity->set_left(rng.uniformFloat(-1.5f, 1.5f));
+        velocity->set_angular(rng.uniformFloat(-4.0f, 4.0f));
+        command->set_dribbler_speed(rng.uniform() < 0.3 ? 1000 : 0);
+    }
+    return control;
+}
+
+static BenchResult run(const BenchConfig &config, int robots, qint64 duration, uint32_t seed)
+{
+    // no timers or signals involved, the loop below is all the simulator does
+    SimulatorCore sim(config.setup);
+    sim.seedPRGN(seed);
+
+    amun::Command command;
+    addTeam(&command, true, robots);
+    addTeam(&command, false, robots);
+    sslsim::SimulatorControl *control = command.mutable_simulator()->mutable_ssl_control();
+    placeRobots(control, config.setup.geometry(), true, robots);
+    placeRobots(control, config.setup.geometry(), false, robots);
+    sslsim::TeleportBall *ball = control->mutable_teleport_ball();
+    ball->set_x(0);
+    ball->set_y(0);
+    ball->set_vx(3 * MM);
+    ball->set_vy(1 * MM);
+    sim.handleCommand(command);
+
+    // the same commands for every configuration
+    CounterRNG blueRng(seed, 0, 1, 0);
+    CounterRNG yellowRng(seed, 0, 2, 0);
+    sslsim::RobotControl blueCommands, yellowCommands;
+    const qint64 stepTime = 1E9 / 200;
+
+    BenchResult result;
+    SimulatorOutput output;
+    sim.resetCollisionStats();
+    const qint64 start = Timer::systemTime();
+    for (int ticks = 0; sim.time() < duration; ticks++) {
+        // new targets every half second, resent every tick as robots stop without commands
+        if (ticks % 100 == 0) {
+            blueCommands = driveCommands(blueRng, robots);
+            yellowCommands = driveCommands(yellowRng, robots);
+        }
+        sim.queueRadioCommands(blueCommands, true, sim.time());
+        sim.queueRadioCommands(yellowCommands, false, sim.time());
+        sim.applyCommands();
+        sim.step(std::min(stepTime, duration - sim.time()));
+
+        sim.collectOutputs(output);
+        for (const camun::simulator::VisionOutput &vision : output.vision) {
+            world::SimulatorState state;
+            if (state.ParseFromString(vision.trueState)) {
+                result.trajectory.append(state);
+            }
+        }
+    }
+    result.wallTime = Timer::systemTime() - start;
+    result.collision = sim.collisionStats();
+    return result;
+}
+
+static double distance(float x1, float y1, float x2, float y2)
+{
+    return std::hypot(x1 - x2, y1 - y2);
+}
+
+static void compareRobots(const google::protobuf::RepeatedPtrField<world::SimRobot> &reference,
+                          const google::protobuf::RepeatedPtrField<world::SimRobot> &robots, TrajectoryDiff &diff, int &count)
+{
+    for (const world::SimRobot &robot : robots) {
+        for (const world::SimRobot &ref : reference) {
+            if (ref.id() == robot.id()) {
+                const double d = distance(ref.p_x(), ref.p_y(), robot.p_x(), robot.p_y());
+                diff.robotMean += d;
+                diff.robotMax = std::max(diff.robotMax, d);
+                count++;
+            }
+        }
+    }
+}
+
+// position differences of the frames up to the given time after the start
+static TrajectoryDiff compare(const QList<world::SimulatorState> &reference, const QList<world::SimulatorState> &trajectory, qint64 horizon)
+{
+    TrajectoryDiff diff;
+    int robotCount = 0;
+    int ballCount = 0;
+    int j = 0;
+    for (const world::SimulatorState &ref : reference) {
+        if (ref.time() - reference.first().time() > horizon) {
+            break;
+        }
+        while (j < trajectory.size() && trajectory[j].time() < ref.time()) {
+            j++;
+        }
+        if (j == trajectory.size() || trajectory[j].time() != ref.time()) {
+            continue;
+        }
+        const world::SimulatorState &state = trajectory[j];
+        compareRobots(ref.blue_robots(), state.blue_robots(), diff, robotCount);
+        compareRobots(ref.yellow_robots(), state.yellow_robots(), diff, robotCount);
+        if (ref.has_ball() && state.has_ball()) {
+            const double d = distance(ref.ball().p_x(), ref.ball().p_y(), state.ball().p_x(), state.ball().p_y());
+            diff.ballMean += d;
+            diff.ballMax = std::max(diff.ballMax, d);
+            ballCount++;
+        }
+    }
+    diff.robotMean /= std::max(robotCount, 1);
+    diff.ballMean /= std::max(ballCount, 1);
+    return diff;
+}
+
+static void report(const char *name, const BenchResult &result)
+{
+    const CollisionStats &c = result.collision;
+    const double steps = qMax<qint64>(c.steps, 1);
+    std::printf("%-14s %10lld %12.2f %12.2f %12.2f %10.1f %10.1f\n", name, (long long)c.steps,
+                result.wallTime / steps / 1000.0, c.broadphaseTime / steps / 1000.0, c.narrowphaseTime / steps / 1000.0,
+                c.pairs / steps, c.manifolds / steps);
+}
+
+// compares building a simulation with teams from the setup to instantiating a template
+static void measureInstantiation(const amun::SimulatorSetup &setup, int robots)
+{
+    const int repetitions = 20;
+    amun::Command command;
+    addTeam(&command, true, robots);
+    addTeam(&command, false, robots);
+
+    qint64 start = Timer::systemTime();
+    for (int i = 0; i < repetitions; ++i) {
+        SimulatorCore sim(setup);
+        sim.handleCommand(command);
+    }
+    const qint64 fromSetup = Timer::systemTime() - start;
+
+    start = Timer::systemTime();
+    const WorldTemplate world(setup, command.set_team_blue(), command.set_team_yellow());
+    const qint64 buildTemplate = Timer::systemTime() - start;
+    start = Timer::systemTime();
+    for (int i = 0; i < repetitions; ++i) {
+        SimulatorCore sim(world);
+    }
+    const qint64 fromTemplate = Timer::systemTime() - start;
+
+    std::printf("\ninstantiation in microseconds: from setup %.1f, template build %.1f, from template %.1f\n",
+                fromSetup / 1000.0 / repetitions, buildTemplate / 1000.0, fromTemplate / 1000.0 / repetitions);
+}
+
+// steps a batch of environments with random actions, like a learning loop would
+static void runEnvs(const amun::SimulatorSetup &setup, int envs, int robots, qint64 duration, uint32_t seed)
+{
+    VectorEnv::Config config;
+    config.setup = setup;
+    config.robotsPerTeam = robots;
+    config.seed = seed;
+    VectorEnv env(envs, config);
+
+    std::vector<float> actions(envs * env.actionSize());
+    std::vector<float> observations(envs * env.observationSize());
+    std::vector<uint8_t> dones(envs);
+    CounterRNG rng(seed, 0, 3, 0);
+    env.reset(observations.data());
+
+    const int steps = duration / config.stepTime;
+    qint64 episodes = 0;
+    const qint64 start = Timer::systemTime();
+    for (int i = 0; i < steps; ++i) {
+        // new targets every half second
+        if (i % 50 == 0) {
+            for (std::size_t a = 0; a < actions.size(); a += VectorEnv::ACTION_SIZE) {
+                actions[a] = rng.uniformFloat(-2.0f, 2.0f);
+                actions[a + 1] = rng.uniformFloat(-1.5f, 1.5f);
+                actions[a + 2] = rng.uniformFloat(-4.0f, 4.0f);
+                actions[a + 3] = rng.uniform() < 0.1 ? 4.0f : 0.0f;
+                actions[a + 4] = rng.uniform() < 0.3 ? 1000.0f : 0.0f;
+            }
+        }
+        env.step(actions.data(), observations.data(), dones.data());
+        episodes += std::count_if(dones.begin(), dones.end(), [](uint8_t done) { return done != VectorEnv::RUNNING; });
+    }
+    const double seconds = std::max<qint64>(Timer::systemTime() - start, 1) / 1E9;
+
+    std::printf("\n%d environments, %d vs %d robots, %.1f s simulated each\n", envs, robots, robots, steps * config.stepTime / 1E9);
+    std::printf("%.0f env-steps/s, %.1f us per step call, %lld episodes ended\n",
+                qint64(steps) * envs / seconds, seconds / std::max(steps, 1) * 1E6, (long long)episodes);
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("Simulator benchmark");
+    app.setOrganizationName("ER-Force");
+
+    std::setlocale(LC_NUMERIC, "C");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Measures the physics step cost of the simulator");
+    parser.addHelpOption();
+
+    QCommandLineOption geometryConfig({"g", "geometry"}, "The geometry file to load", "file", "2020");
+    QCommandLineOption robotsConfig("robots", "Robots per team", "count", "11");
+    QCommandLineOption durationConfig("duration", "Simulated time per configuration (in seconds)", "seconds", "20");
+    QCommandLineOption seedConfig("seed", "Seed of the scenario and the simulator noise", "seed", "1");
+    QCommandLineOption envsConfig("envs", "Additionally measure the throughput of this many batched environments", "count", "0");
+    parser.addOption(geometryConfig);
+    parser.addOption(robotsConfig);
+    parser.addOption(durationConfig);
+    parser.addOption(seedConfig);
+    parser.addOption(envsConfig);
+
+    parser.process(app);
+
+    amun::SimulatorSetup setup;
+    if (!loadConfiguration("simulator/" + parser.value(geometryConfig), &setup, false)) {
+        return EXIT_FAILURE;
+    }
+    const int robots = parser.value(robotsConfig).toInt();
+    const qint64 duration = parser.value(durationConfig).toDouble() * 1E9;
+    const uint32_t seed = parser.value(seedConfig).toUInt();
+    const int envs = parser.value(envsConfig).toInt();
+
+    QList<BenchConfig> configs;
+    configs.append(BenchConfig{"dbvt", setup});
+    configs.append(BenchConfig{"axis-sweep", setup});
+    configs.last().setup.set_broadphase(amun::SimulatorSetup::AXIS_SWEEP);
+    configs.append(BenchConfig{"dbvt-nofilter", setup});
+    configs.last().setup.set_collision_filters(false);
+    configs.append(BenchConfig{"robot-lod", setup});
+    configs.last().setup.set_simplified_robot_collision(true);
+
+    std::printf("%d vs %d robots, %.1f s simulated, times per physics step in microseconds\n",
+                robots, robots, duration / 1E9);
+    std::printf("%-14s %10s %12s %12s %12s %10s %10s\n", "config", "steps", "total", "broadphase", "narrowphase", "pairs", "manifolds");
+    QList<BenchResult> results;
+    for (const BenchConfig &config : configs) {
+        results.append(run(config, robots, duration, seed));
+        report(config.name, results.last());
+    }
+
+    // the contacts are chaotic, thus the short horizons matter most
+    std::printf("\nposition difference to %s in meters (mean / max)\n", configs.first().name);
+    std::printf("%-14s %8s %21s %21s\n", "config", "horizon", "robots", "ball");
+    for (int i = 1; i < configs.size(); ++i) {
+        for (const qint64 horizon : {qint64(1E9), qint64(5E9), duration}) {
+            const TrajectoryDiff diff = compare(results.first().trajectory, results[i].trajectory, horizon);
+            std::printf("%-14s %7.1fs %10.4f / %8.4f %10.4f / %8.4f\n", configs[i].name, horizon / 1E9,
+                        diff.robotMean, diff.robotMax, diff.ballMean, diff.ballMax);
+        }
+    }
+
+    measureInstantiation(setup, robots);
+    if (envs > 0) {
+        runEnvs(setup, envs, robots, duration, seed);
+    }
+    return EXIT_SUCCESS;
+}
@@ -27,6 +27,7 @@
 #include <cmath>
 #include <cstdio>
 #include <cstdarg>
+#include <memory>
 
 #include "protobuf/ssl_simulation_robot_control.pb.h"
 #include "protobuf/ssl_simulation_robot_feedback.pb.h"
@@ -43,6 +44,7 @@
 #include "core/configuration.h"
 #include "core/coordinates.h"
 #include "core/sslprotocols.h"
+#include "core/simulationrecorder.h"
 
 #include "ssl_robocup_server.h"
 
@@ -396,7 +398,7 @@ void SimulatorCommandAdaptor::handleDatagrams() {
             continue;
         }
         if (simcom.has_control()) {
-            Command c{new amun::Command};
+            Command c = Command::createArena();
             auto* sslControl = c->mutable_simulator()->mutable_ssl_control();
             sslControl->CopyFrom(simcom.control());
             if (sslControl->has_teleport_ball()) {
@@ -421,7 +423,7 @@ void SimulatorCommandAdaptor::handleDatagrams() {
             const auto& config{simcom.config()};
 
             if (config.has_geometry()) {
-                Command c{new amun::Command};
+                Command c = Command::createArena();
                 auto* setup = c->mutable_simulator()->mutable_simulator_setup();
                 convertFromSSlGeometry(config.geometry().field(), *(setup->mutable_geometry()));
                 setup->mutable_camera_setup()->CopyFrom(config.geometry().calib());
@@ -429,7 +431,7 @@ void SimulatorCommandAdaptor::handleDatagrams() {
             }
 
             if (config.robot_specs_size() > 0) {
-                Command c{new amun::Command};
+                Command c = Command::createArena();
                 robot::Team* blueTeam = nullptr;
                 robot::Team* yellowTeam = nullptr;
                 auto newSz = config.robot_specs_size();
@@ -460,7 +462,7 @@ void SimulatorCommandAdaptor::handleDatagrams() {
                 for(const auto& c : config.realism_config().custom()) {
                 RealismConfigErForce rcef;
                     if (c.UnpackTo(&rcef)) {
-                        Command c{new amun::Command};
+                        Command c = Command::createArena();
                         c->mutable_simulator()->mutable_realism_config()->CopyFrom(rcef);
                         emit sendCommand(c);
                     }
@@ -526,7 +528,7 @@ void RobotCommandAdaptor::handleDatagrams()
                 }
             });
 
-        SSLSimRobotControl control{new sslsim::RobotControl};
+        SSLSimRobotControl control = SSLSimRobotControl::createArena();
         if (!control->ParseFromArray(data.data(), data.size())) {
             sendRcr = true;
             setError(rcr.add_errors(), SimError::UNREADABLE, ERROR_SOURCE);
@@ -604,6 +606,7 @@ signals:
     void sendSSLSimError(const QList<SSLSimError>& errors, ErrorSource source); // out
     void sendRadioResponses(const QList<robot::RadioResponse> &responses); // out
     void gotPacket(const QByteArray &data, qint64 time, QString sender); // out
+    void sendRealData(const QByteArray &data); // out
     void gotCommand(const Command &command); // internal
     void handleRadioCommands(const SSLSimRobotControl& control, bool isBlue, qint64 processingStart); // in
 public slots:
@@ -617,35 +620,33 @@ private:
 
 void SimProxy::handleCommand(const Command &command) {
     bool hasSimSetup = command->has_simulator() && command->simulator().has_simulator_setup();
+    // only the first setup constructs the simulator, later ones are applied in place
+    // by Simulator::handleCommand, which keeps robots, ball and queued vision packets
+    bool createSim = hasSimSetup && m_sim == nullptr;
 
     if (command->has_set_team_blue()) {
         m_teamCommand->mutable_set_team_blue()->CopyFrom(command->set_team_blue());
-        if (hasSimSetup) {
+        if (createSim) {
             command->clear_set_team_blue();
         }
     }
     if (command->has_set_team_yellow()) {
         m_teamCommand->mutable_set_team_yellow()->CopyFrom(command->set_team_yellow());
-        if (hasSimSetup) {
+        if (createSim) {
             command->clear_set_team_yellow();
         }
     }
     if (command->has_simulator() && command->simulator().has_realism_config()) {
         m_teamCommand->mutable_simulator()->mutable_realism_config()->CopyFrom(command->simulator().realism_config());
-        if (hasSimSetup) {
+        if (createSim) {
             command->mutable_simulator()->clear_realism_config();
         }
     }
-    if (hasSimSetup) {
-        // replace m_sim
-        if (m_sim != nullptr) {
-            // replace old connectios
-            m_sim->blockSignals(true);
-            m_sim->deleteLater();
-        }
+    if (createSim) {
         m_sim = new Simulator(m_timer, command->simulator().simulator_setup());
         connect(this, &SimProxy::gotCommand, m_sim, &Simulator::handleCommand);
         connect(m_sim, &Simulator::gotPacket, this, &SimProxy::gotPacket);
+        connect(m_sim, &Simulator::sendRealData, this, &SimProxy::sendRealData);
         connect(this, &SimProxy::handleRadioCommands, m_sim, &Simulator::handleRadioCommands);
         connect(m_sim, &Simulator::sendSSLSimError, this, &SimProxy::sendSSLSimError);
         connect(m_sim, &Simulator::sendRadioResponses, this, &SimProxy::sendRadioResponses);
@@ -685,9 +686,13 @@ int main(int argc, char* argv[])
     QCommandLineOption geometryConfig({"g", "geometry"}, "The geometry file to load as default", "file", "2020");
     QCommandLineOption realismConfig("realism", "Simulator realism configuration (short file name without the .txt)", "realism", "Realistic");
     QCommandLineOption localhostConfig("localhost", "Use localhost as the output address for the simulator");
+    QCommandLineOption recordConfig("record", "Record vision, ground truth and radio commands to a file", "file");
+    QCommandLineOption analyticBallConfig("analytic-ball", "Advance a freely rolling ball in closed form instead of stepping it with the physics engine");
     parser.addOption(geometryConfig);
     parser.addOption(realismConfig);
     parser.addOption(localhostConfig);
+    parser.addOption(recordConfig);
+    parser.addOption(analyticBallConfig);
 
     parser.process(app);
 
@@ -728,6 +733,17 @@ int main(int argc, char* argv[])
     blue.connect(&sim, &SimProxy::sendSSLSimError, &blue, &RobotCommandAdaptor::handleSimulatorError);
     yellow.connect(&sim, &SimProxy::sendSSLSimError, &yellow, &RobotCommandAdaptor::handleSimulatorError);
 
+    std::unique_ptr<SimulationRecorder> recorder;
+    if (parser.isSet(recordConfig)) {
+        // lives in the main thread, the radio commands arrive queued from the receiver thread
+        recorder.reset(new SimulationRecorder(parser.value(recordConfig), &timer));
+        recorder->connect(&sim, &SimProxy::gotPacket, recorder.get(), &SimulationRecorder::recordVisionPacket);
+        recorder->connect(&sim, &SimProxy::sendRealData, recorder.get(), &SimulationRecorder::recordSimulatorState);
+        recorder->connect(&blue, &RobotCommandAdaptor::sendRadioCommands, recorder.get(), &SimulationRecorder::recordRadioCommands);
+        recorder->connect(&yellow, &RobotCommandAdaptor::sendRadioCommands, recorder.get(), &SimulationRecorder::recordRadioCommands);
+        recorder->connect(&app, &QCoreApplication::aboutToQuit, recorder.get(), &SimulationRecorder::close);
+    }
+
     Command c{new amun::Command};
 
     // start with default robots, take ER-Force specs.
@@ -751,6 +767,9 @@ int main(int argc, char* argv[])
     if (!loadConfiguration("simulator/" + parser.value(geometryConfig), c->mutable_simulator()->mutable_simulator_setup(), false)) {
         exit(EXIT_FAILURE);
     }
+    if (parser.isSet(analyticBallConfig)) {
+        c->mutable_simulator()->mutable_simulator_setup()->set_analytic_ball_rolling(true);
+    }
     if (!loadConfiguration("simulator-realism/" + parser.value(realismConfig), c->mutable_simulator()->mutable_realism_config(), true)) {
         exit(EXIT_FAILURE);
     }
@@ -0,0 +1,93 @@
+/***************************************************************************
+ *   Copyright 2026 Kuruk contributors                                     *
+ *                                                                         *
+ *   This program is free software: you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation, either version 3 of the License, or     *
+ *   any later version.                                                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#include <cmath>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "protobuf/command.h"
+#include "simulator/vectorenv.h"
+
+using camun::simulator::VectorEnv;
+
+static const int ENVS = 2;
+static const int ROBOTS_PER_TEAM = 3;
+// ball and robot states have 6 values, the third robot value is the orientation
+static const int STATE_SIZE = 6;
+static const int ORIENTATION = 2;
+
+static VectorEnv::Config testConfig()
+{
+    VectorEnv::Config config;
+    simulatorSetupSetDefault(config.setup);
+    config.robotsPerTeam = ROBOTS_PER_TEAM;
+    return config;
+}
+
+static void expectSameObservations(const VectorEnv &env, const std::vector<float> &expected, const std::vector<float> &actual)
+{
+    for (int e = 0; e < env.envs(); e++) {
+        const int base = e * env.observationSize();
+        for (int i = 0; i < env.observationSize(); i++) {
+            const bool isOrientation = i >= STATE_SIZE && (i - STATE_SIZE) % STATE_SIZE == ORIENTATION;
+            float difference = actual[base + i] - expected[base + i];
+            if (isOrientation) {
+                difference = std::remainder(difference, float(2 * M_PI));
+            }
+            EXPECT_NEAR(difference, 0, 1E-4) << "environment " << e << ", value " << i;
+        }
+    }
+}
+
+TEST(VectorEnv, SetStateFromObservationKeepsState)
+{
+    VectorEnv env(ENVS, testConfig());
+    std::vector<float> observations(env.envs() * env.observationSize());
+    env.reset(observations.data());
+
+    for (int e = 0; e < env.envs(); e++) {
+        env.setState(e, observations.data() + e * env.observationSize());
+    }
+    std::vector<float> restored(observations.size());
+    env.observe(restored.data());
+    expectSameObservations(env, observations, restored);
+}
+
+TEST(VectorEnv, OrientationIsForwardDirection)
+{
+    VectorEnv env(1, testConfig());
+    std::vector<float> observation(env.observationSize());
+    env.reset(observation.data());
+
+    // first blue robot, facing along +x
+    float *robot = observation.data() + STATE_SIZE;
+    robot[ORIENTATION] = 0;
+    env.setState(0, observation.data());
+    std::vector<float> restored(observation.size());
+    env.observe(restored.data());
+    EXPECT_NEAR(restored[STATE_SIZE + ORIENTATION], 0, 1E-4);
+
+    // a robot driving forward moves along its orientation
+    std::vector<float> actions(env.actionSize(), 0);
+    actions[0] = 1;
+    std::vector<uint8_t> dones(env.envs());
+    for (int i = 0; i < 20; i++) {
+        env.step(actions.data(), restored.data(), dones.data());
+    }
+    ASSERT_EQ(dones[0], VectorEnv::RUNNING);
+    EXPECT_GT(restored[STATE_SIZE] - robot[0], std::abs(restored[STATE_SIZE + 1] - robot[1]));
+}
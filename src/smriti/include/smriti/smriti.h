@@ -0,0 +1,100 @@
+/*
+ * The simulator is divided into various components.
+ * If you are versed with mythology you may be able to
+ * guess each components purpose.
+ *
+ * Smriti: that which is remembered.
+ * replays a recorded match, in place of vyasa.
+ */
+
+#ifndef SMRITI_H
+#define SMRITI_H
+
+#include "core/simulationrecordingreader.h"
+#include "core/worldsnapshot.h"
+#include <QElapsedTimer>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+
+/**
+ * @class Smriti
+ * @brief Replays the vision packets of a recording written by SimulationRecorder.
+ * The packets are published as WorldSnapshots through snapshots() and recievedState,
+ * exactly like Vyasa does for live data, so kshetra and drona can be connected to
+ * either of them. The original spacing between packets is kept, scaled by the replay speed.
+ */
+
+class Smriti: public QObject {
+    Q_OBJECT
+    public:
+        explicit Smriti(QObject* parent = nullptr);
+
+        /**
+        * @brief Opens a recording, replay starts paused at its beginning
+        * @param filename Path of the recording
+        * @return false if the file is no readable recording
+        */
+        bool open(const QString& filename);
+
+        /**
+        * @brief Sets the replay speed
+        * @param speed 1 is real time, 2 twice as fast. 0 replays as fast as possible.
+        */
+        void setSpeed(double speed);
+        double speed() const { return _speed; }
+
+        bool isPlaying() const { return _playing; }
+        /// @brief Recording time of the next packet, in nanoseconds
+        qint64 position() const { return _next.time(); }
+        qint64 startTime() const { return _reader.startTime(); }
+        qint64 endTime() const { return _reader.endTime(); }
+
+        /// @brief Latest snapshot, same as Vyasa::snapshots
+        const WorldSnapshotSlot& snapshots() const { return _snapshots; }
+
+    signals:
+        /// @brief Emitted for every replayed vision packet, same as Vyasa::recievedState
+        void recievedState();
+        /// @brief Emitted when the end of the recording is reached
+        void finished();
+
+    public slots:
+        void play();
+        void pause();
+        void togglePause();
+        /**
+        * @brief Continues the replay at the first packet at or after time
+        * @param time Recording time in nanoseconds
+        */
+        void seek(qint64 time);
+        /// @brief Jumps relative to the current position, in nanoseconds
+        void skip(qint64 offset);
+        /// @brief Emits exactly one packet, only while paused
+        void stepFrame();
+
+    private slots:
+        void emitDuePackets();
+
+    private:
+        bool fetchNext();
+        void emitNext();
+        void restartClock();
+        void scheduleNext();
+
+        SimulationRecordingReader _reader;
+        recording::Record _next; // next vision packet to emit
+        bool _hasNext = false;
+        bool _playing = false;
+        double _speed = 1.0;
+
+        // wall clock time and recording time at which the replay was (re)started
+        QElapsedTimer _clock;
+        qint64 _clockStart = 0;
+        qint64 _recordStart = 0;
+
+        QTimer _timer;
+        WorldSnapshotBuilder _builder;
+        WorldSnapshotSlot _snapshots;
+};
+#endif // SMRITI_H
@@ -0,0 +1,151 @@
+#include "smriti.h"
+#include <QDebug>
+#include <algorithm>
+#define LOG qDebug() << "[smriti] : "
+
+Smriti::Smriti(QObject* parent) : QObject(parent)
+{
+    _timer.setSingleShot(true);
+    _timer.setTimerType(Qt::PreciseTimer);
+    connect(&_timer, &QTimer::timeout, this, &Smriti::emitDuePackets);
+    _clock.start();
+}
+
+bool Smriti::open(const QString& filename)
+{
+    pause();
+    if (!_reader.open(filename)) {
+        LOG << "could not open recording" << filename;
+        _hasNext = false;
+        return false;
+    }
+    if (!_reader.hasStoredIndex()) {
+        LOG << "recording was not closed properly, rebuilt its index";
+    }
+    _hasNext = fetchNext();
+    return _hasNext;
+}
+
+bool Smriti::fetchNext()
+{
+    // only the vision packets are replayed
+    while (_reader.readNext(_next)) {
+        if (_next.type() == recording::VISION) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Smriti::setSpeed(double speed)
+{
+    _speed = std::max(0.0, speed);
+    if (_playing) {
+        restartClock();
+        scheduleNext();
+    }
+}
+
+void Smriti::play()
+{
+    if (_playing || !_hasNext) {
+        return;
+    }
+    _playing = true;
+    restartClock();
+    scheduleNext();
+}
+
+void Smriti::pause()
+{
+    _playing = false;
+    _timer.stop();
+}
+
+void Smriti::togglePause()
+{
+    if (_playing) {
+        pause();
+    } else {
+        play();
+    }
+}
+
+void Smriti::seek(qint64 time)
+{
+    // frames from before the jump must not be mixed with the new position
+    _builder.clear();
+    _hasNext = _reader.seek(time) && fetchNext();
+    if (_playing) {
+        restartClock();
+        scheduleNext();
+    }
+}
+
+void Smriti::skip(qint64 offset)
+{
+    if (_hasNext) {
+        seek(std::max(startTime(), position() + offset));
+    }
+}
+
+void Smriti::stepFrame()
+{
+    if (!_playing && _hasNext) {
+        emitNext();
+    }
+}
+
+void Smriti::restartClock()
+{
+    _clockStart = _clock.nsecsElapsed();
+    _recordStart = _hasNext ? _next.time() : 0;
+}
+
+void Smriti::emitNext()
+{
+    // snapshot times are recording times, so cameras time out relative to the replay
+    WorldSnapshotPtr snapshot = _builder.addPacket(_next.data().data(), int(_next.data().size()), _next.time());
+    if (snapshot) {
+        _snapshots.store(std::move(snapshot));
+        emit recievedState();
+    }
+
+    _hasNext = fetchNext();
+    if (!_hasNext) {
+        _playing = false;
+        emit finished();
+    }
+}
+
+void Smriti::scheduleNext()
+{
+    if (!_playing || !_hasNext) {
+        return;
+    }
+    if (_speed <= 0) {
+        // as fast as possible, but give the event loop a chance to draw in between
+        _timer.start(0);
+        return;
+    }
+    const qint64 due = _clockStart + qint64((_next.time() - _recordStart) / _speed);
+    const qint64 wait = due - _clock.nsecsElapsed();
+    _timer.start(int(std::max<qint64>(0, (wait + 999999) / 1000000)));
+}
+
+void Smriti::emitDuePackets()
+{
+    if (!_playing) {
+        return;
+    }
+    if (_speed <= 0) {
+        emitNext();
+    } else {
+        // emit everything that is due, a slow consumer must not slow down the replay clock
+        const qint64 replayTime = _recordStart + qint64((_clock.nsecsElapsed() - _clockStart) * _speed);
+        while (_playing && _hasNext && _next.time() <= replayTime) {
+            emitNext();
+        }
+    }
+    scheduleNext();
+}
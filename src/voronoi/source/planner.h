@@ -1,15 +1,10 @@
 #ifndef Planner_H
 #define Planner_H
-#include <GL/glew.h> // Include the GLEW header file
 #include <vector>
-#include <GL/glut.h> // Include the GLUT header file
 #include <iostream>
 #include <math.h>
 #include "Graph.h"
-#include <QObject>
-#include <QWidget>
-#include <QGraphicsView>
-#include <QGraphicsEllipseItem>
+#include <QPointF>
 #include <QDebug>
 #include "Voronoi.h"
 #include "VPoint.h"
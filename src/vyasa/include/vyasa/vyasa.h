@@ -11,16 +11,63 @@
 #ifndef VYASA_H
 #define VYASA_H
 
+#include "core/worldsnapshot.h"
+#include <QByteArray>
+#include <QHostAddress>
 #include <QObject>
-#include <QUdpSocket>
 #include <QString>
-#include <QNetworkDatagram>
+#include <QThread>
+#include <QUdpSocket>
+#include <atomic>
+
+/**
+ * @class VyasaReceiver
+ * @brief Owns the vision socket, lives in the receive thread of Vyasa.
+ * Every datagram is parsed once into a WorldSnapshot which is published through the slot.
+ */
+
+class VyasaReceiver: public QObject {
+    Q_OBJECT
+    public:
+        /**
+        * @param snapshots Slot the snapshots are published to
+        * @param pending Set while a notification is on its way, bursts of packets only cause one
+        */
+        VyasaReceiver(WorldSnapshotSlot* snapshots, std::atomic<bool>* pending);
+
+    signals:
+        /// @brief Emitted after a new snapshot was published and pending was not yet set
+        void updated();
+
+    public slots:
+        /**
+        * @brief (Re)binds the socket, creates it on first use so it belongs to the receive thread
+        * @param address The address to listen on
+        * @param port The port number to listen on
+        */
+        void bind(const QHostAddress& address, quint16 port);
+        /// @brief Reads all pending datagrams, only the snapshot of the last one is left in the slot
+        void handleDatagrams();
+        /**
+        * @brief Logs an error if the socket fails to connect.
+        * @param socketError The error code from the socket
+        */
+        void onSocketError(QAbstractSocket::SocketError socketError);
+
+    private:
+        WorldSnapshotSlot* snapshots;
+        std::atomic<bool>* pending;
+        WorldSnapshotBuilder builder;
+        QUdpSocket* socket = nullptr;
+        QByteArray buffer; // reused for every datagram
+};
 
 /**
  * @class Vyasa
  * @brief The Vyasa class is the intermediary between the backend and frontend of the simulator.
- * It handles the communication with the SSL-Vision and processes the data received as QByteArray.
- * It also uses QUdpSocket to listen for incoming datagrams and emits a signal when data is received.
+ * It listens for SSL-Vision datagrams on its own thread and parses each of them once into an
+ * immutable WorldSnapshot. Consumers take the latest snapshot from snapshots() whenever
+ * recievedState is emitted, so they never share a buffer with the receiver and never block it.
  */
 
 class Vyasa: public QObject {
@@ -28,46 +75,39 @@ class Vyasa: public QObject {
     public:
         /**
         * @brief Constructor for Vyasa
-        * Initializes the parent class of QObject to a null pointer and creates a QUdpSocket.
+        * Starts the receive thread and binds to the simulated vision port.
         */
         explicit Vyasa(QObject* parent = 0);
         ~Vyasa();
-        // todo : add the receiver part to vyasa
 
         /**
-        * @brief Sets the port and address for the QUdpSocket
+        * @brief Rebinds the socket
         * @param port The port number to listen on
         * @param address The address to listen on
         */
         void setPortAndAddress(int port, const QString& address);
         // void sendCommand(float velX, int id);
 
+        /// @brief Latest snapshot, may be read from any thread
+        const WorldSnapshotSlot& snapshots() const { return _snapshots; }
+
     signals:
         /**
-        * @brief Signal emitted when data is received from the socket
-        * @param Buffer a pointer to the QByteArray containing the data
-        * This signal is emitted when data is received from the socket.
+        * @brief Emitted in the thread of Vyasa after a new snapshot was published
+        * Packets which arrive before the signal is handled are merged into the same
+        * snapshot, consumers only ever see the latest one.
         */
-        void recievedState(QByteArray *buffer);
+        void recievedState();
 
-    public slots:
-        /**
-        * @brief Handles incoming datagrams from the socket
-        * This slot is called when data is received from the socket.
-        * It processes the data and emits the recievedState signal.
-        */
-        void handleDatagrams();
-        /**
-        * @brief Logs an error if the socket fails to connect.
-        * @param socketError The error code from the socket
-        */
-        void onSocketError(QAbstractSocket::SocketError socketError);
+    private slots:
+        void notify();
 
     private:
         QHostAddress _addr; //address to listen to for ssl-vision data
         quint16 _port; //port to listen to for ssl-vision data
-        QUdpSocket* socket;
-        QNetworkDatagram datagram;
-        QByteArray buffer;
+        WorldSnapshotSlot _snapshots;
+        std::atomic<bool> _pending{false};
+        QThread receiver_thread;
+        VyasaReceiver* receiver;
 };
 #endif // VYASA_H
@@ -1,48 +1,100 @@
 #include "vyasa.h"
 #include "core/sslprotocols.h"
+#include "core/timer.h"
 // #include "protobuf/ssl_wrapper.pb.h"
 // #include "protobuf/sslsim.h"
+#include <QDebug>
 #include <QString>
 #include <QUdpSocket>
-#include <QNetworkDatagram>
 #define LOG qDebug() << "[vyasa] : "
 
-Vyasa::Vyasa(QObject* parent) : QObject(parent), socket(new QUdpSocket(this))
+VyasaReceiver::VyasaReceiver(WorldSnapshotSlot* snapshots, std::atomic<bool>* pending) :
+    snapshots(snapshots), pending(pending)
 {
-    // create a QUDP socket
-    this->_addr.setAddress(SSL_VISION_ADDRESS_LOCALHOST);
-    this->_port = quint16(SSL_SIMULATED_VISION_PORT);
+}
 
-    // if socket fails to connect
-    connect(socket, &QAbstractSocket::errorOccurred,this, &Vyasa::onSocketError);
+void VyasaReceiver::bind(const QHostAddress& address, quint16 port)
+{
+    if (socket == nullptr) {
+        // created here so that the socket notifier runs in the receive thread
+        socket = new QUdpSocket(this);
+        // if socket fails to connect
+        connect(socket, &QAbstractSocket::errorOccurred, this, &VyasaReceiver::onSocketError);
+        // new syntax, do not use SIGNAL() and SLOT()
+        auto success = connect(socket, &QUdpSocket::readyRead, this, &VyasaReceiver::handleDatagrams);
+        if(!success){
+            LOG << socket->errorString();
+        }
+    }
+    socket->close();
 
     //the problem is with qudpsocket since the slot is being called fine
-    socket->bind(_addr, _port, QUdpSocket::ShareAddress | QUdpSocket::ReuseAddressHint);
+    socket->bind(address, port, QUdpSocket::ShareAddress | QUdpSocket::ReuseAddressHint);
     if(socket->state() != QAbstractSocket::BoundState){
         LOG << "socket not bound";
     }
+}
 
-    // new syntax, do not use SIGNAL() and SLOT()
-    auto success = connect(socket, &QUdpSocket::readyRead, this, &Vyasa::handleDatagrams);
-    if(!success){
-        LOG << socket->errorString();
+void VyasaReceiver::onSocketError(QAbstractSocket::SocketError socketError)
+{
+    LOG<<"socket error occured and the error is : "<<socketError;
+}
+
+void VyasaReceiver::handleDatagrams()
+{
+// when data comes in
+    bool published = false;
+    while(socket->hasPendingDatagrams()){
+        buffer.resize(int(socket->pendingDatagramSize()));
+        const qint64 size = socket->readDatagram(buffer.data(), buffer.size());
+        if (size < 0) {
+            continue;
+        }
+        WorldSnapshotPtr snapshot = builder.addPacket(buffer.constData(), int(size), Timer::systemTime());
+        if (snapshot) {
+            snapshots->store(std::move(snapshot));
+            published = true;
+        }
+    }
+    if (published && !pending->exchange(true)) {
+        emit updated();
     }
 }
 
-Vyasa::~Vyasa()
+Vyasa::Vyasa(QObject* parent) : QObject(parent), receiver(new VyasaReceiver(&_snapshots, &_pending))
 {
-    delete socket;
+    this->_addr.setAddress(SSL_VISION_ADDRESS_LOCALHOST);
+    this->_port = quint16(SSL_SIMULATED_VISION_PORT);
+
+    // parsing happens in the receive thread, consumers only pick up the result
+    receiver->moveToThread(&receiver_thread);
+    connect(&receiver_thread, &QThread::finished, receiver, &QObject::deleteLater);
+    connect(receiver, &VyasaReceiver::updated, this, &Vyasa::notify);
+    receiver_thread.setObjectName("vyasa");
+    receiver_thread.start();
+    setPortAndAddress(_port, _addr.toString());
 }
 
-void Vyasa::onSocketError(QAbstractSocket::SocketError socketError)
+Vyasa::~Vyasa()
 {
-    LOG<<"socket error occured and the error is : "<<socketError;
+    receiver_thread.quit();
+    receiver_thread.wait();
 }
 
 void Vyasa::setPortAndAddress(int port, const QString& address)
 {
     this->_port = quint16(port);
     this->_addr.setAddress(address);
+    // the socket belongs to the receive thread, bind it there
+    VyasaReceiver* r = receiver;
+    QMetaObject::invokeMethod(r, [r, addr = _addr, port = _port]() { r->bind(addr, port); });
+}
+
+void Vyasa::notify()
+{
+    // clear first, a packet arriving while the consumers run triggers the next notification
+    _pending.store(false);
+    emit recievedState();
 }
 
 // void Vyasa::sendCommand(float velX, int id) {
@@ -67,13 +119,3 @@ void Vyasa::setPortAndAddress(int port, const QString& address)
 //         qDebug("send data");
 //     }
 // }
-
-void Vyasa::handleDatagrams()
-{
-// when data comes in
-    while(socket->hasPendingDatagrams()){
-        datagram = socket->receiveDatagram();
-        buffer = datagram.data();
-        emit recievedState(&buffer);
-    }
-}
@@ -0,0 +1,59 @@
+#ifndef MANTRIMAP_H
+#define MANTRIMAP_H
+/**
+ * @file mantrimap.h
+ * @brief Defines the heatmap
+ *
+ * This file contains the layer which draws the advice of the Mantri, a heatmap over the field
+ */
+#include <QGraphicsItem>
+#include <QImage>
+#include <vector>
+
+/**
+ * @class MantriMap
+ * @brief A heatmap drawn as a single graphics item
+ *
+ * The map holds a grid of intensities, one per cell. refresh maps all of them to colours in one pass
+ * into an image with one pixel per cell, which is scaled onto the field when painting.
+ * Negative intensities are blue, positive ones yellow, the shade gets darker towards -200 and 200.
+ */
+class MantriMap : public QGraphicsItem {
+public:
+    /**
+     * @brief Creates a map with all intensities at 0
+     * @param columns Number of cells along the x axis of the scene
+     * @param rows Number of cells along the y axis of the scene
+     * @param rect Area of the scene which is covered by the cells
+     */
+    MantriMap(int columns, int rows, const QRectF &rect);
+
+    int columns() const { return columns_; }
+    int rows() const { return rows_; }
+    /**
+     * @brief Intensities of all cells, row by row
+     * @return Pointer to rows * columns values, call refresh after changing them
+     */
+    float *values() { return grid.data(); }
+    const float *values() const { return grid.data(); }
+    float &value(int column, int row) { return grid[row * columns_ + column]; }
+
+    /**
+     * @brief Maps the intensities to colours and schedules a repaint
+     */
+    void refresh();
+
+    QRectF boundingRect() const override { return rect; }
+    /**
+     * @brief Draws the whole grid as one scaled image
+     */
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget = nullptr) override;
+
+private:
+    int columns_, rows_;
+    QRectF rect;
+    std::vector<float> grid;
+    QImage image;
+};
+
+#endif // MANTRIMAP_H
@@ -28,14 +28,13 @@ public:
      */
     BlueBot(){};
     /**
-     * @brief Makes the bot's structure (physical aspects) and adds the hotmaps for the bot
-     * @param *scene The pointer referring to the larger scene
-     * @param *scene_hotmap The pointer referring to the large scene's hotmap
+     * @brief Makes the bot's structure (physical aspects) and adds it to the scene
+     * @param *scene The pointer referring to the scene
      * @param &&point Refers to the adress of the adress of the point
      * @param orientation Refers to the orientation that the bot has to take
      * @param id Refers to the bot's id
      */
-    BlueBot(QGraphicsScene *scene, QGraphicsScene *scene_hotmap, QPointF &&point, float orientation,int id);
+    BlueBot(QGraphicsScene *scene, QPointF &&point, float orientation,int id);
     /**
      * @brief Gets the x value of the bot
      * @return Returns the x position of the bot
@@ -106,10 +105,10 @@ private:
         void mouseMoveEvent(QGraphicsSceneMouseEvent *event) override;
     };
     /**
-     * Typedefs of x,y and orientation along with initialzation of the body_graphics and its hotmap to nullptr
+     * Typedefs of x,y and orientation along with initialzation of the body_graphics to nullptr
      */
     float x, y, orientation;
-    BlueBotGraphics *body_graphics=nullptr, *body_graphics_hotmap=nullptr;
+    BlueBotGraphics *body_graphics=nullptr;
 
 };
 
@@ -133,7 +132,7 @@ signals:
 class YellowBot{
     public:
         YellowBot(){};
-        YellowBot(QGraphicsScene *scene, QGraphicsScene *scene_hotmap, QPointF &&point, float orientation,int id);
+        YellowBot(QGraphicsScene *scene, QPointF &&point, float orientation,int id);
         float getx(){ return x; }
         float gety(){ return y; }
         QPointF mapFromScene(float x, float y){ return body_graphics->mapFromScene(x, y); }
@@ -165,7 +164,7 @@ class YellowBot{
             int controllerIndex = -1;
             void handleGamepadInput();
         };
-        YellowBotGraphics *body_graphics, *body_graphics_hotmap=nullptr;
+        YellowBotGraphics *body_graphics=nullptr;
         float x, y, orientation;
 };
 
@@ -183,10 +182,9 @@ public:
      * @param radius Refers to the radius
      * @param pos Refers to the position
      * @param *scene Refers to the value of the pointer scene
-     * @param *scene_hotmap Refers to the value of the pointer scene_hotmap
      */
     Ball(QColor color, float radius);
-    Ball(QPointF pos, QGraphicsScene *scene, QGraphicsScene *scene_hotmap);
+    Ball(QPointF pos, QGraphicsScene *scene);
 
     /**
      * @brief Function to update the position of the ball
@@ -226,8 +224,7 @@ private:
         void mousePressEvent(QGraphicsSceneMouseEvent *event) override;
     };
 
-    BallGraphics *graphics = nullptr;  // For regular scene
-    BallGraphics *graphics_hotmap = nullptr;  // For hotmap scene
+    BallGraphics *graphics = nullptr;
 };
 
 
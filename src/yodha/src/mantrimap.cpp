@@ -0,0 +1,65 @@
+#include "mantrimap.h"
+#include <QColor>
+#include <QPainter>
+#include <algorithm>
+#include <cmath>
+
+#define MAX_INTENSITY 200
+
+/**
+ * @brief Colours of all integer intensities from -MAX_INTENSITY to MAX_INTENSITY
+ *
+ * Computed once, refresh only has to look them up.
+ */
+static const QRgb *colourTable()
+{
+    static std::vector<QRgb> table = [](){
+        std::vector<QRgb> colours(2*MAX_INTENSITY + 1);
+        for(int i = -MAX_INTENSITY; i <= MAX_INTENSITY; ++i){
+            const QColor base = i <= 0 ? QColor(Qt::blue) : QColor(Qt::yellow);
+            const int value = std::abs(i);
+            // higher value -> darker shade, lower value -> lighter shade
+            const QColor colour = value > 100 ? base.darker(value) : base.lighter(200 - value);
+            colours[i + MAX_INTENSITY] = colour.rgb();
+        }
+        return colours;
+    }();
+    return table.data();
+}
+
+MantriMap::MantriMap(int columns, int rows, const QRectF &rect):
+    columns_(columns),
+    rows_(rows),
+    rect(rect),
+    grid(std::size_t(columns) * rows, 0.0f),
+    image(columns, rows, QImage::Format_RGB32)
+{
+    refresh();
+}
+
+void MantriMap::refresh()
+{
+    const QRgb *colours = colourTable();
+    const float *value = grid.data();
+    for(int row = 0; row < rows_; ++row){
+        QRgb *line = reinterpret_cast<QRgb*>(image.scanLine(row));
+        for(int column = 0; column < columns_; ++column){
+            // NaN would pass the clamp and index outside the table, non finite values are drawn as 0
+            const float finite = std::isfinite(value[column]) ? value[column] : 0.0f;
+            // clamping and rounding are branch free, only the table lookup is a gather
+            const float clamped = std::min(std::max(finite, float(-MAX_INTENSITY)), float(MAX_INTENSITY));
+            line[column] = colours[int(clamped + MAX_INTENSITY + 0.5f)];
+        }
+        value += columns_;
+    }
+    update();
+}
+
+void MantriMap::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    Q_UNUSED(option);
+    Q_UNUSED(widget);
+    // every pixel is one cell, without smoothing the cells stay sharp squares
+    painter->setRenderHint(QPainter::SmoothPixmapTransform, false);
+    painter->drawImage(rect, image);
+}
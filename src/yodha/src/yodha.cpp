@@ -5,8 +5,12 @@
 #include <QPainter>
 #include <QGraphicsSceneMouseEvent>
 #include <QObject>
+#include <cmath>
 #define LOG qDebug() << "[yodha] : "
 #define ROBOT_RADIUS 10
+// moves smaller than this are not drawn, in scene units (cm) and degrees
+#define MIN_MOVE 0.1
+#define MIN_TURN 0.2
 float SUBTEND_ANGLE=30;
 
 bool left_click_mode = true;
@@ -31,7 +35,16 @@ inline QRectF boundingSquare(const QPointF &center, int half_side)
     return QRectF(center.x() - half_side, center.y() - half_side, 2*half_side, 2*half_side);
 }
 
-YellowBot::YellowBot(QGraphicsScene *scene, QGraphicsScene *scene_hotmap, QPointF &&point, float orientation, int id):
+/**
+ * @brief Whether a bot moved enough since it was last drawn to be drawn again
+ */
+inline bool hasMoved(float x, float y, float orientation, const QPointF &point, float new_orientation)
+{
+    return std::abs(point.x() - x) >= MIN_MOVE || std::abs(point.y() - y) >= MIN_MOVE
+        || std::abs(qRadiansToDegrees(std::remainder(new_orientation - orientation, 2*M_PI))) >= MIN_TURN;
+}
+
+YellowBot::YellowBot(QGraphicsScene *scene, QPointF &&point, float orientation, int id):
     id(id),
     x(point.x()),
     y(point.y()),
@@ -47,28 +60,23 @@ YellowBot::YellowBot(QGraphicsScene *scene, QGraphicsScene *scene_hotmap, QPoint
     path.lineTo(ROBOT_RADIUS*cos(qDegreesToRadians(SUBTEND_ANGLE)), -ROBOT_RADIUS*sin(qDegreesToRadians(SUBTEND_ANGLE)));
 
     body_graphics = new YellowBotGraphics(path, id, signalEmitter);
-    body_graphics_hotmap = new YellowBotGraphics(path, id, signalEmitter);
-
+    body_graphics->setPos(point);
     body_graphics->setRotation(qRadiansToDegrees(orientation));
-    body_graphics_hotmap->setRotation(qRadiansToDegrees(orientation));
 
     scene->addItem(body_graphics);
-    scene_hotmap->addItem(body_graphics_hotmap);
 
     if(scene->mouseGrabberItem() != nullptr)
         LOG << "mouse accepted";
 }
 void YellowBot::updatePosition(const QPointF &&point, float orientation)
 {
+    if(!hasMoved(x, y, this->orientation, point, orientation)) return;
     x = point.x();
     y = point.y();
     this->orientation = orientation;
     //sets the robot at location point with radius and color
     body_graphics->setPos(point);
     body_graphics->setRotation(qRadiansToDegrees(orientation));
-
-    body_graphics_hotmap->setPos(point);
-    body_graphics_hotmap->setRotation(qRadiansToDegrees(orientation));
     return;
 }
 
@@ -250,7 +258,7 @@ void YellowBot::YellowBotGraphics::mouseMoveEvent(QGraphicsSceneMouseEvent *even
     else temp.move_one_bot(id, transformFromScene(mapToScene(event->lastPos())), false, false);
 
 }
-BlueBot::BlueBot(QGraphicsScene *scene, QGraphicsScene *scene_hotmap, QPointF &&point, float orientation, int id):
+BlueBot::BlueBot(QGraphicsScene *scene, QPointF &&point, float orientation, int id):
     id(id),
     x(point.x()),
     y(point.y()),
@@ -265,26 +273,21 @@ BlueBot::BlueBot(QGraphicsScene *scene, QGraphicsScene *scene_hotmap, QPointF &&
     path.lineTo(ROBOT_RADIUS*cos(qDegreesToRadians(SUBTEND_ANGLE)), -ROBOT_RADIUS*sin(qDegreesToRadians(SUBTEND_ANGLE)));
 
     body_graphics = new BlueBotGraphics(path, id);
+    body_graphics->setPos(point);
     body_graphics->setRotation(qRadiansToDegrees(orientation));
 
-    body_graphics_hotmap = new BlueBotGraphics(path, id);
-    body_graphics_hotmap->setRotation(qRadiansToDegrees(orientation));
-
     scene->addItem(body_graphics);
-    scene_hotmap->addItem(body_graphics_hotmap);
 
 }
 void BlueBot::updatePosition(const QPointF &&point, float orientation)
 {
+    if(!hasMoved(x, y, this->orientation, point, orientation)) return;
     x = point.x();
     y = point.y();
     this->orientation = orientation;
     //sets the robot at location point with radius and color
     body_graphics->setPos(point);
     body_graphics->setRotation(qRadiansToDegrees(orientation));
-
-    body_graphics_hotmap->setPos(point);
-    body_graphics_hotmap->setRotation(qRadiansToDegrees(orientation));
     return;
 }
 
@@ -335,7 +338,7 @@ Ball::Ball(QColor color, float radius):
     radius(radius)
 {}
 
-Ball::Ball(QPointF pos, QGraphicsScene *scene, QGraphicsScene *scene_hotmap):
+Ball::Ball(QPointF pos, QGraphicsScene *scene):
     position(pos),
     color(Qt::black),
     radius(5)
@@ -344,21 +347,17 @@ Ball::Ball(QPointF pos, QGraphicsScene *scene, QGraphicsScene *scene_hotmap):
     QRectF bounding_rect = QRectF(pos.x() - radius, pos.y() - radius, 2*radius, 2*radius);
     graphics = new BallGraphics();
     graphics->setRect(bounding_rect); // Set bounding rect for the ball's appearance in the scene
-    scene->addItem(graphics);  // Add to the regular scene
-
-    graphics_hotmap = new BallGraphics();
-    graphics_hotmap->setRect(bounding_rect);  // Set bounding rect for hotmap appearance
-    scene_hotmap->addItem(graphics_hotmap);
+    scene->addItem(graphics);
 }
 
 void Ball::updatePosition(QPointF pos)
 {
-    if(graphics == nullptr || graphics_hotmap == nullptr){
+    if(graphics == nullptr){
         throw std::invalid_argument("ball not added to scene!");
     }
+    if(std::abs(pos.x() - position.x()) < MIN_MOVE && std::abs(pos.y() - position.y()) < MIN_MOVE) return;
     position = pos;
     graphics->setRect(boundingSquare(pos, radius));
-    graphics_hotmap->setRect(boundingSquare(pos, radius));
 }
 
 void Ball::BallGraphics::mouseMoveEvent(QGraphicsSceneMouseEvent *event){